@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <span>
+#include <string>
+
+#include <histogram.hpp>
+
+// Capture files are a header followed by 8-byte aligned records and end at the first record
+// of type none, the rest of a preallocated file is zero. Timestamps are steady clock
+// nanoseconds, which all workers of one process share.
+enum class capture_record_type : uint32_t
+{
+    none,
+    session_open,
+    client_to_server,
+    server_to_client,
+    session_close
+};
+
+struct capture_file_header
+{
+    constexpr static std::array<char, 8> expectedMagic{'P', 'X', 'Y', 'C', 'A', 'P', '0', '1'};
+
+    std::array<char, 8> magic;
+    uint64_t createdAt;
+};
+
+struct capture_record_header
+{
+    capture_record_type type;
+    // Bytes the session read, the payload holds them unless payloads are not captured.
+    uint32_t length;
+    uint64_t session;
+    int64_t timestamp;
+    uint32_t payloadLength;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(capture_record_header) == 32);
+
+struct capture_options
+{
+    // Files are named capture-<worker>-<sequence>.bin.
+    std::string directory = ".";
+    // Preallocated size of each file, a full file is truncated to its records and the next one started.
+    size_t fileSize = 256 * 1024 * 1024;
+    // Stop after this many files per worker, zero for no limit.
+    size_t maxFiles = 16;
+    // Only lengths and timing are recorded when false.
+    bool payloads = true;
+};
+
+// Appends records to memory-mapped capture files of one worker. A record is a copy into the
+// mapping; system calls only happen when a file fills up and the next one is created. Windows
+// writes through a buffered stream instead.
+class capture_writer
+{
+private:
+    capture_options _options;
+    size_t _worker;
+    size_t _sequence{0};
+#if defined(_WIN32)
+    std::FILE* _stream{};
+#else
+    int _file{-1};
+    char* _mapping{};
+#endif
+    size_t _used{0};
+    local_counter _droppedRecords;
+    bool _exhausted{false};
+public:
+    capture_writer(const capture_options& options, size_t worker);
+    capture_writer(const capture_writer& other) = delete;
+    capture_writer& operator=(const capture_writer& other) = delete;
+    ~capture_writer();
+public:
+    void record(capture_record_type type, uint64_t session, std::chrono::steady_clock::time_point time, std::span<const char> data = {});
+    // Records not written because the file limit was reached or a new file could not be created.
+    [[nodiscard]] inline uint64_t droppedRecords() const noexcept
+    {
+        return _droppedRecords.load();
+    }
+private:
+    [[nodiscard]] bool fileOpen() const noexcept;
+    void openFile();
+    void closeFile() noexcept;
+};
+
+// Read-only view of a capture file, records point into the mapping. Windows reads the whole
+// file into memory instead.
+class capture_reader
+{
+public:
+    struct record
+    {
+        capture_record_header header;
+        std::span<const char> payload;
+    };
+private:
+#if defined(_WIN32)
+    std::unique_ptr<char[]> _contents;
+#else
+    int _file{-1};
+#endif
+    const char* _mapping{};
+    size_t _size{0};
+    size_t _offset{sizeof(capture_file_header)};
+public:
+    explicit capture_reader(const std::string& path);
+    capture_reader(const capture_reader& other) = delete;
+    capture_reader& operator=(const capture_reader& other) = delete;
+    capture_reader(capture_reader&& other) noexcept;
+    ~capture_reader();
+public:
+    // Returns false at the end of the records; throws on a malformed file.
+    bool next(record& out);
+};
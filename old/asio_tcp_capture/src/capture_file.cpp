@@ -0,0 +1,295 @@
+#include <capture_file.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#if defined(_WIN32)
+#include <filesystem>
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // Reads are at most the largest buffer size class, so a record always fits a fresh file.
+    constexpr size_t minFileSize = 16 * 1024 * 1024;
+    constexpr size_t recordAlignment = 8;
+
+    size_t record_size(size_t payloadLength) noexcept
+    {
+        return (sizeof(capture_record_header) + payloadLength + recordAlignment - 1) / recordAlignment * recordAlignment;
+    }
+
+    [[noreturn]] void throw_errno(int error, std::string_view what, const std::string& path)
+    {
+        throw std::system_error(error, std::generic_category(), std::format("{} {}", what, path));
+    }
+}
+
+capture_writer::capture_writer(const capture_options& options, size_t worker)
+    : _options(options)
+    , _worker(worker)
+{
+    _options.fileSize = std::max(_options.fileSize, minFileSize);
+    openFile();
+}
+
+capture_writer::~capture_writer()
+{
+    closeFile();
+}
+
+void capture_writer::record(capture_record_type type, uint64_t session, std::chrono::steady_clock::time_point time, std::span<const char> data)
+{
+    const auto payloadLength = _options.payloads ? data.size() : 0;
+    const auto size = record_size(payloadLength);
+
+    if(fileOpen() && _used + size > _options.fileSize)
+    {
+        closeFile();
+        _exhausted = _options.maxFiles != 0 && _sequence >= _options.maxFiles;
+
+        try
+        {
+            if(!_exhausted)
+                openFile();
+        }
+        catch (const std::exception&)
+        {
+            _exhausted = true;
+        }
+    }
+
+    if(_exhausted || !fileOpen())
+    {
+        _droppedRecords.add();
+        return;
+    }
+
+    const capture_record_header header{
+        type,
+        static_cast<uint32_t>(data.size()),
+        session,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count(),
+        static_cast<uint32_t>(payloadLength),
+        0
+    };
+
+#if defined(_WIN32)
+    constexpr std::array<char, recordAlignment> padding{};
+    std::fwrite(&header, sizeof(header), 1, _stream);
+    std::fwrite(data.data(), 1, payloadLength, _stream);
+    std::fwrite(padding.data(), 1, size - sizeof(header) - payloadLength, _stream);
+#else
+    auto* out = _mapping + _used;
+    std::memcpy(out, &header, sizeof(header));
+    if(payloadLength != 0)
+        std::memcpy(out + sizeof(header), data.data(), payloadLength);
+#endif
+    _used += size;
+}
+
+#if defined(_WIN32)
+
+bool capture_writer::fileOpen() const noexcept
+{
+    return _stream != nullptr;
+}
+
+void capture_writer::openFile()
+{
+    const auto path = std::format("{}/capture-{}-{}.bin", _options.directory, _worker, _sequence++);
+
+    auto* stream = std::fopen(path.c_str(), "wb");
+    if(stream == nullptr)
+        throw_errno(errno, "Failed to create", path);
+    std::setvbuf(stream, nullptr, _IOFBF, 1024 * 1024);
+    _stream = stream;
+
+    const capture_file_header header{
+        capture_file_header::expectedMagic,
+        static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count())
+    };
+    std::fwrite(&header, sizeof(header), 1, _stream);
+    _used = sizeof(header);
+}
+
+void capture_writer::closeFile() noexcept
+{
+    if(_stream == nullptr)
+        return;
+
+    std::fclose(_stream);
+    _stream = nullptr;
+}
+
+#else
+
+bool capture_writer::fileOpen() const noexcept
+{
+    return _file != -1;
+}
+
+void capture_writer::openFile()
+{
+    const auto path = std::format("{}/capture-{}-{}.bin", _options.directory, _worker, _sequence++);
+
+    const auto file = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(file == -1)
+        throw_errno(errno, "Failed to create", path);
+
+    // Allocating the blocks up front keeps page faults on the mapping from having to.
+    if(const auto error = ::posix_fallocate(file, 0, static_cast<off_t>(_options.fileSize)); error != 0 && ::ftruncate(file, static_cast<off_t>(_options.fileSize)) != 0)
+    {
+        ::close(file);
+        throw_errno(error, "Failed to allocate", path);
+    }
+
+    auto* mapping = ::mmap(nullptr, _options.fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if(mapping == MAP_FAILED)
+    {
+        const auto error = errno;
+        ::close(file);
+        throw_errno(error, "Failed to map", path);
+    }
+    ::madvise(mapping, _options.fileSize, MADV_SEQUENTIAL);
+
+    _file = file;
+    _mapping = static_cast<char*>(mapping);
+
+    const capture_file_header header{
+        capture_file_header::expectedMagic,
+        static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count())
+    };
+    std::memcpy(_mapping, &header, sizeof(header));
+    _used = sizeof(header);
+}
+
+void capture_writer::closeFile() noexcept
+{
+    if(_file == -1)
+        return;
+
+    ::munmap(_mapping, _options.fileSize);
+    [[maybe_unused]] const auto truncated = ::ftruncate(_file, static_cast<off_t>(_used));
+    ::close(_file);
+
+    _file = -1;
+    _mapping = nullptr;
+}
+
+#endif
+
+//----------------------------------------------------------------------
+
+#if defined(_WIN32)
+
+capture_reader::capture_reader(const std::string& path)
+{
+    std::ifstream stream(path, std::ios::binary);
+    if(!stream)
+        throw std::runtime_error(std::format("Failed to open {}", path));
+
+    _size = static_cast<size_t>(std::filesystem::file_size(path));
+    _contents = std::make_unique_for_overwrite<char[]>(_size);
+    if(!stream.read(_contents.get(), static_cast<std::streamsize>(_size)))
+        throw std::runtime_error(std::format("Failed to read {}", path));
+    _mapping = _contents.get();
+
+    capture_file_header header{};
+    if(_size >= sizeof(header))
+        std::memcpy(&header, _mapping, sizeof(header));
+    if(_size < sizeof(header) || header.magic != capture_file_header::expectedMagic)
+        throw std::runtime_error(std::format("{} is not a capture file", path));
+}
+
+capture_reader::capture_reader(capture_reader&& other) noexcept
+    : _contents(std::move(other._contents))
+    , _mapping(std::exchange(other._mapping, nullptr))
+    , _size(std::exchange(other._size, 0))
+    , _offset(other._offset)
+{
+}
+
+capture_reader::~capture_reader() = default;
+
+#else
+
+capture_reader::capture_reader(const std::string& path)
+{
+    _file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(_file == -1)
+        throw_errno(errno, "Failed to open", path);
+
+    struct stat status{};
+    if(::fstat(_file, &status) != 0)
+    {
+        const auto error = errno;
+        ::close(_file);
+        throw_errno(error, "Failed to stat", path);
+    }
+    _size = static_cast<size_t>(status.st_size);
+
+    capture_file_header header{};
+    if(_size >= sizeof(header))
+    {
+        auto* mapping = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _file, 0);
+        if(mapping != MAP_FAILED)
+        {
+            _mapping = static_cast<const char*>(mapping);
+            std::memcpy(&header, _mapping, sizeof(header));
+        }
+    }
+
+    if(_mapping == nullptr || header.magic != capture_file_header::expectedMagic)
+    {
+        if(_mapping != nullptr)
+            ::munmap(const_cast<char*>(_mapping), _size);
+        ::close(_file);
+        throw std::runtime_error(std::format("{} is not a capture file", path));
+    }
+}
+
+capture_reader::capture_reader(capture_reader&& other) noexcept
+    : _file(std::exchange(other._file, -1))
+    , _mapping(std::exchange(other._mapping, nullptr))
+    , _size(std::exchange(other._size, 0))
+    , _offset(other._offset)
+{
+}
+
+capture_reader::~capture_reader()
+{
+    if(_mapping != nullptr)
+        ::munmap(const_cast<char*>(_mapping), _size);
+    if(_file != -1)
+        ::close(_file);
+}
+
+#endif
+
+bool capture_reader::next(record& out)
+{
+    if(_offset + sizeof(capture_record_header) > _size)
+        return false;
+
+    std::memcpy(&out.header, _mapping + _offset, sizeof(capture_record_header));
+    if(out.header.type == capture_record_type::none)
+        return false;
+
+    if(out.header.type > capture_record_type::session_close || out.header.payloadLength > out.header.length || _offset + record_size(out.header.payloadLength) > _size)
+        throw std::runtime_error("Malformed capture record");
+
+    out.payload = {_mapping + _offset + sizeof(capture_record_header), out.header.payloadLength};
+    _offset += record_size(out.header.payloadLength);
+    return true;
+}
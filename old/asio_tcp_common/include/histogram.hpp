@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Counter with a single writing thread and any number of readers. Updates are a relaxed
+// load and store instead of a locked read-modify-write.
+class local_counter
+{
+private:
+    std::atomic<uint64_t> _value{0};
+public:
+    inline void add(uint64_t value = 1) noexcept
+    {
+        _value.store(_value.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+    [[nodiscard]] inline uint64_t load() const noexcept
+    {
+        return _value.load(std::memory_order_relaxed);
+    }
+};
+
+class histogram_snapshot;
+
+// Log-linear histogram in the style of HdrHistogram: values below 2^subBucketBits are exact,
+// larger ones fall into 2^(subBucketBits-1) linear sub-buckets per power of two, which
+// bounds the relative error at 1/64. Values are nanoseconds up to about 4.8 hours.
+// Like local_counter, it has a single writing thread.
+class latency_histogram
+{
+    friend class histogram_snapshot;
+public:
+    constexpr static size_t subBucketBits = 7;
+    constexpr static size_t valueBits = 44;
+    constexpr static size_t subBucketCount = size_t{1} << subBucketBits;
+    constexpr static size_t subBucketHalfCount = subBucketCount / 2;
+    constexpr static size_t bucketCount = subBucketCount + (valueBits - subBucketBits) * subBucketHalfCount;
+    constexpr static uint64_t maxValue = (uint64_t{1} << valueBits) - 1;
+private:
+    std::array<local_counter, bucketCount> _counts{};
+public:
+    [[nodiscard]] constexpr static size_t bucketIndex(uint64_t value) noexcept
+    {
+        value = std::min(value, maxValue);
+        if(value < subBucketCount)
+            return static_cast<size_t>(value);
+
+        const auto shift = static_cast<size_t>(std::bit_width(value)) - subBucketBits;
+        const auto top = static_cast<size_t>(value >> shift);
+        return subBucketCount + (shift - 1) * subBucketHalfCount + (top - subBucketHalfCount);
+    }
+    // Upper bound of the values that fall into the bucket.
+    [[nodiscard]] constexpr static uint64_t bucketValue(size_t index) noexcept
+    {
+        if(index < subBucketCount)
+            return index;
+
+        const auto shift = (index - subBucketCount) / subBucketHalfCount + 1;
+        const auto top = (index - subBucketCount) % subBucketHalfCount + subBucketHalfCount;
+        return ((static_cast<uint64_t>(top) + 1) << shift) - 1;
+    }
+public:
+    inline void record(uint64_t value) noexcept
+    {
+        _counts[bucketIndex(value)].add();
+    }
+    inline void record(std::chrono::nanoseconds value) noexcept
+    {
+        record(static_cast<uint64_t>(std::max<std::chrono::nanoseconds::rep>(value.count(), 0)));
+    }
+};
+
+static_assert(latency_histogram::bucketIndex(latency_histogram::maxValue) == latency_histogram::bucketCount - 1);
+
+// Plain, mergeable copy of one or more histograms taken at scrape time.
+class histogram_snapshot
+{
+private:
+    std::array<uint64_t, latency_histogram::bucketCount> _counts{};
+    uint64_t _totalCount{0};
+public:
+    inline void merge(const latency_histogram& histogram) noexcept
+    {
+        for(size_t index = 0; index < latency_histogram::bucketCount; ++index)
+        {
+            const auto count = histogram._counts[index].load();
+            _counts[index] += count;
+            _totalCount += count;
+        }
+    }
+    inline void merge(const histogram_snapshot& snapshot) noexcept
+    {
+        for(size_t index = 0; index < latency_histogram::bucketCount; ++index)
+            _counts[index] += snapshot._counts[index];
+        _totalCount += snapshot._totalCount;
+    }
+    inline void record(uint64_t value) noexcept
+    {
+        ++_counts[latency_histogram::bucketIndex(value)];
+        ++_totalCount;
+    }
+public:
+    [[nodiscard]] inline uint64_t count() const noexcept
+    {
+        return _totalCount;
+    }
+    [[nodiscard]] inline uint64_t percentile(double percentile) const noexcept
+    {
+        if(_totalCount == 0)
+            return 0;
+
+        const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(_totalCount) + 0.5));
+        uint64_t seen = 0;
+        for(size_t index = 0; index < latency_histogram::bucketCount; ++index)
+        {
+            seen += _counts[index];
+            if(seen >= rank)
+                return latency_histogram::bucketValue(index);
+        }
+        return latency_histogram::maxValue;
+    }
+    [[nodiscard]] inline uint64_t max() const noexcept
+    {
+        for(size_t index = latency_histogram::bucketCount; index != 0; --index)
+        {
+            if(_counts[index - 1] != 0)
+                return latency_histogram::bucketValue(index - 1);
+        }
+        return 0;
+    }
+};
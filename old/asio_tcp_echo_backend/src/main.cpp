@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdlib>
+#include <memory>
+#include <print>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/signal_set.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/write.hpp>
+
+using boost::asio::ip::tcp;
+using boost::asio::awaitable;
+using boost::asio::co_spawn;
+using boost::asio::detached;
+using boost::asio::redirect_error;
+using boost::asio::use_awaitable;
+
+enum class backend_mode
+{
+    echo,
+    sink
+};
+
+struct backend_options
+{
+    uint16_t port = 25565;
+    backend_mode mode = backend_mode::echo;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    bool noDelay = true;
+};
+
+//----------------------------------------------------------------------
+
+awaitable<void> serve(tcp::socket socket, backend_mode mode)
+{
+    std::array<char, 64 * 1024> data;
+    boost::system::error_code error;
+
+    while(true)
+    {
+        const auto bytesRead = co_await socket.async_read_some(boost::asio::buffer(data), redirect_error(use_awaitable, error));
+        if(error)
+            break;
+
+        if(mode == backend_mode::sink)
+            continue;
+
+        co_await boost::asio::async_write(socket, boost::asio::buffer(data, bytesRead), redirect_error(use_awaitable, error));
+        if(error)
+            break;
+    }
+
+    socket.shutdown(tcp::socket::shutdown_send, error);
+}
+
+awaitable<void> listen(std::span<const std::unique_ptr<boost::asio::io_context>> contexts, const backend_options& options)
+{
+    auto& acceptContext = *contexts.front();
+    tcp::acceptor acceptor(acceptContext, {tcp::v4(), options.port});
+    size_t nextContext = 0;
+
+    for (;;)
+    {
+        auto& context = *contexts[nextContext++ % contexts.size()];
+
+        boost::system::error_code error;
+        tcp::socket socket = co_await acceptor.async_accept(context, redirect_error(use_awaitable, error));
+        if(error)
+        {
+            std::print("Failed to accept connection: {}\n", error.message());
+            continue;
+        }
+
+        socket.set_option(tcp::no_delay(options.noDelay), error);
+        co_spawn(context, serve(std::move(socket), options.mode), detached);
+    }
+}
+
+//----------------------------------------------------------------------
+
+bool parse_options(int argc, char* argv[], backend_options& options)
+{
+    for(int argumentIndex = 1; argumentIndex < argc; ++argumentIndex)
+    {
+        const std::string_view argument = argv[argumentIndex];
+        const std::string_view value = argumentIndex + 1 < argc ? argv[argumentIndex + 1] : "";
+
+        const auto parseNumber = [&](auto& number){
+            ++argumentIndex;
+            return std::from_chars(value.data(), value.data() + value.size(), number).ec == std::errc{};
+        };
+
+        if(argument == "--port")
+        {
+            if(!parseNumber(options.port))
+                return false;
+        }
+        else if(argument == "--threads")
+        {
+            if(!parseNumber(options.threads) || options.threads == 0)
+                return false;
+        }
+        else if(argument == "--sink")
+        {
+            options.mode = backend_mode::sink;
+        }
+        else if(argument == "--no-nodelay")
+        {
+            options.noDelay = false;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    backend_options options;
+    if(!parse_options(argc, argv, options))
+    {
+        std::print("Usage: {} [--port 25565] [--threads N] [--sink] [--no-nodelay]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        std::vector<std::unique_ptr<boost::asio::io_context>> contexts;
+        for(size_t threadIndex = 0; threadIndex < options.threads; ++threadIndex)
+            contexts.push_back(std::make_unique<boost::asio::io_context>(1));
+
+        co_spawn(*contexts.front(), listen(contexts, options), detached);
+
+        boost::asio::signal_set signals(*contexts.front(), SIGINT, SIGTERM);
+        signals.async_wait([&](auto, auto){
+            for(auto& context : contexts)
+                context->stop();
+        });
+
+        std::print(
+            "{} backend listening on port {} with {} threads\n",
+            options.mode == backend_mode::echo ? "Echo" : "Sink", options.port, options.threads
+        );
+
+        std::vector<std::jthread> threads;
+        std::vector<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> workGuards;
+        for(auto& context : contexts)
+            workGuards.push_back(boost::asio::make_work_guard(*context));
+        for(size_t threadIndex = 1; threadIndex < contexts.size(); ++threadIndex)
+            threads.emplace_back([&context = *contexts[threadIndex]]{ context.run(); });
+
+        contexts.front()->run();
+    }
+    catch (const std::exception& exception)
+    {
+        std::print("Backend failed: {}\n", exception.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
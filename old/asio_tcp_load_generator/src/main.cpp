@@ -0,0 +1,523 @@
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <print>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/connect.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/write.hpp>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+#include <histogram.hpp>
+
+using boost::asio::ip::tcp;
+using boost::asio::awaitable;
+using boost::asio::co_spawn;
+using boost::asio::detached;
+using boost::asio::redirect_error;
+using boost::asio::use_awaitable;
+using clock_type = std::chrono::steady_clock;
+
+enum class load_mode
+{
+    // Every connection sends its next message only after the previous one was echoed.
+    closed_loop,
+    // Messages are sent on a fixed schedule regardless of responses; latency is measured from
+    // the intended send time so that stalls are not hidden by coordinated omission.
+    open_loop
+};
+
+struct load_target
+{
+    std::string name;
+    std::string host;
+    std::string port;
+};
+
+struct load_options
+{
+    std::vector<load_target> targets;
+    size_t connections = 100;
+    size_t messageSize = 64;
+    double rate = 0.0;
+    load_mode mode = load_mode::closed_loop;
+    bool sink = false;
+    std::chrono::seconds duration{10};
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::optional<int> proxyPid;
+};
+
+// Written by the thread of a single io_context, merged once the run is over.
+struct thread_statistics
+{
+    latency_histogram connectLatency;
+    latency_histogram messageLatency;
+    local_counter connections;
+    local_counter connectFailures;
+    local_counter messagesSent;
+    local_counter messagesReceived;
+    local_counter bytesSent;
+    local_counter bytesReceived;
+    local_counter errors;
+    std::atomic<clock_type::rep> lastConnectedAt{0};
+};
+
+struct process_usage
+{
+    std::chrono::microseconds cpuTime{0};
+    uint64_t contextSwitches{0};
+    // syscr + syscw from /proc/<pid>/io, unreadable without ptrace access. The kernel counts
+    // read(2)/write(2)-family calls there, including on sockets, but not send/recv/sendmsg/recvmsg.
+    std::optional<uint64_t> systemCalls;
+};
+
+//----------------------------------------------------------------------
+
+namespace
+{
+    constexpr size_t timestampSize = sizeof(clock_type::rep);
+
+    void stamp(std::span<char> message, clock_type::time_point time)
+    {
+        const auto ticks = time.time_since_epoch().count();
+        std::memcpy(message.data(), &ticks, timestampSize);
+    }
+
+    clock_type::time_point read_stamp(std::span<const char> message)
+    {
+        clock_type::rep ticks;
+        std::memcpy(&ticks, message.data(), timestampSize);
+        return clock_type::time_point{clock_type::duration{ticks}};
+    }
+
+    awaitable<void> wait_until(boost::asio::steady_timer& timer, clock_type::time_point time)
+    {
+        boost::system::error_code error;
+        timer.expires_at(time);
+        co_await timer.async_wait(redirect_error(use_awaitable, error));
+    }
+
+    // Shares the socket with the sending coroutine, either may finish first.
+    awaitable<void> receive_open_loop(std::shared_ptr<tcp::socket> socket, const load_options& options, thread_statistics& statistics)
+    {
+        std::vector<char> message(options.messageSize);
+        boost::system::error_code error;
+
+        while(true)
+        {
+            co_await boost::asio::async_read(*socket, boost::asio::buffer(message), redirect_error(use_awaitable, error));
+            if(error)
+                break;
+
+            statistics.messageLatency.record(clock_type::now() - read_stamp(message));
+            statistics.messagesReceived.add();
+            statistics.bytesReceived.add(message.size());
+        }
+    }
+
+    awaitable<void> run_connection(
+        tcp::resolver::results_type endpoints,
+        const load_options& options,
+        thread_statistics& statistics,
+        clock_type::time_point startedAt,
+        clock_type::time_point deadline
+    )
+    {
+        auto executor = co_await boost::asio::this_coro::executor;
+        auto socket = std::make_shared<tcp::socket>(executor);
+        boost::asio::steady_timer timer(executor);
+        boost::system::error_code error;
+
+        const auto connectStartedAt = clock_type::now();
+        co_await boost::asio::async_connect(*socket, endpoints, redirect_error(use_awaitable, error));
+        if(error)
+        {
+            statistics.connectFailures.add();
+            co_return;
+        }
+
+        const auto connectedAt = clock_type::now();
+        statistics.connectLatency.record(connectedAt - connectStartedAt);
+        statistics.connections.add();
+        statistics.lastConnectedAt.store(std::max(statistics.lastConnectedAt.load(std::memory_order_relaxed), (connectedAt - startedAt).count()), std::memory_order_relaxed);
+
+        socket->set_option(tcp::no_delay(true), error);
+
+        std::vector<char> message(options.messageSize);
+        std::vector<char> response(options.messageSize);
+        const auto interval = options.rate > 0.0
+            ? std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(1.0 / options.rate))
+            : clock_type::duration::zero();
+
+        const auto receiveOpenLoop = options.mode == load_mode::open_loop && !options.sink;
+        if(receiveOpenLoop)
+            co_spawn(executor, receive_open_loop(socket, options, statistics), detached);
+
+        auto scheduledAt = connectedAt;
+        while(clock_type::now() < deadline)
+        {
+            if(interval != clock_type::duration::zero())
+            {
+                scheduledAt += interval;
+                if(scheduledAt > clock_type::now())
+                    co_await wait_until(timer, scheduledAt);
+            }
+            else
+            {
+                scheduledAt = clock_type::now();
+            }
+
+            stamp(message, scheduledAt);
+            co_await boost::asio::async_write(*socket, boost::asio::buffer(message), redirect_error(use_awaitable, error));
+            if(error)
+                break;
+
+            statistics.messagesSent.add();
+            statistics.bytesSent.add(message.size());
+
+            if(options.mode == load_mode::open_loop || options.sink)
+                continue;
+
+            co_await boost::asio::async_read(*socket, boost::asio::buffer(response), redirect_error(use_awaitable, error));
+            if(error)
+                break;
+
+            statistics.messageLatency.record(clock_type::now() - scheduledAt);
+            statistics.messagesReceived.add();
+            statistics.bytesReceived.add(response.size());
+        }
+
+        if(error)
+            statistics.errors.add();
+
+        socket->shutdown(tcp::socket::shutdown_send, error);
+
+        // Give in-flight echoes of an open-loop run a moment to arrive, then stop the receiver.
+        if(receiveOpenLoop)
+        {
+            co_await wait_until(timer, clock_type::now() + std::chrono::seconds(1));
+            socket->close(error);
+        }
+    }
+
+    std::optional<process_usage> read_process_usage(int pid)
+    {
+#if defined(__linux__)
+        process_usage usage;
+
+        // The process name in field 2 is parenthesised and may itself contain spaces and
+        // parentheses, so the numeric fields are counted from the last ')'.
+        std::ifstream stat(std::format("/proc/{}/stat", pid));
+        std::string line;
+        if(!std::getline(stat, line))
+            return std::nullopt;
+        const auto nameEnd = line.rfind(')');
+        if(nameEnd == std::string::npos)
+            return std::nullopt;
+
+        std::istringstream fields(line.substr(nameEnd + 1));
+        std::string field;
+        for(size_t fieldIndex = 3; fieldIndex <= 15 && fields >> field; ++fieldIndex)
+        {
+            if(fieldIndex == 14 || fieldIndex == 15)
+                usage.cpuTime += std::chrono::microseconds(std::stoull(field) * 1'000'000 / sysconf(_SC_CLK_TCK));
+        }
+        if(!fields)
+            return std::nullopt;
+
+        // status reports the switches of a single thread, the process total is summed over its
+        // live threads.
+        std::error_code error;
+        for(const auto& task : std::filesystem::directory_iterator(std::format("/proc/{}/task", pid), error))
+        {
+            std::ifstream status(task.path() / "status");
+            while(std::getline(status, line))
+            {
+                if(const auto separator = line.find(':'); line.find("ctxt_switches") != std::string::npos && separator != std::string::npos)
+                    usage.contextSwitches += std::stoull(line.substr(separator + 1));
+            }
+        }
+
+        std::ifstream io(std::format("/proc/{}/io", pid));
+        while(std::getline(io, line))
+        {
+            if(line.starts_with("syscr:") || line.starts_with("syscw:"))
+                usage.systemCalls = usage.systemCalls.value_or(0) + std::stoull(line.substr(6));
+        }
+
+        return usage;
+#else
+        return std::nullopt;
+#endif
+    }
+
+    void print_latency(std::string_view name, const histogram_snapshot& histogram)
+    {
+        const auto toMicroseconds = [](uint64_t nanoseconds){ return static_cast<double>(nanoseconds) / 1000.0; };
+        std::print(
+            "  {:<12} p50 {:>10.1f} us  p90 {:>10.1f} us  p99 {:>10.1f} us  p99.9 {:>10.1f} us  max {:>10.1f} us  (n={})\n",
+            name,
+            toMicroseconds(histogram.percentile(50.0)),
+            toMicroseconds(histogram.percentile(90.0)),
+            toMicroseconds(histogram.percentile(99.0)),
+            toMicroseconds(histogram.percentile(99.9)),
+            toMicroseconds(histogram.max()),
+            histogram.count()
+        );
+    }
+}
+
+//----------------------------------------------------------------------
+
+void run_target(const load_target& target, const load_options& options)
+{
+    std::vector<std::unique_ptr<boost::asio::io_context>> contexts;
+    std::vector<std::unique_ptr<thread_statistics>> statistics;
+    for(size_t threadIndex = 0; threadIndex < options.threads; ++threadIndex)
+    {
+        contexts.push_back(std::make_unique<boost::asio::io_context>(1));
+        statistics.push_back(std::make_unique<thread_statistics>());
+    }
+
+    tcp::resolver resolver(*contexts.front());
+    const auto endpoints = resolver.resolve(target.host, target.port);
+
+    const auto usageBefore = options.proxyPid ? read_process_usage(*options.proxyPid) : std::nullopt;
+
+    const auto startedAt = clock_type::now();
+    const auto deadline = startedAt + options.duration;
+    for(size_t connectionIndex = 0; connectionIndex < options.connections; ++connectionIndex)
+    {
+        const auto threadIndex = connectionIndex % options.threads;
+        co_spawn(*contexts[threadIndex], run_connection(endpoints, options, *statistics[threadIndex], startedAt, deadline), detached);
+    }
+
+    std::vector<std::jthread> threads;
+    for(size_t threadIndex = 1; threadIndex < contexts.size(); ++threadIndex)
+        threads.emplace_back([&context = *contexts[threadIndex]]{ context.run(); });
+    contexts.front()->run();
+    threads.clear();
+
+    const auto elapsed = std::chrono::duration<double>(clock_type::now() - startedAt).count();
+    const auto usageAfter = options.proxyPid ? read_process_usage(*options.proxyPid) : std::nullopt;
+
+    histogram_snapshot connectLatency;
+    histogram_snapshot messageLatency;
+    uint64_t connections = 0;
+    uint64_t connectFailures = 0;
+    uint64_t messagesSent = 0;
+    uint64_t messagesReceived = 0;
+    uint64_t bytesSent = 0;
+    uint64_t bytesReceived = 0;
+    uint64_t errors = 0;
+    clock_type::rep lastConnectedAt = 0;
+    for(const auto& threadStatistics : statistics)
+    {
+        connectLatency.merge(threadStatistics->connectLatency);
+        messageLatency.merge(threadStatistics->messageLatency);
+        connections += threadStatistics->connections.load();
+        connectFailures += threadStatistics->connectFailures.load();
+        messagesSent += threadStatistics->messagesSent.load();
+        messagesReceived += threadStatistics->messagesReceived.load();
+        bytesSent += threadStatistics->bytesSent.load();
+        bytesReceived += threadStatistics->bytesReceived.load();
+        errors += threadStatistics->errors.load();
+        lastConnectedAt = std::max(lastConnectedAt, threadStatistics->lastConnectedAt.load());
+    }
+
+    const auto setupSeconds = std::chrono::duration<double>(clock_type::duration{lastConnectedAt}).count();
+    const auto trafficSeconds = std::chrono::duration<double>(options.duration).count();
+
+    std::print(
+        "{} ({}:{}): {} connections, {} B messages, {}{}{}\n",
+        target.name, target.host, target.port,
+        options.connections, options.messageSize,
+        options.mode == load_mode::closed_loop ? "closed loop" : "open loop",
+        options.rate > 0.0 ? std::format(" at {} msg/s per connection", options.rate) : "",
+        options.sink ? ", sink" : ""
+    );
+    std::print(
+        "  setup        {} connected, {} failed in {:.3f} s ({:.1f} conn/s)\n",
+        connections, connectFailures, setupSeconds, setupSeconds > 0.0 ? static_cast<double>(connections) / setupSeconds : 0.0
+    );
+    std::print(
+        "  throughput   sent {:.1f} msg/s ({:.2f} MB/s), received {:.1f} msg/s, {} errors, {:.1f} s total\n",
+        static_cast<double>(messagesSent) / trafficSeconds,
+        static_cast<double>(bytesSent) / trafficSeconds / (1024.0 * 1024.0),
+        static_cast<double>(messagesReceived) / trafficSeconds,
+        errors, elapsed
+    );
+    print_latency("connect", connectLatency);
+    if(!options.sink)
+        print_latency("message", messageLatency);
+
+    if(usageBefore && usageAfter && bytesSent != 0)
+    {
+        const auto cpuTime = usageAfter->cpuTime - usageBefore->cpuTime;
+        const auto contextSwitches = usageAfter->contextSwitches - usageBefore->contextSwitches;
+        std::print(
+            "  proxy        {:.3f} s cpu, {:.2f} us cpu/message, {:.1f} us cpu/MB, {:.3f} context switches/message\n",
+            std::chrono::duration<double>(cpuTime).count(),
+            static_cast<double>(cpuTime.count()) / static_cast<double>(messagesSent),
+            static_cast<double>(cpuTime.count()) / (static_cast<double>(bytesSent) / (1024.0 * 1024.0)),
+            static_cast<double>(contextSwitches) / static_cast<double>(messagesSent)
+        );
+
+        // Bytes the proxy forwarded in both directions, as seen by the clients.
+        if(usageBefore->systemCalls && usageAfter->systemCalls)
+        {
+            const auto systemCalls = *usageAfter->systemCalls - *usageBefore->systemCalls;
+            const auto bytesForwarded = bytesSent + bytesReceived;
+            std::print(
+                "  proxy        {} syscr+syscw, {:.6f} syscalls/byte ({:.1f} bytes/syscall), {:.2f} syscalls/message\n",
+                systemCalls,
+                static_cast<double>(systemCalls) / static_cast<double>(bytesForwarded),
+                systemCalls != 0 ? static_cast<double>(bytesForwarded) / static_cast<double>(systemCalls) : 0.0,
+                static_cast<double>(systemCalls) / static_cast<double>(messagesSent)
+            );
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+
+bool parse_options(int argc, char* argv[], load_options& options)
+{
+    for(int argumentIndex = 1; argumentIndex < argc; ++argumentIndex)
+    {
+        const std::string_view argument = argv[argumentIndex];
+        const std::string_view value = argumentIndex + 1 < argc ? argv[argumentIndex + 1] : "";
+
+        const auto parseNumber = [&](auto& number){
+            ++argumentIndex;
+            return std::from_chars(value.data(), value.data() + value.size(), number).ec == std::errc{};
+        };
+
+        if(argument == "--target")
+        {
+            ++argumentIndex;
+            const auto nameSeparator = value.find('=');
+            const auto portSeparator = value.rfind(':');
+            if(nameSeparator == std::string_view::npos || portSeparator == std::string_view::npos || portSeparator < nameSeparator)
+                return false;
+
+            options.targets.push_back({
+                std::string(value.substr(0, nameSeparator)),
+                std::string(value.substr(nameSeparator + 1, portSeparator - nameSeparator - 1)),
+                std::string(value.substr(portSeparator + 1))
+            });
+        }
+        else if(argument == "--connections")
+        {
+            if(!parseNumber(options.connections) || options.connections == 0)
+                return false;
+        }
+        else if(argument == "--message-size")
+        {
+            if(!parseNumber(options.messageSize) || options.messageSize < timestampSize)
+                return false;
+        }
+        else if(argument == "--rate")
+        {
+            if(!parseNumber(options.rate) || options.rate < 0.0)
+                return false;
+        }
+        else if(argument == "--duration")
+        {
+            size_t seconds;
+            if(!parseNumber(seconds))
+                return false;
+            options.duration = std::chrono::seconds(seconds);
+        }
+        else if(argument == "--threads")
+        {
+            if(!parseNumber(options.threads) || options.threads == 0)
+                return false;
+        }
+        else if(argument == "--proxy-pid")
+        {
+            int pid;
+            if(!parseNumber(pid))
+                return false;
+            options.proxyPid = pid;
+        }
+        else if(argument == "--open-loop")
+        {
+            options.mode = load_mode::open_loop;
+        }
+        else if(argument == "--closed-loop")
+        {
+            options.mode = load_mode::closed_loop;
+        }
+        else if(argument == "--sink")
+        {
+            options.sink = true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    if(options.mode == load_mode::open_loop && options.rate == 0.0)
+        return false;
+
+    if(options.targets.empty())
+        options.targets = {{"direct", "localhost", "25565"}, {"proxy", "localhost", "25566"}};
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    load_options options;
+    if(!parse_options(argc, argv, options))
+    {
+        std::print(
+            "Usage: {} [--target name=host:port]... [--connections N] [--message-size B] [--rate msg/s]\n"
+            "       [--closed-loop | --open-loop] [--sink] [--duration s] [--threads N] [--proxy-pid PID]\n"
+            "Open-loop runs require --rate. Without targets both localhost:25565 (direct) and\n"
+            "localhost:25566 (proxy) are measured.\n",
+            argv[0]
+        );
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        for(const auto& target : options.targets)
+            run_target(target, options);
+    }
+    catch (const std::exception& exception)
+    {
+        std::print("Load generation failed: {}\n", exception.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
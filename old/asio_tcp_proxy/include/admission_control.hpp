@@ -0,0 +1,145 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <boost/asio/ip/address.hpp>
+
+struct rate_limit
+{
+    // Sustained events per second, zero disables the limit.
+    double rate = 0.0;
+    // Events allowed back to back after a quiet period.
+    double burst = 1.0;
+};
+
+struct admission_options
+{
+    rate_limit perAddress{20.0, 40.0};
+    rate_limit accepts{5000.0, 10000.0};
+    // Zero disables the limit.
+    size_t maxSessions = 100000;
+    // Rounded up to a power of two.
+    size_t addressTableSize = 64 * 1024;
+};
+
+enum class admission_result : uint8_t
+{
+    admitted,
+    address_rate_limited,
+    accept_rate_limited,
+    session_limit
+};
+
+std::string_view to_string(admission_result result) noexcept;
+
+// Rate limiter in the form of the generic cell rate algorithm: the whole state is the
+// theoretical arrival time of the next event, updated with a single compare-and-swap.
+class atomic_rate_limiter
+{
+private:
+    std::atomic<uint64_t> _theoreticalArrival{0};
+public:
+    [[nodiscard]] bool allow(uint64_t now, uint64_t interval, uint64_t tolerance) noexcept;
+    [[nodiscard]] inline uint64_t theoreticalArrival() const noexcept
+    {
+        return _theoreticalArrival.load(std::memory_order_relaxed);
+    }
+    inline void reset() noexcept
+    {
+        _theoreticalArrival.store(0, std::memory_order_relaxed);
+    }
+};
+
+// Fixed-size open-addressing table of per-address limiters that never locks. IPv6 sources are
+// keyed by their /64 prefix. When the probed neighbourhood is full, the entry whose budget
+// refilled the longest ago is taken over, so a flood of distinct sources degrades the
+// per-address limit instead of growing memory; the global accept rate still applies.
+class address_rate_table
+{
+public:
+    constexpr static size_t maxProbes = 8;
+private:
+    struct alignas(16) slot
+    {
+        std::atomic<uint64_t> key{0};
+        atomic_rate_limiter limiter;
+    };
+private:
+    std::unique_ptr<slot[]> _slots;
+    size_t _mask;
+public:
+    explicit address_rate_table(size_t size);
+public:
+    [[nodiscard]] bool allow(const boost::asio::ip::address& address, uint64_t now, uint64_t interval, uint64_t tolerance) noexcept;
+private:
+    [[nodiscard]] static uint64_t key(const boost::asio::ip::address& address) noexcept;
+};
+
+class admission_control;
+
+// Holds one of the concurrent session slots for as long as a session lives.
+class session_slot
+{
+private:
+    admission_control* _admission{};
+public:
+    session_slot() noexcept = default;
+    explicit session_slot(admission_control& admission) noexcept;
+    session_slot(const session_slot& other) = delete;
+    session_slot(session_slot&& other) noexcept;
+public:
+    session_slot& operator=(const session_slot& other) = delete;
+    session_slot& operator=(session_slot&& other) noexcept;
+public:
+    ~session_slot();
+};
+
+// Decides right after accept whether a client gets a session, before any backend
+// connection or session state is created. Safe to use from any number of threads.
+class admission_control
+{
+    friend class session_slot;
+private:
+    admission_options _options;
+    uint64_t _addressInterval;
+    uint64_t _addressTolerance;
+    uint64_t _acceptInterval;
+    uint64_t _acceptTolerance;
+    address_rate_table _addresses;
+    alignas(64) atomic_rate_limiter _accepts;
+    alignas(64) std::atomic<size_t> _activeSessions{0};
+public:
+    explicit admission_control(const admission_options& options = {});
+    admission_control(const admission_control& other) = delete;
+    admission_control& operator=(const admission_control& other) = delete;
+public:
+    [[nodiscard]] admission_result admit(const boost::asio::ip::address& address, std::chrono::steady_clock::time_point now, session_slot& slot) noexcept;
+    [[nodiscard]] inline size_t activeSessions() const noexcept
+    {
+        return _activeSessions.load(std::memory_order_relaxed);
+    }
+};
+
+// Token bucket shaping one forwarding direction of a session. Reads are not split, a read
+// may overdraw the bucket and the next one waits until the debt is paid back.
+class byte_rate_limiter
+{
+public:
+    using clock = std::chrono::steady_clock;
+private:
+    double _bytesPerSecond;
+    double _burstBytes;
+    double _tokens;
+    clock::time_point _updatedAt;
+public:
+    byte_rate_limiter(uint64_t bytesPerSecond, uint64_t burstBytes, clock::time_point now) noexcept;
+public:
+    // Time to wait before the next read.
+    [[nodiscard]] clock::duration delay(clock::time_point now) noexcept;
+    void consume(size_t bytes) noexcept;
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <utility>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <backend_set.hpp>
+#include <metrics.hpp>
+#include <recycling_arena.hpp>
+#include <resolver_cache.hpp>
+#include <timing_wheel.hpp>
+
+struct backend_connection_pool_options
+{
+    size_t idleConnections = 8;
+    std::chrono::steady_clock::duration maxIdleAge = std::chrono::seconds(15);
+    std::chrono::steady_clock::duration minRetryDelay = std::chrono::milliseconds(100);
+    std::chrono::steady_clock::duration maxRetryDelay = std::chrono::seconds(10);
+    // Connection attempts still pending after this long fail with timed_out.
+    std::chrono::steady_clock::duration connectTimeout = std::chrono::seconds(5);
+};
+
+// Keeps a number of already-connected backend sockets ready so that accepted clients can be
+// paired without waiting for a resolve and a handshake. Replenished by a background coroutine.
+class backend_connection_pool
+{
+public:
+    using clock = std::chrono::steady_clock;
+private:
+    struct idle_connection
+    {
+        boost::asio::ip::tcp::socket socket;
+        clock::time_point established;
+    };
+private:
+    boost::asio::io_context& _context;
+    timing_wheel& _timers;
+    resolver_cache& _resolverCache;
+    backend& _backend;
+    backend_metrics& _metrics;
+    const health_check_options& _healthCheckOptions;
+    backend_connection_pool_options _options;
+    std::deque<idle_connection> _idleConnections;
+    size_t _pendingConnections{0};
+    clock::duration _retryDelay;
+    // Attempts spawned together share a round; the retry delay doubles once per failed round.
+    uint64_t _refillRound{0};
+    uint64_t _backedOffRound{0};
+    boost::asio::steady_timer _wakeup;
+public:
+    backend_connection_pool(
+        boost::asio::io_context& context,
+        timing_wheel& timers,
+        resolver_cache& resolverCache,
+        backend& backend,
+        backend_metrics& metrics,
+        const health_check_options& healthCheckOptions,
+        const backend_connection_pool_options& options = {}
+    );
+public:
+    void start();
+    boost::asio::awaitable<boost::asio::ip::tcp::socket> acquire();
+    [[nodiscard]] inline size_t idleCount() const noexcept
+    {
+        return _idleConnections.size();
+    }
+private:
+    boost::asio::awaitable<boost::asio::ip::tcp::socket> connect();
+    boost::asio::awaitable<void> replenish();
+    boost::asio::awaitable<void> establishIdleConnection(uint64_t round);
+    void pruneStale();
+    [[nodiscard]] static bool isAlive(boost::asio::ip::tcp::socket& socket);
+};
+
+template<>
+inline constexpr bool recycles_coroutine_frames<backend_connection_pool> = true;
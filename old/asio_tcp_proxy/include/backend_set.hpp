@@ -0,0 +1,173 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/address.hpp>
+
+enum class load_balancing_policy : uint8_t
+{
+    round_robin,
+    least_connections,
+    power_of_two_choices,
+    consistent_hashing
+};
+
+std::string_view to_string(load_balancing_policy policy) noexcept;
+std::optional<load_balancing_policy> parse_load_balancing_policy(std::string_view name) noexcept;
+
+struct backend_address
+{
+    std::string address;
+    std::string port;
+};
+
+struct health_check_options
+{
+    std::chrono::steady_clock::duration interval = std::chrono::seconds(5);
+    std::chrono::steady_clock::duration timeout = std::chrono::seconds(2);
+    uint32_t failuresToEject = 3;
+    uint32_t successesToRestore = 2;
+};
+
+// Per-backend state shared by every io_context thread. All members are updated lock-free.
+class alignas(64) backend
+{
+private:
+    backend_address _address;
+    size_t _index;
+    std::atomic<bool> _healthy{true};
+    std::atomic<uint32_t> _consecutiveFailures{0};
+    std::atomic<uint32_t> _consecutiveSuccesses{0};
+    std::atomic<uint32_t> _activeConnections{0};
+    std::atomic<uint64_t> _totalConnections{0};
+    std::atomic<uint64_t> _failedConnections{0};
+    std::atomic<uint64_t> _connectLatencyMicroseconds{0};
+public:
+    backend(backend_address address, size_t index);
+public:
+    [[nodiscard]] inline const std::string& address() const noexcept
+    {
+        return _address.address;
+    }
+    [[nodiscard]] inline const std::string& port() const noexcept
+    {
+        return _address.port;
+    }
+    [[nodiscard]] inline size_t index() const noexcept
+    {
+        return _index;
+    }
+    [[nodiscard]] inline bool healthy() const noexcept
+    {
+        return _healthy.load(std::memory_order_relaxed);
+    }
+    [[nodiscard]] inline uint32_t activeConnections() const noexcept
+    {
+        return _activeConnections.load(std::memory_order_relaxed);
+    }
+    [[nodiscard]] inline uint64_t totalConnections() const noexcept
+    {
+        return _totalConnections.load(std::memory_order_relaxed);
+    }
+    [[nodiscard]] inline uint64_t failedConnections() const noexcept
+    {
+        return _failedConnections.load(std::memory_order_relaxed);
+    }
+    // Exponentially weighted moving average of the TCP handshake time.
+    [[nodiscard]] inline std::chrono::microseconds connectLatency() const noexcept
+    {
+        return std::chrono::microseconds(_connectLatencyMicroseconds.load(std::memory_order_relaxed));
+    }
+public:
+    inline void connectionOpened() noexcept
+    {
+        _activeConnections.fetch_add(1, std::memory_order_relaxed);
+        _totalConnections.fetch_add(1, std::memory_order_relaxed);
+    }
+    inline void connectionClosed() noexcept
+    {
+        _activeConnections.fetch_sub(1, std::memory_order_relaxed);
+    }
+    void recordConnectSuccess(std::chrono::steady_clock::duration latency, const health_check_options& options) noexcept;
+    void recordConnectFailure(const health_check_options& options) noexcept;
+};
+
+// Holds one active-connection slot on a backend for as long as a session uses it.
+class backend_lease
+{
+private:
+    backend* _backend{};
+public:
+    backend_lease() noexcept = default;
+    explicit backend_lease(backend& backend) noexcept;
+    backend_lease(const backend_lease& other) = delete;
+    backend_lease(backend_lease&& other) noexcept;
+public:
+    backend_lease& operator=(const backend_lease& other) = delete;
+    backend_lease& operator=(backend_lease&& other) noexcept;
+public:
+    ~backend_lease();
+public:
+    [[nodiscard]] inline backend* get() const noexcept
+    {
+        return _backend;
+    }
+    inline backend* operator->() const noexcept
+    {
+        return _backend;
+    }
+    inline explicit operator bool() const noexcept
+    {
+        return _backend != nullptr;
+    }
+};
+
+class backend_set
+{
+public:
+    constexpr static size_t virtualNodesPerBackend = 128;
+private:
+    std::vector<std::unique_ptr<backend>> _backends;
+    std::vector<std::pair<uint64_t, size_t>> _hashRing;
+    load_balancing_policy _policy;
+    health_check_options _healthCheckOptions;
+    alignas(64) std::atomic<size_t> _nextRoundRobin{0};
+public:
+    backend_set(std::vector<backend_address> addresses, load_balancing_policy policy, const health_check_options& healthCheckOptions = {});
+public:
+    [[nodiscard]] inline size_t size() const noexcept
+    {
+        return _backends.size();
+    }
+    [[nodiscard]] inline backend& operator[](size_t index) const noexcept
+    {
+        return *_backends[index];
+    }
+    [[nodiscard]] inline load_balancing_policy policy() const noexcept
+    {
+        return _policy;
+    }
+    [[nodiscard]] inline const health_check_options& healthCheckOptions() const noexcept
+    {
+        return _healthCheckOptions;
+    }
+public:
+    [[nodiscard]] backend_lease select(const boost::asio::ip::address& clientAddress);
+    boost::asio::awaitable<void> runHealthChecks(boost::asio::io_context& context);
+private:
+    [[nodiscard]] backend& selectRoundRobin(bool anyHealthy);
+    [[nodiscard]] backend& selectLeastConnections(bool anyHealthy);
+    [[nodiscard]] backend& selectPowerOfTwoChoices(bool anyHealthy);
+    [[nodiscard]] backend& selectConsistentHashing(const boost::asio::ip::address& clientAddress, bool anyHealthy);
+    [[nodiscard]] bool anyHealthy() const noexcept;
+    boost::asio::awaitable<bool> checkHealth(boost::asio::io_context& context, backend& backend);
+};
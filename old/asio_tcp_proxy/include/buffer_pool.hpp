@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#if defined(BOOST_ASIO_HAS_IO_URING)
+#include <atomic>
+#include <mutex>
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/buffer_registration.hpp>
+#include <boost/asio/io_context.hpp>
+#endif
+
+class buffer_pool;
+
+class pooled_buffer
+{
+    friend class buffer_pool;
+public:
+    constexpr static size_t notRegistered = std::numeric_limits<size_t>::max();
+private:
+    char* _data{};
+    size_t _sizeClass{};
+    // Registered slots belong to the pool that handed them out, on any thread.
+    buffer_pool* _owner{};
+    size_t _registeredSlot{notRegistered};
+private:
+    pooled_buffer(char* data, size_t sizeClass, buffer_pool* owner = nullptr, size_t registeredSlot = notRegistered) noexcept;
+public:
+    pooled_buffer() noexcept = default;
+    pooled_buffer(const pooled_buffer& other) = delete;
+    pooled_buffer(pooled_buffer&& other) noexcept;
+public:
+    pooled_buffer& operator=(const pooled_buffer& other) = delete;
+    pooled_buffer& operator=(pooled_buffer&& other) noexcept;
+public:
+    ~pooled_buffer();
+public:
+    [[nodiscard]] std::span<char> data() const noexcept;
+    [[nodiscard]] size_t size() const noexcept;
+    [[nodiscard]] size_t sizeClass() const noexcept;
+    void release() noexcept;
+public:
+    // Registered buffers are pinned in the io_uring instance of the owning thread's
+    // io_context and are read into with fixed-buffer operations. They go back to the owning
+    // pool wherever they are released.
+    [[nodiscard]] inline bool registered() const noexcept
+    {
+        return _registeredSlot != notRegistered;
+    }
+#if defined(BOOST_ASIO_HAS_IO_URING)
+    [[nodiscard]] boost::asio::mutable_registered_buffer registeredBuffer() const noexcept;
+#endif
+public:
+    inline explicit operator bool() const noexcept
+    {
+        return _data != nullptr;
+    }
+};
+
+// Per-thread cache of forwarding buffers bucketed into power-of-four size classes.
+// Plain buffers released on another thread simply migrate to that thread's cache, registered
+// slots are handed back to the pool that registered them.
+class buffer_pool
+{
+    friend class pooled_buffer;
+public:
+    constexpr static size_t sizeClassCount = 4;
+    constexpr static std::array<size_t, sizeClassCount> sizeClasses{
+        16 * 1024,
+        64 * 1024,
+        256 * 1024,
+        1024 * 1024
+    };
+    constexpr static size_t maxCachedBytesPerSizeClass = 4 * 1024 * 1024;
+    constexpr static size_t registeredSlotsPerThread = 1024;
+private:
+    std::array<std::vector<std::unique_ptr<char[]>>, sizeClassCount> _freeBuffers;
+#if defined(BOOST_ASIO_HAS_IO_URING)
+    std::unique_ptr<char[]> _registeredRegion;
+    std::vector<size_t> _freeRegisteredSlots;
+    std::optional<boost::asio::buffer_registration<std::vector<boost::asio::mutable_buffer>>> _registration;
+    // Slots released on other threads, moved back to _freeRegisteredSlots by the owner.
+    std::mutex _remoteSlotsMutex;
+    std::vector<size_t> _remoteRegisteredSlots;
+    std::atomic<bool> _hasRemoteSlots{false};
+#endif
+public:
+    buffer_pool() = default;
+    buffer_pool(const buffer_pool& other) = delete;
+    buffer_pool& operator=(const buffer_pool& other) = delete;
+public:
+    [[nodiscard]] pooled_buffer acquire(size_t sizeClass);
+    void recycle(std::unique_ptr<char[]> data, size_t sizeClass) noexcept;
+#if defined(BOOST_ASIO_HAS_IO_URING)
+    // Registers slots of the smallest size class with the io_uring instance of `context`,
+    // which must be run by the calling thread. Smallest-class acquisitions prefer these slots.
+    void registerBuffers(boost::asio::io_context& context, size_t slotCount);
+    // Must be called before the io_context is destroyed; outstanding slots stay valid memory.
+    void unregisterBuffers() noexcept;
+private:
+    void recycleRegistered(size_t slot) noexcept;
+    void reclaimRemoteSlots() noexcept;
+#endif
+public:
+    [[nodiscard]] static buffer_pool& local() noexcept;
+};
+
+// Picks the size class for the next read of a single forwarding direction: grows when a
+// read fills the buffer, shrinks after a run of reads that used less than a quarter of it.
+class adaptive_buffer_size
+{
+public:
+    constexpr static size_t shrinkAfterUnderfilledReads = 8;
+private:
+    size_t _sizeClass{};
+    size_t _underfilledReads{};
+public:
+    [[nodiscard]] inline size_t sizeClass() const noexcept
+    {
+        return _sizeClass;
+    }
+    void update(size_t bytesRead, size_t bufferSize) noexcept;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+#include <boost/asio/ip/udp.hpp>
+#include <boost/system/error_code.hpp>
+
+#if defined(__linux__)
+#include <array>
+#include <sys/socket.h>
+#endif
+
+// Scratch space for batched datagram I/O, owned by one worker thread. Received datagrams are
+// sent on straight out of the receive slots. On Linux a batch is moved with one recvmmsg or
+// sendmmsg, and with generic receive offload a slot may hold several coalesced datagrams of
+// segmentSize() bytes each, which are passed on with segmentation offload so they stay one
+// buffer end to end. Elsewhere the batch is filled and sent one datagram per call.
+class datagram_batch
+{
+private:
+    size_t _capacity;
+    size_t _slotSize;
+    bool _offload;
+    std::unique_ptr<char[]> _data;
+    std::vector<boost::asio::ip::udp::endpoint> _senders;
+    std::vector<size_t> _sizes;
+    std::vector<bool> _truncated;
+    std::vector<uint16_t> _segmentSizes;
+#if defined(__linux__)
+    using control_buffer = std::array<char, CMSG_SPACE(sizeof(int))>;
+
+    std::vector<mmsghdr> _receiveHeaders;
+    std::vector<iovec> _receiveVectors;
+    std::vector<control_buffer> _receiveControl;
+    std::vector<mmsghdr> _sendHeaders;
+    std::vector<iovec> _sendVectors;
+    std::vector<control_buffer> _sendControl;
+#endif
+public:
+    datagram_batch(size_t capacity, size_t slotSize, bool offload);
+    datagram_batch(const datagram_batch& other) = delete;
+    datagram_batch& operator=(const datagram_batch& other) = delete;
+public:
+    [[nodiscard]] inline size_t capacity() const noexcept
+    {
+        return _capacity;
+    }
+public:
+    // Receives up to capacity() datagrams from a non-blocking socket. Returns 0 when none are
+    // pending. Senders are only recorded when `withSenders` is set.
+    size_t receive(boost::asio::ip::udp::socket& socket, bool withSenders, boost::system::error_code& error);
+    [[nodiscard]] std::span<const char> data(size_t index) const noexcept;
+    [[nodiscard]] const boost::asio::ip::udp::endpoint& sender(size_t index) const noexcept;
+    // Size of the coalesced datagrams in the slot, 0 if it holds a single datagram.
+    [[nodiscard]] uint16_t segmentSize(size_t index) const noexcept;
+    [[nodiscard]] bool truncated(size_t index) const noexcept;
+    // Sends the received datagrams at `indices` without blocking, to `destination` if the
+    // socket is not connected. Returns how many were sent before the socket would block.
+    size_t send(
+        boost::asio::ip::udp::socket& socket, std::span<const size_t> indices,
+        const boost::asio::ip::udp::endpoint* destination,
+        boost::system::error_code& error
+    );
+};
+
+// Enables generic receive offload on a UDP socket; returns false where the kernel lacks it.
+bool enable_generic_receive_offload(boost::asio::ip::udp::socket& socket) noexcept;
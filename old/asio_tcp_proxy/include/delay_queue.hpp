@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+class delay_queue;
+
+// Exact deadline registered with a delay_queue, the counterpart of wheel_timer for delays
+// far below the wheel's resolution. The callback runs on the queue's thread.
+class delay_entry
+{
+    friend class delay_queue;
+private:
+    delay_queue* _queue{};
+    size_t _index{};
+    std::chrono::steady_clock::time_point _deadline;
+    std::function<void()> _callback;
+public:
+    explicit delay_entry(std::function<void()> callback);
+    delay_entry(const delay_entry& other) = delete;
+    delay_entry& operator=(const delay_entry& other) = delete;
+    ~delay_entry();
+public:
+    [[nodiscard]] inline bool scheduled() const noexcept
+    {
+        return _queue != nullptr;
+    }
+    void cancel() noexcept;
+};
+
+// Binary min-heap of deadlines of one io_context thread sharing a single steady_timer, which
+// is only re-armed when the earliest deadline changes. Scheduling and cancelling are O(log n).
+class delay_queue
+{
+    friend class delay_entry;
+public:
+    using clock = std::chrono::steady_clock;
+private:
+    boost::asio::steady_timer _timer;
+    std::vector<delay_entry*> _heap;
+public:
+    explicit delay_queue(boost::asio::io_context& context);
+    delay_queue(const delay_queue& other) = delete;
+    delay_queue& operator=(const delay_queue& other) = delete;
+    ~delay_queue();
+public:
+    void start();
+    // Reschedules the entry if it is already scheduled.
+    void schedule(delay_entry& entry, clock::time_point deadline);
+    [[nodiscard]] inline size_t size() const noexcept
+    {
+        return _heap.size();
+    }
+private:
+    boost::asio::awaitable<void> run();
+    void remove(delay_entry& entry) noexcept;
+    void siftUp(size_t index) noexcept;
+    void siftDown(size_t index) noexcept;
+    void place(delay_entry* entry, size_t index) noexcept;
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include <utility>
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <buffer_pool.hpp>
+#include <histogram.hpp>
+#include <recycling_arena.hpp>
+
+struct forwarding_pipe_options
+{
+    size_t lowWatermark = 64 * 1024;
+    size_t highWatermark = 256 * 1024;
+    size_t maxGatherBuffers = 16;
+    // Writes are held back for up to coalesceDelay after the oldest queued read, or until
+    // coalesceBytes are queued, so that bursts of small reads leave in a single write.
+    // While coalescing, reads of up to coalesceCopyLimit bytes are appended to the last
+    // queued buffer instead of occupying a buffer of their own. Zero delay disables it.
+    std::chrono::microseconds coalesceDelay{0};
+    size_t coalesceBytes = 16 * 1024;
+    size_t coalesceCopyLimit = 2 * 1024;
+};
+
+// Queue of filled buffers between the reading and the writing coroutine of one forwarding
+// direction. The reader pauses once the queued bytes reach the high watermark and resumes
+// when the writer drained them to the low watermark. Both ends must run on the same thread.
+class forwarding_pipe
+{
+private:
+    struct chunk
+    {
+        pooled_buffer buffer;
+        size_t size;
+        std::chrono::steady_clock::time_point readAt;
+    };
+private:
+    forwarding_pipe_options _options;
+    std::deque<chunk> _chunks;
+    size_t _queuedBytes{0};
+    size_t _gatheredChunks{0};
+    bool _closed{false};
+    bool _aborted{false};
+    boost::asio::steady_timer _dataAvailable;
+    boost::asio::steady_timer _spaceAvailable;
+public:
+    forwarding_pipe(const boost::asio::any_io_executor& executor, const forwarding_pipe_options& options = {});
+public:
+    [[nodiscard]] inline bool full() const noexcept
+    {
+        return _queuedBytes >= _options.highWatermark;
+    }
+    [[nodiscard]] inline bool closed() const noexcept
+    {
+        return _closed;
+    }
+    [[nodiscard]] inline bool aborted() const noexcept
+    {
+        return _aborted;
+    }
+    [[nodiscard]] inline size_t queuedBytes() const noexcept
+    {
+        return _queuedBytes;
+    }
+    [[nodiscard]] inline bool coalescing() const noexcept
+    {
+        return _options.coalesceDelay.count() != 0;
+    }
+    // Data can be gathered right away, waitForData would return true without suspending.
+    [[nodiscard]] inline bool ready() const noexcept
+    {
+        return !_chunks.empty() && !coalescing();
+    }
+public:
+    void push(pooled_buffer buffer, size_t size, std::chrono::steady_clock::time_point readAt);
+    // No more data will be pushed, the writer drains what is queued and finishes.
+    void close() noexcept;
+    // The writer failed, queued data is dropped and the reader should stop.
+    void abort() noexcept;
+    boost::asio::awaitable<void> waitForSpace();
+    // Returns false once the pipe is closed and drained. When coalescing, waits for the
+    // coalescing deadline or threshold before returning.
+    boost::asio::awaitable<bool> waitForData();
+    // Chunks handed out for writing are no longer appended to.
+    size_t gather(std::vector<boost::asio::const_buffer>& buffers);
+    // Drops written chunks and records the read-to-write latency of each into `latency`.
+    void consume(size_t chunkCount, latency_histogram& latency) noexcept;
+};
+
+template<>
+inline constexpr bool recycles_coroutine_frames<forwarding_pipe> = true;
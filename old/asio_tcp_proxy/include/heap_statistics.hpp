@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+struct heap_statistics
+{
+    uint64_t allocations{0};
+    size_t bytesInUse{0};
+};
+
+// Process-wide heap usage, only tracked when built with ASIO_TCP_PROXY_COUNT_ALLOCATIONS,
+// which replaces the global allocation functions with counting ones. Allocations per session
+// follow from the growth of `allocations` over the sessions opened meanwhile, bytes per idle
+// session from `bytesInUse` over the active sessions.
+[[nodiscard]] std::optional<heap_statistics> current_heap_statistics() noexcept;
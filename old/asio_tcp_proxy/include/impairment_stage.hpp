@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <random>
+#include <utility>
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <buffer_pool.hpp>
+#include <delay_queue.hpp>
+
+// Emulated network conditions of one forwarding direction.
+struct impairment_options
+{
+    // One-way delay added to every read, varied uniformly by up to jitter either way.
+    std::chrono::microseconds latency{0};
+    std::chrono::microseconds jitter{0};
+    // Link rate in bytes per second, reads queue behind each other as on a slow link. Zero is unlimited.
+    uint64_t bandwidth = 0;
+    // Reads are split into segments of this size released segmentGap apart, zero keeps them whole.
+    size_t segmentSize = 0;
+    std::chrono::microseconds segmentGap{0};
+    // Every stallInterval the direction delivers nothing for stallDuration.
+    std::chrono::milliseconds stallInterval{0};
+    std::chrono::milliseconds stallDuration{0};
+    // Bytes held back before the reader pauses.
+    size_t maxHeldBytes = 4 * 1024 * 1024;
+};
+
+// Holds back the reads of one direction until their emulated arrival time before handing them
+// to the sink. Arrival times never decrease, so the held chunks form a FIFO that is already
+// ordered by deadline and only its head is registered with the worker's delay queue.
+class impairment_stage
+{
+public:
+    using clock = std::chrono::steady_clock;
+    // Returns false to drop everything still held.
+    using sink = std::function<bool(pooled_buffer buffer, size_t size, clock::time_point readAt)>;
+private:
+    struct held_chunk
+    {
+        pooled_buffer buffer;
+        size_t size;
+        clock::time_point readAt;
+        clock::time_point releaseAt;
+    };
+private:
+    impairment_options _options;
+    delay_queue& _delays;
+    sink _sink;
+    std::function<void()> _onDrained;
+    std::deque<held_chunk> _chunks;
+    size_t _heldBytes{0};
+    size_t _segmentSizeClass{0};
+    clock::time_point _origin;
+    clock::time_point _linkFreeAt;
+    clock::time_point _lastReleaseAt;
+    std::minstd_rand _random;
+    bool _closing{false};
+    bool _failed{false};
+    boost::asio::steady_timer _spaceAvailable;
+    delay_entry _release;
+public:
+    impairment_stage(
+        const boost::asio::any_io_executor& executor,
+        delay_queue& delays,
+        const impairment_options& options,
+        uint64_t seed,
+        sink output,
+        std::function<void()> onDrained
+    );
+    impairment_stage(const impairment_stage& other) = delete;
+    impairment_stage& operator=(const impairment_stage& other) = delete;
+public:
+    [[nodiscard]] inline bool full() const noexcept
+    {
+        return _heldBytes >= _options.maxHeldBytes;
+    }
+    [[nodiscard]] inline size_t heldBytes() const noexcept
+    {
+        return _heldBytes;
+    }
+public:
+    void push(pooled_buffer buffer, size_t size, clock::time_point readAt);
+    // Nothing more is pushed, onDrained runs once everything held has been released.
+    void close();
+    // Drops everything held and ignores later pushes.
+    void abort() noexcept;
+    boost::asio::awaitable<void> waitForSpace();
+private:
+    void hold(pooled_buffer buffer, size_t size, clock::time_point readAt, clock::time_point sentAt);
+    void release();
+    void finish();
+    [[nodiscard]] clock::time_point arrivalTime(size_t size, clock::time_point sentAt);
+};
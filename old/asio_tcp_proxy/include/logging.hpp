@@ -0,0 +1,157 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+enum class log_level : uint8_t
+{
+    trace,
+    debug,
+    info,
+    warning,
+    error,
+    off
+};
+
+std::string_view to_string(log_level level) noexcept;
+
+struct log_record
+{
+    constexpr static size_t maxTextLength = 240;
+
+    std::chrono::system_clock::time_point timestamp;
+    log_level level;
+    uint16_t length;
+    std::array<char, maxTextLength> text;
+};
+
+// Single-producer single-consumer ring owned by one logging thread and drained by the flusher.
+class log_ring
+{
+public:
+    constexpr static size_t capacity = 1024;
+    static_assert((capacity & (capacity - 1)) == 0);
+private:
+    std::array<log_record, capacity> _records;
+    alignas(64) std::atomic<size_t> _head{0};
+    alignas(64) std::atomic<size_t> _tail{0};
+    alignas(64) std::atomic<size_t> _dropped{0};
+public:
+    [[nodiscard]] log_record* beginPush() noexcept;
+    void endPush() noexcept;
+    void drop() noexcept;
+public:
+    template<typename Consumer>
+    size_t drain(Consumer&& consumer)
+    {
+        const auto head = _head.load(std::memory_order_acquire);
+        auto tail = _tail.load(std::memory_order_relaxed);
+        const auto drained = head - tail;
+
+        for(; tail != head; ++tail)
+            consumer(_records[tail & (capacity - 1)]);
+
+        _tail.store(tail, std::memory_order_release);
+        return drained;
+    }
+    [[nodiscard]] size_t takeDropped() noexcept;
+};
+
+// Asynchronous logger: producers format into their thread's ring without locking,
+// a background thread batches the records to stdout.
+class logger
+{
+public:
+    constexpr static std::chrono::milliseconds flushInterval{10};
+private:
+    std::atomic<log_level> _level{log_level::info};
+    std::mutex _ringsMutex;
+    std::vector<std::unique_ptr<log_ring>> _rings;
+    std::jthread _flusher;
+private:
+    logger();
+public:
+    logger(const logger& other) = delete;
+    logger& operator=(const logger& other) = delete;
+    ~logger();
+public:
+    [[nodiscard]] static logger& instance();
+public:
+    inline void setLevel(log_level level) noexcept
+    {
+        _level.store(level, std::memory_order_relaxed);
+    }
+    [[nodiscard]] inline bool enabled(log_level level) const noexcept
+    {
+        return level >= _level.load(std::memory_order_relaxed);
+    }
+    template<typename... Args>
+    void log(log_level level, std::format_string<Args...> format, Args&&... args)
+    {
+        if(!enabled(level))
+            return;
+
+        auto& ring = localRing();
+        auto* record = ring.beginPush();
+        if(record == nullptr)
+        {
+            ring.drop();
+            return;
+        }
+
+        record->timestamp = std::chrono::system_clock::now();
+        record->level = level;
+        const auto result = std::format_to_n(record->text.data(), record->text.size(), format, std::forward<Args>(args)...);
+        record->length = static_cast<uint16_t>(result.out - record->text.data());
+
+        ring.endPush();
+    }
+    void flush();
+private:
+    log_ring& localRing();
+    void run(std::stop_token stopToken);
+};
+
+template<typename... Args>
+inline void log_message(log_level level, std::format_string<Args...> format, Args&&... args)
+{
+    logger::instance().log(level, format, std::forward<Args>(args)...);
+}
+
+// Lets one in every `rate` events through; meant to be kept thread_local at the call site.
+class log_sampler
+{
+private:
+    uint64_t _rate;
+    uint64_t _counter{0};
+public:
+    constexpr explicit log_sampler(uint64_t rate) noexcept
+        : _rate(rate != 0 ? rate : 1)
+    {}
+public:
+    [[nodiscard]] constexpr bool sample() noexcept
+    {
+        return _counter++ % _rate == 0;
+    }
+};
+
+// Traffic counters of a single forwarding direction, reported once when the session ends.
+struct direction_counters
+{
+    uint64_t bytes{0};
+    uint64_t reads{0};
+public:
+    inline void record(size_t bytesRead) noexcept
+    {
+        bytes += bytesRead;
+        ++reads;
+    }
+};
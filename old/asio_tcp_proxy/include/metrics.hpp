@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <admission_control.hpp>
+#include <histogram.hpp>
+
+class backend_set;
+class proxy_worker;
+
+struct direction_metrics
+{
+    local_counter bytes;
+    local_counter messages;
+    local_counter writes;
+    // Time from the completion of a read to the completion of the write that forwarded it.
+    latency_histogram forwardingLatency;
+};
+
+// Work the proxy takes off the backend when it handles Minecraft protocol compression.
+struct compression_metrics
+{
+    local_counter framesCompressed;
+    local_counter bytesBeforeCompression;
+    local_counter bytesAfterCompression;
+    local_counter framesDecompressed;
+    local_counter bytesDecompressed;
+    latency_histogram compressionTime;
+    latency_histogram decompressionTime;
+};
+
+struct backend_metrics
+{
+    direction_metrics clientToServer;
+    direction_metrics serverToClient;
+    local_counter sessionsOpened;
+    local_counter sessionsClosed;
+    // Sessions closed by the idle or half-closed timeout.
+    local_counter sessionsTimedOut;
+    latency_histogram connectLatency;
+    compression_metrics compression;
+};
+
+struct listener_metrics
+{
+    local_counter acceptedConnections;
+    local_counter rejectedConnections;
+    // Clients turned away by admission control, indexed by admission_result.
+    std::array<local_counter, 4> throttledConnections;
+    // Time from accepting a client to its session starting to forward.
+    latency_histogram acceptLatency;
+};
+
+struct udp_direction_metrics
+{
+    local_counter datagrams;
+    local_counter bytes;
+    local_counter receiveCalls;
+    local_counter sendCalls;
+    local_counter dropped;
+};
+
+struct udp_metrics
+{
+    udp_direction_metrics clientToServer;
+    udp_direction_metrics serverToClient;
+    local_counter flowsOpened;
+    local_counter flowsClosed;
+    local_counter flowsRejected;
+};
+
+struct mirror_metrics
+{
+    local_counter sessions;
+    local_counter bytes;
+    local_counter droppedBytes;
+    local_counter disconnects;
+    local_counter connectFailures;
+    // Time from the primary write to the shadow write of the same data.
+    latency_histogram lag;
+};
+
+// Metrics written only by the thread of one worker; scrapes merge all workers.
+class worker_metrics
+{
+private:
+    listener_metrics _listener;
+    udp_metrics _udp;
+    mirror_metrics _mirror;
+    std::vector<std::unique_ptr<backend_metrics>> _backends;
+public:
+    explicit worker_metrics(size_t backendCount);
+public:
+    [[nodiscard]] inline listener_metrics& listener() noexcept
+    {
+        return _listener;
+    }
+    [[nodiscard]] inline const listener_metrics& listener() const noexcept
+    {
+        return _listener;
+    }
+    [[nodiscard]] inline udp_metrics& udp() noexcept
+    {
+        return _udp;
+    }
+    [[nodiscard]] inline const udp_metrics& udp() const noexcept
+    {
+        return _udp;
+    }
+    [[nodiscard]] inline mirror_metrics& mirror() noexcept
+    {
+        return _mirror;
+    }
+    [[nodiscard]] inline const mirror_metrics& mirror() const noexcept
+    {
+        return _mirror;
+    }
+    [[nodiscard]] inline backend_metrics& backend(size_t backendIndex) noexcept
+    {
+        return *_backends[backendIndex];
+    }
+    [[nodiscard]] inline const backend_metrics& backend(size_t backendIndex) const noexcept
+    {
+        return *_backends[backendIndex];
+    }
+};
+
+// Renders the merged metrics of all workers in the Prometheus text exposition format.
+std::string render_metrics(std::span<const std::unique_ptr<proxy_worker>> workers);
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <buffer_pool.hpp>
+#include <forwarding_pipe.hpp>
+#include <metrics.hpp>
+
+struct minecraft_options
+{
+    // Threshold announced to clients when the proxy compresses on behalf of the backend,
+    // negative leaves compression to the backend. Taking it over requires the backend to run
+    // with compression disabled (network-compression-threshold=-1) and in offline mode.
+    int32_t compressionThreshold = 256;
+    int compressionLevel = 6;
+    // Clientbound coalescing budget, see forwarding_pipe_options.
+    std::chrono::microseconds coalesceDelay{500};
+};
+
+constexpr size_t maxVarIntSize = 5;
+// Frame lengths are at most three VarInt bytes.
+constexpr int32_t maxFrameLength = (1 << 21) - 1;
+// Largest data length a compressed frame may declare, as in vanilla's compression decoder.
+constexpr int32_t maxUncompressedLength = 1 << 23;
+
+enum class varint_status : uint8_t
+{
+    complete,
+    incomplete,
+    malformed
+};
+
+// Decodes the VarInt at `offset` and advances past it when complete.
+varint_status read_varint(std::span<const char> data, size_t& offset, int32_t& value) noexcept;
+size_t write_varint(int32_t value, char* out) noexcept;
+[[nodiscard]] size_t varint_size(int32_t value) noexcept;
+
+// Splits a byte stream into VarInt-length-prefixed frames, keeping partial frames across reads.
+class minecraft_frame_reader
+{
+private:
+    std::vector<char> _data;
+    size_t _offset{0};
+public:
+    void append(std::span<const char> data);
+    // On success `frame` is the next frame without its length prefix, valid until the next append.
+    varint_status next(std::span<const char>& frame) noexcept;
+    // Data not yet returned as a frame.
+    [[nodiscard]] std::span<const char> remaining() const noexcept;
+    void clear() noexcept;
+};
+
+enum class minecraft_direction : uint8_t
+{
+    serverbound,
+    clientbound
+};
+
+// Protocol-aware forwarding state of one Minecraft connection, shared by both directions of
+// a session. The handshake and login are parsed frame by frame; afterwards the stream passes
+// through untouched unless the proxy took over compression, in which case client frames are
+// decompressed and backend frames compressed here. Status pings, encrypted logins and
+// backends that enable compression themselves fall back to passthrough.
+class minecraft_connection
+{
+private:
+    enum class state : uint8_t
+    {
+        handshake,
+        login,
+        compressed,
+        passthrough
+    };
+private:
+    minecraft_options _options;
+    compression_metrics& _metrics;
+    state _state{state::handshake};
+    minecraft_frame_reader _serverbound;
+    minecraft_frame_reader _clientbound;
+public:
+    minecraft_connection(const minecraft_options& options, compression_metrics& metrics);
+public:
+    // Consumes a read of `size` bytes and pushes what is to be forwarded into `pipe`.
+    // Returns false if the stream violates the protocol.
+    [[nodiscard]] bool process(
+        minecraft_direction direction,
+        pooled_buffer buffer, size_t size, std::chrono::steady_clock::time_point readAt,
+        forwarding_pipe& pipe
+    );
+private:
+    class output;
+
+    bool processFrame(minecraft_direction direction, std::span<const char> frame, output& out);
+    bool processHandshake(std::span<const char> frame, output& out);
+    bool processLogin(minecraft_direction direction, std::span<const char> frame, output& out);
+    bool compressFrame(std::span<const char> frame, output& out);
+    bool decompressFrame(std::span<const char> frame, output& out);
+};
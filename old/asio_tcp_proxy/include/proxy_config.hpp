@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+#include <boost/asio/ip/tcp.hpp>
+
+#include <admission_control.hpp>
+#include <backend_set.hpp>
+#include <capture_file.hpp>
+#include <tcp_proxy.hpp>
+
+struct route_config
+{
+    route_options options;
+    std::vector<backend_address> backends;
+    load_balancing_policy policy = load_balancing_policy::round_robin;
+};
+
+struct proxy_config
+{
+    // Zero runs one worker per hardware thread.
+    size_t threads = 0;
+    boost::asio::ip::tcp::endpoint stats{boost::asio::ip::make_address_v4("127.0.0.1"), 25590};
+    std::chrono::steady_clock::duration resolveTimeToLive = std::chrono::seconds(30);
+    admission_options admission;
+    std::optional<capture_options> capture;
+    std::vector<route_config> routes;
+};
+
+// The single route 0.0.0.0:25566 -> localhost:25565 the proxy serves without a config file.
+proxy_config default_proxy_config();
+
+// Reads an INI-style file of [global], [profile NAME] and [route NAME] sections with
+// key = value lines, # starts a comment. Keys may come in any order within a section. Throws
+// std::runtime_error naming the offending line.
+//
+//   [profile low_latency]
+//   quick_ack = true
+//   not_sent_lowat = 16384
+//
+//   [route game]
+//   listen = 0.0.0.0:25566
+//   backend = 10.0.0.1:25565
+//   backend = 10.0.0.2:25565
+//   policy = least_connections
+//   profile = low_latency
+//   impair_latency = 40ms
+//   impair_jitter = 5ms
+proxy_config load_proxy_config(const std::string& path);
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+#include <admission_control.hpp>
+#include <backend_set.hpp>
+#include <capture_file.hpp>
+#include <delay_queue.hpp>
+#include <forwarding_pipe.hpp>
+#include <impairment_stage.hpp>
+#include <logging.hpp>
+#include <metrics.hpp>
+#include <minecraft_protocol.hpp>
+#include <recycling_arena.hpp>
+#include <session_mirror.hpp>
+#include <socket_profile.hpp>
+#include <timing_wheel.hpp>
+
+struct proxy_session_options
+{
+    forwarding_pipe_options clientToServer;
+    forwarding_pipe_options serverToClient;
+    // Parses the Minecraft protocol instead of forwarding opaque bytes when set.
+    std::optional<minecraft_options> minecraft;
+    // Shapes each direction of a session to this rate, zero disables shaping.
+    uint64_t bytesPerSecond = 0;
+    uint64_t burstBytes = 256 * 1024;
+    // Sessions without reads or writes for this long are closed, zero disables the limit.
+    std::chrono::steady_clock::duration idleTimeout = std::chrono::minutes(5);
+    // Shorter limit once one direction has finished, for peers that never close their half.
+    std::chrono::steady_clock::duration halfClosedTimeout = std::chrono::seconds(30);
+    // Copies the client-to-server stream to a shadow backend when set.
+    std::optional<mirror_options> mirror;
+    socket_profile sockets;
+    // Emulates a degraded network in both directions when set, for testing only.
+    std::optional<impairment_options> impairment;
+};
+
+class proxy_session
+    : public std::enable_shared_from_this<proxy_session>
+{
+private:
+    inline static std::atomic<uint64_t> _nextId{0};
+private:
+    boost::asio::io_context& _context;
+    timing_wheel& _timers;
+    boost::asio::ip::tcp::socket _clientSocket;
+    boost::asio::ip::tcp::socket _serverSocket;
+    backend_lease _backend;
+    session_slot _slot;
+    backend_metrics& _metrics;
+    uint64_t _id;
+    forwarding_pipe _clientToServerPipe;
+    forwarding_pipe _serverToClientPipe;
+    std::unique_ptr<impairment_stage> _clientToServerImpairment;
+    std::unique_ptr<impairment_stage> _serverToClientImpairment;
+    direction_counters _clientToServer;
+    direction_counters _serverToClient;
+    std::unique_ptr<minecraft_connection> _minecraft;
+    std::shared_ptr<session_mirror> _mirror;
+    capture_writer* _capture;
+    uint64_t _bytesPerSecond;
+    uint64_t _burstBytes;
+    std::chrono::steady_clock::duration _idleTimeout;
+    std::chrono::steady_clock::duration _halfClosedTimeout;
+    std::chrono::steady_clock::time_point _lastActivity;
+    size_t _openDirections{2};
+    bool _quickAck;
+    bool _cork;
+    wheel_timer _idleTimer;
+public:
+    proxy_session(
+        boost::asio::io_context& context,
+        timing_wheel& timers,
+        delay_queue& delays,
+        boost::asio::ip::tcp::socket clientSocket,
+        boost::asio::ip::tcp::socket serverSocket,
+        backend_lease backend,
+        session_slot slot,
+        std::shared_ptr<session_mirror> mirror,
+        capture_writer* capture,
+        backend_metrics& metrics,
+        const proxy_session_options& options = {}
+    );
+    ~proxy_session();
+public:
+    void start();
+private:
+    void spawnDirection(
+        minecraft_direction direction,
+        boost::asio::ip::tcp::socket& from, boost::asio::ip::tcp::socket& to,
+        forwarding_pipe& pipe, direction_counters& counters, direction_metrics& metrics
+    );
+    boost::asio::awaitable<void> forward(
+        minecraft_direction direction,
+        boost::asio::ip::tcp::socket& from, forwarding_pipe& pipe, direction_counters& counters, direction_metrics& metrics
+    );
+    // Hands a read on to the pipe, through the Minecraft protocol handling when enabled.
+    bool deliver(minecraft_direction direction, forwarding_pipe& pipe, pooled_buffer buffer, size_t size, std::chrono::steady_clock::time_point readAt);
+    boost::asio::awaitable<void> drain(forwarding_pipe& pipe, boost::asio::ip::tcp::socket& from, boost::asio::ip::tcp::socket& to, direction_metrics& metrics);
+    void scheduleIdleTimeout();
+    void onIdleTimeout();
+    // Drops queued data and closes both sockets, the coroutines then finish and release the session.
+    void terminate() noexcept;
+};
+
+template<>
+inline constexpr bool recycles_coroutine_frames<proxy_session> = true;
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <coroutine>
+#include <type_traits>
+#include <utility>
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/version.hpp>
+
+#if BOOST_ASIO_VERSION >= 102201
+#include <boost/asio/bind_allocator.hpp>
+#endif
+
+#include <histogram.hpp>
+
+// Per-thread free lists of small blocks for asynchronous operation state. Every in-flight
+// operation of a session allocates and frees such a block, so keeping them cached on the
+// thread keeps the steady state of the proxy free of heap traffic. Blocks freed on another
+// thread join that thread's lists, like buffer_pool.
+class recycling_arena
+{
+public:
+    constexpr static size_t granularity = 64;
+    constexpr static size_t classCount = 16;
+    constexpr static size_t maxCachedBlocksPerClass = 4096;
+private:
+    struct free_block
+    {
+        free_block* next;
+    };
+private:
+    std::array<free_block*, classCount> _freeBlocks{};
+    std::array<size_t, classCount> _cachedBlocks{};
+    local_counter _allocations;
+    local_counter _heapAllocations;
+    std::atomic<size_t> _cachedBytes{0};
+public:
+    recycling_arena() = default;
+    recycling_arena(const recycling_arena& other) = delete;
+    recycling_arena& operator=(const recycling_arena& other) = delete;
+    ~recycling_arena();
+public:
+    [[nodiscard]] void* allocate(size_t size);
+    void deallocate(void* pointer, size_t size) noexcept;
+public:
+    [[nodiscard]] inline uint64_t allocations() const noexcept
+    {
+        return _allocations.load();
+    }
+    // Allocations the free lists could not serve.
+    [[nodiscard]] inline uint64_t heapAllocations() const noexcept
+    {
+        return _heapAllocations.load();
+    }
+    [[nodiscard]] inline size_t cachedBytes() const noexcept
+    {
+        return _cachedBytes.load(std::memory_order_relaxed);
+    }
+public:
+    [[nodiscard]] static recycling_arena& local() noexcept;
+};
+
+template<typename T>
+class arena_allocator
+{
+public:
+    using value_type = T;
+public:
+    arena_allocator() noexcept = default;
+    template<typename U>
+    arena_allocator(const arena_allocator<U>&) noexcept
+    {
+    }
+public:
+    [[nodiscard]] T* allocate(size_t count)
+    {
+        return static_cast<T*>(recycling_arena::local().allocate(count * sizeof(T)));
+    }
+    void deallocate(T* pointer, size_t count) noexcept
+    {
+        recycling_arena::local().deallocate(pointer, count * sizeof(T));
+    }
+public:
+    template<typename U>
+    friend bool operator==(const arena_allocator&, const arena_allocator<U>&) noexcept
+    {
+        return true;
+    }
+};
+
+// Completion token for the hot-path operations of sessions: use_awaitable with the
+// operation state drawn from the thread's arena. Asio only consults associated allocators
+// bound to tokens from 1.22.1 on, older versions keep their own single-block cache.
+#if BOOST_ASIO_VERSION >= 102201
+inline const auto use_arena = boost::asio::bind_allocator(arena_allocator<void>{}, boost::asio::use_awaitable);
+#else
+inline constexpr auto use_arena = boost::asio::use_awaitable;
+#endif
+
+// Awaitable frame with its storage drawn from the thread's arena. Asio recycles at most one
+// frame per thread and sends the rest to the heap, while every session keeps several
+// coroutines suspended at once.
+template<typename T>
+class arena_awaitable_frame : public boost::asio::detail::awaitable_frame<T, boost::asio::any_io_executor>
+{
+private:
+    using base_frame = boost::asio::detail::awaitable_frame<T, boost::asio::any_io_executor>;
+
+    // Asio's awaiters only accept handles to its own frame type, which is our base.
+    template<typename Awaiter>
+    struct base_frame_awaiter
+    {
+        Awaiter awaiter;
+    public:
+        bool await_ready()
+        {
+            return awaiter.await_ready();
+        }
+        decltype(auto) await_suspend(std::coroutine_handle<arena_awaitable_frame> handle)
+        {
+            return awaiter.await_suspend(std::coroutine_handle<base_frame>::from_promise(handle.promise()));
+        }
+        decltype(auto) await_resume()
+        {
+            return awaiter.await_resume();
+        }
+    };
+public:
+    [[nodiscard]] static void* operator new(size_t size)
+    {
+        return recycling_arena::local().allocate(size);
+    }
+    static void operator delete(void* pointer, size_t size) noexcept
+    {
+        recycling_arena::local().deallocate(pointer, size);
+    }
+public:
+    template<typename Awaitable>
+    auto await_transform(Awaitable&& awaitable)
+    {
+        auto awaiter = base_frame::await_transform(std::forward<Awaitable>(awaitable));
+        return base_frame_awaiter<decltype(awaiter)>{std::move(awaiter)};
+    }
+};
+
+// Set for a class to give its member coroutines, and free coroutines taking it as their
+// first parameter, arena frames. The entry frame co_spawn wraps around them stays Asio's.
+template<typename Owner>
+inline constexpr bool recycles_coroutine_frames = false;
+
+template<typename T, typename Owner, typename... Args>
+    requires recycles_coroutine_frames<std::remove_cvref_t<Owner>>
+struct std::coroutine_traits<boost::asio::awaitable<T>, Owner, Args...>
+{
+    using promise_type = arena_awaitable_frame<T>;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+// Caches resolved endpoints per host:port for a fixed time-to-live. Not thread-safe,
+// each io_context thread is expected to own its cache.
+class resolver_cache
+{
+public:
+    using clock = std::chrono::steady_clock;
+    using results_type = boost::asio::ip::tcp::resolver::results_type;
+private:
+    struct entry
+    {
+        results_type results;
+        clock::time_point expiry;
+    };
+    // Shared with the lookup's handler, which cancels the signal when it completes.
+    struct pending_lookup
+    {
+        boost::asio::steady_timer signal;
+        results_type results;
+        boost::system::error_code error;
+        bool done{false};
+    };
+public:
+    // Lets a timeout stop a resolve() that missed the cache from waiting. The lookup itself
+    // cannot be interrupted, it runs to completion in the background.
+    class abort_handle
+    {
+        friend class resolver_cache;
+    private:
+        std::shared_ptr<pending_lookup> _lookup;
+    public:
+        void abort();
+    };
+private:
+    boost::asio::ip::tcp::resolver _resolver;
+    clock::duration _timeToLive;
+    std::unordered_map<std::string, entry> _entries;
+public:
+    resolver_cache(boost::asio::io_context& context, clock::duration timeToLive);
+public:
+    boost::asio::awaitable<results_type> resolve(std::string_view host, std::string_view port);
+    // Throws operation_aborted once `abort` is used while the lookup is pending.
+    boost::asio::awaitable<results_type> resolve(std::string_view host, std::string_view port, abort_handle& abort);
+    void invalidate(std::string_view host, std::string_view port);
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+#include <forwarding_pipe.hpp>
+#include <metrics.hpp>
+#include <recycling_arena.hpp>
+#include <resolver_cache.hpp>
+#include <timing_wheel.hpp>
+
+enum class mirror_overflow : uint8_t
+{
+    // Skips data that does not fit, the shadow sees a stream with gaps.
+    drop,
+    // Disconnects the shadow, it only ever sees a prefix of the stream.
+    disconnect
+};
+
+struct mirror_options
+{
+    std::string address;
+    std::string port;
+    // Bytes queued for the shadow before the overflow policy applies.
+    size_t maxQueuedBytes = 1024 * 1024;
+    mirror_overflow overflow = mirror_overflow::disconnect;
+    std::chrono::steady_clock::duration connectTimeout = std::chrono::seconds(5);
+};
+
+// Copy of the client-to-server stream of one session sent to a shadow backend, whose
+// responses are discarded. The session only ever hands data over without waiting: whatever
+// the shadow cannot keep up with is dropped or ends the mirror, never delays the session.
+class session_mirror
+    : public std::enable_shared_from_this<session_mirror>
+{
+private:
+    boost::asio::io_context& _context;
+    timing_wheel& _timers;
+    resolver_cache& _resolverCache;
+    mirror_metrics& _metrics;
+    const mirror_options& _options;
+    boost::asio::ip::tcp::socket _socket;
+    forwarding_pipe _pipe;
+public:
+    session_mirror(
+        boost::asio::io_context& context,
+        timing_wheel& timers,
+        resolver_cache& resolverCache,
+        mirror_metrics& metrics,
+        const mirror_options& options
+    );
+    session_mirror(const session_mirror& other) = delete;
+    session_mirror& operator=(const session_mirror& other) = delete;
+public:
+    void start();
+    // Queues a copy of data just written to the primary backend.
+    void copy(std::span<const boost::asio::const_buffer> buffers);
+    // The session ended, the shadow receives what is queued and then the end of stream.
+    void finish() noexcept;
+private:
+    boost::asio::awaitable<void> run();
+    boost::asio::awaitable<void> discardResponses();
+    void disconnect() noexcept;
+};
+
+template<>
+inline constexpr bool recycles_coroutine_frames<session_mirror> = true;
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+
+// Integer socket option meeting Asio's SettableSocketOption requirements, for the options Asio
+// has no type of its own for. Flags are set as 1 and 0.
+template<int Level, int Name>
+class settable_socket_option
+{
+private:
+    int _value;
+public:
+    explicit constexpr settable_socket_option(int value) noexcept
+        : _value(value)
+    {
+    }
+public:
+    template<typename Protocol>
+    [[nodiscard]] constexpr int level(const Protocol&) const noexcept
+    {
+        return Level;
+    }
+    template<typename Protocol>
+    [[nodiscard]] constexpr int name(const Protocol&) const noexcept
+    {
+        return Name;
+    }
+    template<typename Protocol>
+    [[nodiscard]] constexpr const int* data(const Protocol&) const noexcept
+    {
+        return &_value;
+    }
+    template<typename Protocol>
+    [[nodiscard]] constexpr size_t size(const Protocol&) const noexcept
+    {
+        return sizeof(_value);
+    }
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/socket_base.hpp>
+
+// Socket tuning of one route, applied to both the client and the backend socket of its
+// sessions. Zero leaves the kernel default in place.
+struct socket_profile
+{
+    bool noDelay = true;
+    // Re-armed after every read, the kernel drops out of quick ACK mode on its own. Linux only.
+    bool quickAck = false;
+    // Held while a batch of several buffers is written and released once the direction is
+    // drained, so that partial segments only leave at the end of a batch. Linux only.
+    bool cork = false;
+    // Unsent bytes the kernel buffers before a socket stops being writable.
+    int notSentLowWatermark = 0;
+    int receiveBufferSize = 0;
+    int sendBufferSize = 0;
+    // Microseconds to busy poll the device queue on blocking reads and poll. Linux only.
+    int busyPoll = 0;
+    bool keepAlive = false;
+    std::chrono::seconds keepAliveIdle{0};
+    std::chrono::seconds keepAliveInterval{0};
+    int keepAliveCount = 0;
+    int backlog = boost::asio::socket_base::max_listen_connections;
+};
+
+// Options the kernel does not support are skipped, the socket keeps its default for them.
+void apply_socket_profile(boost::asio::ip::tcp::socket& socket, const socket_profile& profile);
+// Buffer sizes set on the listener apply to the window scale negotiated in the handshake.
+void apply_socket_profile(boost::asio::ip::tcp::acceptor& acceptor, const socket_profile& profile);
+void set_quick_ack(boost::asio::ip::tcp::socket& socket) noexcept;
+void set_cork(boost::asio::ip::tcp::socket& socket, bool enabled) noexcept;
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+// Minimal HTTP/1.0 endpoint answering `GET /metrics` with the output of `render`.
+// Meant to be bound to a loopback address.
+boost::asio::awaitable<void> run_stats_server(
+    boost::asio::io_context& context,
+    boost::asio::ip::tcp::endpoint endpoint,
+    std::function<std::string()> render
+);
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+#include <admission_control.hpp>
+#include <backend_connection_pool.hpp>
+#include <backend_set.hpp>
+#include <capture_file.hpp>
+#include <delay_queue.hpp>
+#include <metrics.hpp>
+#include <proxy_session.hpp>
+#include <recycling_arena.hpp>
+#include <resolver_cache.hpp>
+#include <timing_wheel.hpp>
+#include <udp_proxy.hpp>
+
+struct route_options
+{
+    std::string name = "default";
+    boost::asio::ip::tcp::endpoint listen{boost::asio::ip::tcp::v4(), 25566};
+    proxy_session_options session;
+    backend_connection_pool_options backendPool;
+    // Relays UDP on the listening port as well when set.
+    std::optional<udp_proxy_options> udp;
+};
+
+class proxy_worker;
+
+// The part of one listener-to-backends route that belongs to a worker.
+class worker_route
+{
+private:
+    route_options _options;
+    backend_set& _backends;
+    worker_metrics _metrics;
+    std::vector<std::unique_ptr<backend_connection_pool>> _backendPools;
+    std::unique_ptr<udp_proxy> _udpProxy;
+public:
+    worker_route(proxy_worker& worker, const route_options& options, backend_set& backends);
+    worker_route(const worker_route& other) = delete;
+    worker_route& operator=(const worker_route& other) = delete;
+public:
+    [[nodiscard]] inline const route_options& options() const noexcept
+    {
+        return _options;
+    }
+    [[nodiscard]] inline const proxy_session_options& sessionOptions() const noexcept
+    {
+        return _options.session;
+    }
+    [[nodiscard]] inline backend_set& backends() const noexcept
+    {
+        return _backends;
+    }
+    [[nodiscard]] inline worker_metrics& metrics() noexcept
+    {
+        return _metrics;
+    }
+    [[nodiscard]] inline const worker_metrics& metrics() const noexcept
+    {
+        return _metrics;
+    }
+    [[nodiscard]] inline backend_connection_pool& backendPool(size_t backendIndex) noexcept
+    {
+        return *_backendPools[backendIndex];
+    }
+public:
+    void start();
+};
+
+// State owned by a single io_context thread. Everything except the shared backend sets is
+// only ever touched from the thread running the worker's context. Every worker serves all
+// routes of the process.
+class proxy_worker
+{
+private:
+    size_t _index;
+    boost::asio::io_context _context{1};
+    boost::asio::executor_work_guard<boost::asio::io_context::executor_type> _workGuard;
+    timing_wheel _timers;
+    delay_queue _delays;
+    resolver_cache _resolverCache;
+    std::vector<std::unique_ptr<worker_route>> _routes;
+    std::unique_ptr<capture_writer> _capture;
+    // Arena of the thread running the worker, published for scrapes. The lock keeps the
+    // thread from exiting, and destroying the arena, while a scrape reads it.
+    mutable std::mutex _arenaMutex;
+    const recycling_arena* _arena{nullptr};
+public:
+    proxy_worker(size_t index, std::chrono::steady_clock::duration resolveTimeToLive);
+    proxy_worker(const proxy_worker& other) = delete;
+    proxy_worker& operator=(const proxy_worker& other) = delete;
+public:
+    [[nodiscard]] inline size_t index() const noexcept
+    {
+        return _index;
+    }
+    [[nodiscard]] inline boost::asio::io_context& context() noexcept
+    {
+        return _context;
+    }
+    [[nodiscard]] inline timing_wheel& timers() noexcept
+    {
+        return _timers;
+    }
+    [[nodiscard]] inline delay_queue& delays() noexcept
+    {
+        return _delays;
+    }
+    [[nodiscard]] inline resolver_cache& resolverCache() noexcept
+    {
+        return _resolverCache;
+    }
+    // Null unless capturing.
+    [[nodiscard]] inline capture_writer* captureWriter() noexcept
+    {
+        return _capture.get();
+    }
+    [[nodiscard]] inline size_t routeCount() const noexcept
+    {
+        return _routes.size();
+    }
+    [[nodiscard]] inline worker_route& route(size_t routeIndex) noexcept
+    {
+        return *_routes[routeIndex];
+    }
+    [[nodiscard]] inline const worker_route& route(size_t routeIndex) const noexcept
+    {
+        return *_routes[routeIndex];
+    }
+    // Calls `visit` with the arena of the thread running the worker, unless it is not running.
+    template<typename Visitor>
+    void visitArena(Visitor&& visit) const
+    {
+        std::lock_guard lock(_arenaMutex);
+        if(_arena != nullptr)
+            visit(*_arena);
+    }
+public:
+    // Routes are added in the same order to every worker, the index identifies them.
+    size_t addRoute(const route_options& options, backend_set& backends);
+    // Records the traffic of all TCP sessions of the worker into capture files.
+    void capture(const capture_options& options);
+    void start();
+    void run();
+    void stop();
+};
+
+// Covers start_proxy_session, which runs once per accepted client.
+template<>
+inline constexpr bool recycles_coroutine_frames<proxy_worker> = true;
+
+boost::asio::awaitable<void> start_tcp_proxy(
+    boost::asio::io_context& acceptContext,
+    std::span<const std::unique_ptr<proxy_worker>> workers,
+    size_t routeIndex,
+    admission_control& admission
+);
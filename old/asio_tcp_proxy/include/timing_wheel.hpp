@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+class timing_wheel;
+
+class timer_list_node
+{
+    friend class timing_wheel;
+private:
+    timer_list_node* _next{};
+    timer_list_node* _previous{};
+};
+
+// Deadline registered with a timing_wheel. The callback runs on the wheel's thread once the
+// deadline has passed, at most one resolution late. Owners usually embed the timer and keep
+// it scheduled at a coarse deadline, checking on expiry whether it actually applies yet.
+class wheel_timer
+    : private timer_list_node
+{
+    friend class timing_wheel;
+private:
+    timing_wheel* _wheel{};
+    uint64_t _expiryTick{};
+    std::function<void()> _callback;
+public:
+    explicit wheel_timer(std::function<void()> callback);
+    wheel_timer(const wheel_timer& other) = delete;
+    wheel_timer& operator=(const wheel_timer& other) = delete;
+    ~wheel_timer();
+public:
+    [[nodiscard]] inline bool scheduled() const noexcept
+    {
+        return _wheel != nullptr;
+    }
+    void cancel() noexcept;
+};
+
+// Hierarchical timing wheel of one io_context thread: scheduling and cancelling are O(1)
+// and all deadlines share a single steady_timer, which only ticks while timers are pending.
+// Level n has 64 slots of 64^n ticks each; timers move down a level when their slot comes up.
+class timing_wheel
+{
+    friend class wheel_timer;
+public:
+    using clock = std::chrono::steady_clock;
+    constexpr static size_t slotBits = 6;
+    constexpr static size_t slotsPerLevel = size_t{1} << slotBits;
+    constexpr static size_t levelCount = 4;
+private:
+    boost::asio::steady_timer _timer;
+    clock::duration _resolution;
+    clock::time_point _origin;
+    uint64_t _currentTick{0};
+    size_t _size{0};
+    std::array<std::array<timer_list_node, slotsPerLevel>, levelCount> _slots;
+    timer_list_node _expiring;
+public:
+    explicit timing_wheel(boost::asio::io_context& context, clock::duration resolution = std::chrono::milliseconds(100));
+    timing_wheel(const timing_wheel& other) = delete;
+    timing_wheel& operator=(const timing_wheel& other) = delete;
+    ~timing_wheel();
+public:
+    void start();
+    // Reschedules the timer if it is already scheduled.
+    void schedule(wheel_timer& timer, clock::time_point deadline);
+    [[nodiscard]] inline size_t size() const noexcept
+    {
+        return _size;
+    }
+    [[nodiscard]] inline clock::duration resolution() const noexcept
+    {
+        return _resolution;
+    }
+private:
+    boost::asio::awaitable<void> run();
+    void advance(uint64_t tick);
+    void insert(wheel_timer& timer) noexcept;
+    void cascade(size_t level) noexcept;
+    void remove(wheel_timer& timer) noexcept;
+    [[nodiscard]] uint64_t tickOf(clock::time_point time) const noexcept;
+private:
+    static void link(timer_list_node& list, timer_list_node& node) noexcept;
+    static void unlink(timer_list_node& node) noexcept;
+    static void splice(timer_list_node& from, timer_list_node& to) noexcept;
+};
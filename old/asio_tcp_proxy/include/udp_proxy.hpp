@@ -0,0 +1,106 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/udp.hpp>
+
+#include <backend_set.hpp>
+#include <datagram_batch.hpp>
+#include <metrics.hpp>
+#include <resolver_cache.hpp>
+#include <timing_wheel.hpp>
+
+struct udp_proxy_options
+{
+    std::chrono::steady_clock::duration flowIdleTimeout = std::chrono::seconds(60);
+    size_t maxFlows = 64 * 1024;
+    size_t batchSize = 64;
+    size_t maxDatagramSize = 2048;
+    // Datagrams of a flow that arrive while its backend address is still being resolved.
+    size_t maxPendingDatagrams = 64;
+    int socketBufferSize = 4 * 1024 * 1024;
+    // Receive with UDP_GRO and send with UDP_SEGMENT, which needs 64 KiB batch slots.
+    bool genericOffload = false;
+};
+
+// UDP relay of one worker. On Linux every worker binds its own SO_REUSEPORT socket to the
+// listening port, so the kernel keeps each client flow on one worker and the NAT table needs
+// no locking. Elsewhere only the first worker relays UDP. Each flow gets its own socket connected to the selected backend, replies are
+// sent back from the listening socket. Both directions move datagrams in batches.
+class udp_proxy
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    // Whether every worker can bind the listening port.
+#if defined(__linux__)
+    constexpr static bool sharedListeningPort = true;
+#else
+    constexpr static bool sharedListeningPort = false;
+#endif
+private:
+    struct flow
+    {
+        boost::asio::ip::udp::endpoint client;
+        boost::asio::ip::udp::socket socket;
+        backend_lease backend;
+        clock::time_point lastActivity;
+        wheel_timer idleTimer;
+        std::vector<std::vector<char>> pending;
+        bool connected{false};
+        bool closed{false};
+    public:
+        flow(
+            const boost::asio::ip::udp::endpoint& client,
+            boost::asio::ip::udp::socket socket,
+            backend_lease backend,
+            clock::time_point lastActivity,
+            std::function<void()> onIdle
+        );
+    };
+
+    struct endpoint_hash
+    {
+        [[nodiscard]] size_t operator()(const boost::asio::ip::udp::endpoint& endpoint) const noexcept;
+    };
+private:
+    boost::asio::io_context& _context;
+    timing_wheel& _timers;
+    backend_set& _backends;
+    resolver_cache& _resolverCache;
+    udp_metrics& _metrics;
+    udp_proxy_options _options;
+    boost::asio::ip::udp::socket _socket;
+    datagram_batch _batch;
+    std::unordered_map<boost::asio::ip::udp::endpoint, std::shared_ptr<flow>, endpoint_hash> _flows;
+public:
+    udp_proxy(
+        boost::asio::io_context& context,
+        timing_wheel& timers,
+        backend_set& backends,
+        resolver_cache& resolverCache,
+        udp_metrics& metrics,
+        const boost::asio::ip::udp::endpoint& listen,
+        const udp_proxy_options& options
+    );
+    udp_proxy(const udp_proxy& other) = delete;
+    udp_proxy& operator=(const udp_proxy& other) = delete;
+public:
+    void start();
+private:
+    boost::asio::awaitable<void> receiveFromClients();
+    boost::asio::awaitable<void> receiveFromBackend(std::shared_ptr<flow> flow);
+    boost::asio::awaitable<void> connectFlow(std::shared_ptr<flow> flow);
+    [[nodiscard]] flow* findOrOpenFlow(const boost::asio::ip::udp::endpoint& client, clock::time_point now);
+    // Closes the flow of `client` once it has been idle for the flow timeout.
+    void expireFlow(const boost::asio::ip::udp::endpoint& client);
+    void closeFlow(flow& flow) noexcept;
+    void configureSocket(boost::asio::ip::udp::socket& socket);
+};
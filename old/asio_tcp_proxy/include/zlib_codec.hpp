@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
+
+#if defined(ASIO_TCP_PROXY_LIBDEFLATE)
+struct libdeflate_compressor;
+struct libdeflate_decompressor;
+#else
+#include <zlib.h>
+#endif
+
+// Per-thread compressor and decompressor for zlib-format streams. Uses libdeflate when the
+// proxy is built against it, which compresses whole buffers considerably faster than zlib.
+class zlib_codec
+{
+private:
+    int _level{-1};
+#if defined(ASIO_TCP_PROXY_LIBDEFLATE)
+    libdeflate_compressor* _compressor{};
+    libdeflate_decompressor* _decompressor{};
+#else
+    std::unique_ptr<z_stream> _deflateStream;
+    std::unique_ptr<z_stream> _inflateStream;
+#endif
+public:
+    zlib_codec();
+    zlib_codec(const zlib_codec& other) = delete;
+    zlib_codec& operator=(const zlib_codec& other) = delete;
+    ~zlib_codec();
+public:
+    // Compresses `data` into `out`, which is resized to fit. Returns the compressed size.
+    size_t compress(std::span<const char> data, std::vector<char>& out, int level);
+    // Decompresses `data`, which must expand to exactly `out.size()` bytes.
+    [[nodiscard]] bool decompress(std::span<const char> data, std::span<char> out);
+public:
+    [[nodiscard]] static zlib_codec& local();
+};
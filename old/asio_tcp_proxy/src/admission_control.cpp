@@ -0,0 +1,211 @@
+#include <admission_control.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <tuple>
+
+namespace
+{
+    // Emission interval and burst tolerance of the generic cell rate algorithm, in nanoseconds.
+    std::pair<uint64_t, uint64_t> to_interval(const rate_limit& limit) noexcept
+    {
+        if(limit.rate <= 0.0)
+            return {0, 0};
+
+        const auto interval = std::max<uint64_t>(1, static_cast<uint64_t>(1e9 / limit.rate));
+        const auto tolerance = static_cast<uint64_t>(static_cast<double>(interval) * std::max(limit.burst - 1.0, 0.0));
+        return {interval, tolerance};
+    }
+
+    uint64_t to_nanoseconds(std::chrono::steady_clock::time_point time) noexcept
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count());
+    }
+
+    uint64_t mix(uint64_t value) noexcept
+    {
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccdull;
+        value ^= value >> 33;
+        return value;
+    }
+}
+
+std::string_view to_string(admission_result result) noexcept
+{
+    switch (result)
+    {
+    case admission_result::admitted:
+        return "admitted";
+    case admission_result::address_rate_limited:
+        return "address_rate";
+    case admission_result::accept_rate_limited:
+        return "accept_rate";
+    case admission_result::session_limit:
+        return "max_sessions";
+    }
+    return "unknown";
+}
+
+bool atomic_rate_limiter::allow(uint64_t now, uint64_t interval, uint64_t tolerance) noexcept
+{
+    auto arrival = _theoreticalArrival.load(std::memory_order_relaxed);
+    while(true)
+    {
+        const auto next = std::max(arrival, now) + interval;
+        if(next - now > tolerance + interval)
+            return false;
+
+        if(_theoreticalArrival.compare_exchange_weak(arrival, next, std::memory_order_relaxed))
+            return true;
+    }
+}
+
+//----------------------------------------------------------------------
+
+address_rate_table::address_rate_table(size_t size)
+    : _slots(std::make_unique<slot[]>(std::bit_ceil(std::max<size_t>(size, maxProbes))))
+    , _mask(std::bit_ceil(std::max<size_t>(size, maxProbes)) - 1)
+{
+}
+
+bool address_rate_table::allow(const boost::asio::ip::address& address, uint64_t now, uint64_t interval, uint64_t tolerance) noexcept
+{
+    const auto addressKey = key(address);
+    const auto start = mix(addressKey);
+
+    slot* oldest = nullptr;
+    auto oldestArrival = std::numeric_limits<uint64_t>::max();
+
+    for(size_t probe = 0; probe < maxProbes; ++probe)
+    {
+        auto& candidate = _slots[(start + probe) & _mask];
+
+        auto current = candidate.key.load(std::memory_order_acquire);
+        if(current == 0 && candidate.key.compare_exchange_strong(current, addressKey, std::memory_order_acq_rel))
+            return candidate.limiter.allow(now, interval, tolerance);
+        if(current == addressKey)
+            return candidate.limiter.allow(now, interval, tolerance);
+
+        const auto arrival = candidate.limiter.theoreticalArrival();
+        if(arrival < oldestArrival)
+        {
+            oldest = &candidate;
+            oldestArrival = arrival;
+        }
+    }
+
+    // Losing the race for the evicted slot just lets this one accept through.
+    auto evicted = oldest->key.load(std::memory_order_relaxed);
+    if(oldest->key.compare_exchange_strong(evicted, addressKey, std::memory_order_acq_rel))
+        oldest->limiter.reset();
+    return oldest->limiter.allow(now, interval, tolerance);
+}
+
+uint64_t address_rate_table::key(const boost::asio::ip::address& address) noexcept
+{
+    uint64_t value = 0;
+    if(address.is_v4())
+    {
+        value = address.to_v4().to_uint();
+    }
+    else if(const auto v6 = address.to_v6(); v6.is_v4_mapped())
+    {
+        value = boost::asio::ip::make_address_v4(boost::asio::ip::v4_mapped, v6).to_uint();
+    }
+    else
+    {
+        const auto bytes = v6.to_bytes();
+        for(size_t index = 0; index < 8; ++index)
+            value = (value << 8) | bytes[index];
+        value = mix(value) | (uint64_t{1} << 63);
+    }
+
+    // Zero marks an empty slot.
+    return value | (uint64_t{1} << 32);
+}
+
+//----------------------------------------------------------------------
+
+session_slot::session_slot(admission_control& admission) noexcept
+    : _admission(&admission)
+{
+}
+
+session_slot::session_slot(session_slot&& other) noexcept
+    : _admission(std::exchange(other._admission, nullptr))
+{
+}
+
+session_slot& session_slot::operator=(session_slot&& other) noexcept
+{
+    if(&other == this)
+        return *this;
+
+    if(_admission != nullptr)
+        _admission->_activeSessions.fetch_sub(1, std::memory_order_relaxed);
+    _admission = std::exchange(other._admission, nullptr);
+
+    return *this;
+}
+
+session_slot::~session_slot()
+{
+    if(_admission != nullptr)
+        _admission->_activeSessions.fetch_sub(1, std::memory_order_relaxed);
+}
+
+admission_control::admission_control(const admission_options& options)
+    : _options(options)
+    , _addresses(options.addressTableSize)
+{
+    std::tie(_addressInterval, _addressTolerance) = to_interval(options.perAddress);
+    std::tie(_acceptInterval, _acceptTolerance) = to_interval(options.accepts);
+}
+
+admission_result admission_control::admit(const boost::asio::ip::address& address, std::chrono::steady_clock::time_point now, session_slot& slot) noexcept
+{
+    const auto nanoseconds = to_nanoseconds(now);
+
+    if(_addressInterval != 0 && !_addresses.allow(address, nanoseconds, _addressInterval, _addressTolerance))
+        return admission_result::address_rate_limited;
+    if(_acceptInterval != 0 && !_accepts.allow(nanoseconds, _acceptInterval, _acceptTolerance))
+        return admission_result::accept_rate_limited;
+
+    if(_activeSessions.fetch_add(1, std::memory_order_relaxed) >= _options.maxSessions && _options.maxSessions != 0)
+    {
+        _activeSessions.fetch_sub(1, std::memory_order_relaxed);
+        return admission_result::session_limit;
+    }
+
+    slot = session_slot(*this);
+    return admission_result::admitted;
+}
+
+//----------------------------------------------------------------------
+
+byte_rate_limiter::byte_rate_limiter(uint64_t bytesPerSecond, uint64_t burstBytes, clock::time_point now) noexcept
+    : _bytesPerSecond(static_cast<double>(bytesPerSecond))
+    , _burstBytes(static_cast<double>(burstBytes))
+    , _tokens(static_cast<double>(burstBytes))
+    , _updatedAt(now)
+{
+}
+
+byte_rate_limiter::clock::duration byte_rate_limiter::delay(clock::time_point now) noexcept
+{
+    const auto elapsed = std::chrono::duration<double>(now - _updatedAt).count();
+    _tokens = std::min(_burstBytes, _tokens + elapsed * _bytesPerSecond);
+    _updatedAt = now;
+
+    if(_tokens >= 0.0)
+        return clock::duration::zero();
+
+    return std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(-_tokens / _bytesPerSecond));
+}
+
+void byte_rate_limiter::consume(size_t bytes) noexcept
+{
+    _tokens -= static_cast<double>(bytes);
+}
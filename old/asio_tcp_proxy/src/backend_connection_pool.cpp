@@ -0,0 +1,182 @@
+#include <backend_connection_pool.hpp>
+
+#include <algorithm>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/connect.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include <logging.hpp>
+
+using boost::asio::ip::tcp;
+using boost::asio::awaitable;
+using boost::asio::use_awaitable;
+
+backend_connection_pool::backend_connection_pool(
+    boost::asio::io_context& context,
+    timing_wheel& timers,
+    resolver_cache& resolverCache,
+    backend& backend,
+    backend_metrics& metrics,
+    const health_check_options& healthCheckOptions,
+    const backend_connection_pool_options& options
+)
+    : _context(context)
+    , _timers(timers)
+    , _resolverCache(resolverCache)
+    , _backend(backend)
+    , _metrics(metrics)
+    , _healthCheckOptions(healthCheckOptions)
+    , _options(options)
+    , _retryDelay(options.minRetryDelay)
+    , _wakeup(context)
+{
+}
+
+void backend_connection_pool::start()
+{
+    boost::asio::co_spawn(_context, replenish(), boost::asio::detached);
+}
+
+awaitable<tcp::socket> backend_connection_pool::acquire()
+{
+    const auto now = clock::now();
+    while(!_idleConnections.empty())
+    {
+        auto connection = std::move(_idleConnections.front());
+        _idleConnections.pop_front();
+
+        if(now - connection.established > _options.maxIdleAge || !isAlive(connection.socket))
+            continue;
+
+        _wakeup.cancel();
+        co_return std::move(connection.socket);
+    }
+
+    _wakeup.cancel();
+    co_return co_await connect();
+}
+
+// The timeout covers the lookup as well: it stops waiting for a lookup that missed the cache,
+// and closing the socket aborts the connect, including the remaining endpoints.
+awaitable<tcp::socket> backend_connection_pool::connect()
+{
+    tcp::socket socket(_context);
+    resolver_cache::abort_handle lookup;
+    bool timedOut = false;
+    wheel_timer timeout([&]{
+        timedOut = true;
+        lookup.abort();
+        boost::system::error_code error;
+        socket.close(error);
+    });
+    _timers.schedule(timeout, clock::now() + _options.connectTimeout);
+
+    bool resolved = false;
+    try
+    {
+        const auto endpoints = co_await _resolverCache.resolve(_backend.address(), _backend.port(), lookup);
+        resolved = true;
+        // The timeout may have fired after the lookup completed, async_connect would reopen the socket.
+        if(timedOut)
+            throw boost::system::system_error(boost::asio::error::timed_out);
+
+        const auto started = clock::now();
+        co_await boost::asio::async_connect(socket, endpoints, use_awaitable);
+        timeout.cancel();
+
+        const auto latency = clock::now() - started;
+        _metrics.connectLatency.record(latency);
+        _backend.recordConnectSuccess(latency, _healthCheckOptions);
+    }
+    catch (const std::exception&)
+    {
+        // Only a failed lookup, or endpoints that all failed, suggest the cached addresses are
+        // stale; a connect cut short by the timeout says nothing about them.
+        if(!resolved || !timedOut)
+            _resolverCache.invalidate(_backend.address(), _backend.port());
+        _backend.recordConnectFailure(_healthCheckOptions);
+        if(timedOut)
+            throw boost::system::system_error(boost::asio::error::timed_out);
+        throw;
+    }
+
+    co_return socket;
+}
+
+awaitable<void> backend_connection_pool::replenish()
+{
+    while(true)
+    {
+        pruneStale();
+
+        if(_backend.healthy() && _idleConnections.size() + _pendingConnections < _options.idleConnections)
+            ++_refillRound;
+        while(_backend.healthy() && _idleConnections.size() + _pendingConnections < _options.idleConnections)
+        {
+            ++_pendingConnections;
+            boost::asio::co_spawn(_context, establishIdleConnection(_refillRound), boost::asio::detached);
+        }
+
+        boost::system::error_code error;
+        _wakeup.expires_after(_options.maxIdleAge / 2);
+        co_await _wakeup.async_wait(boost::asio::redirect_error(use_awaitable, error));
+    }
+}
+
+awaitable<void> backend_connection_pool::establishIdleConnection(uint64_t round)
+{
+    bool failed = false;
+    try
+    {
+        auto socket = co_await connect();
+        _idleConnections.push_back({std::move(socket), clock::now()});
+        _retryDelay = _options.minRetryDelay;
+    }
+    catch (const std::exception& exception)
+    {
+        log_message(_backend.healthy() ? log_level::warning : log_level::debug, "Failed to pre-establish connection to {}:{}, {}", _backend.address(), _backend.port(), exception.what());
+        failed = true;
+    }
+
+    if(failed)
+    {
+        boost::asio::steady_timer backoff(_context, _retryDelay);
+        if(round != _backedOffRound)
+        {
+            _backedOffRound = round;
+            _retryDelay = std::min(_retryDelay * 2, _options.maxRetryDelay);
+        }
+
+        boost::system::error_code error;
+        co_await backoff.async_wait(boost::asio::redirect_error(use_awaitable, error));
+    }
+
+    --_pendingConnections;
+    _wakeup.cancel();
+}
+
+void backend_connection_pool::pruneStale()
+{
+    const auto now = clock::now();
+    std::erase_if(_idleConnections, [&](idle_connection& connection){
+        return now - connection.established > _options.maxIdleAge || !isAlive(connection.socket);
+    });
+}
+
+bool backend_connection_pool::isAlive(tcp::socket& socket)
+{
+    char probe;
+    boost::system::error_code error;
+
+    socket.non_blocking(true, error);
+    if(error)
+        return false;
+
+    const auto bytesPeeked = socket.receive(boost::asio::buffer(&probe, 1), tcp::socket::message_peek, error);
+    if(error == boost::asio::error::would_block)
+        return true;
+
+    return !error && bytesPeeked != 0;
+}
@@ -0,0 +1,317 @@
+#include <backend_set.hpp>
+
+#include <algorithm>
+#include <format>
+#include <random>
+#include <stdexcept>
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include <logging.hpp>
+
+using boost::asio::ip::tcp;
+using boost::asio::awaitable;
+using boost::asio::use_awaitable;
+
+namespace
+{
+    constexpr uint64_t fnv1a(std::string_view data, uint64_t hash = 0xcbf29ce484222325ull) noexcept
+    {
+        for(const auto c : data)
+        {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    uint64_t hash_address(const boost::asio::ip::address& address) noexcept
+    {
+        if(address.is_v4())
+        {
+            const auto bytes = address.to_v4().to_bytes();
+            return fnv1a({reinterpret_cast<const char*>(bytes.data()), bytes.size()});
+        }
+
+        const auto bytes = address.to_v6().to_bytes();
+        return fnv1a({reinterpret_cast<const char*>(bytes.data()), bytes.size()});
+    }
+}
+
+std::string_view to_string(load_balancing_policy policy) noexcept
+{
+    switch (policy)
+    {
+    case load_balancing_policy::round_robin:
+        return "round_robin";
+    case load_balancing_policy::least_connections:
+        return "least_connections";
+    case load_balancing_policy::power_of_two_choices:
+        return "power_of_two_choices";
+    case load_balancing_policy::consistent_hashing:
+        return "consistent_hashing";
+    }
+    return "unknown";
+}
+
+std::optional<load_balancing_policy> parse_load_balancing_policy(std::string_view name) noexcept
+{
+    for(const auto policy : {
+        load_balancing_policy::round_robin,
+        load_balancing_policy::least_connections,
+        load_balancing_policy::power_of_two_choices,
+        load_balancing_policy::consistent_hashing
+    })
+    {
+        if(to_string(policy) == name)
+            return policy;
+    }
+    return std::nullopt;
+}
+
+//----------------------------------------------------------------------
+
+backend::backend(backend_address address, size_t index)
+    : _address(std::move(address))
+    , _index(index)
+{
+}
+
+void backend::recordConnectSuccess(std::chrono::steady_clock::duration latency, const health_check_options& options) noexcept
+{
+    const auto sample = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+    uint64_t average = _connectLatencyMicroseconds.load(std::memory_order_relaxed);
+    while(!_connectLatencyMicroseconds.compare_exchange_weak(
+        average,
+        average == 0 ? sample : average - average / 8 + sample / 8,
+        std::memory_order_relaxed,
+        std::memory_order_relaxed
+        )
+    );
+
+    _consecutiveFailures.store(0, std::memory_order_relaxed);
+    if(healthy())
+        return;
+
+    if(_consecutiveSuccesses.fetch_add(1, std::memory_order_relaxed) + 1 < options.successesToRestore)
+        return;
+
+    _consecutiveSuccesses.store(0, std::memory_order_relaxed);
+    if(!_healthy.exchange(true, std::memory_order_relaxed))
+        log_message(log_level::info, "Backend {}:{} is healthy again", address(), port());
+}
+
+void backend::recordConnectFailure(const health_check_options& options) noexcept
+{
+    _failedConnections.fetch_add(1, std::memory_order_relaxed);
+    _consecutiveSuccesses.store(0, std::memory_order_relaxed);
+
+    if(_consecutiveFailures.fetch_add(1, std::memory_order_relaxed) + 1 < options.failuresToEject)
+        return;
+
+    if(_healthy.exchange(false, std::memory_order_relaxed))
+        log_message(log_level::warning, "Backend {}:{} ejected after {} consecutive failures", address(), port(), options.failuresToEject);
+}
+
+//----------------------------------------------------------------------
+
+backend_lease::backend_lease(backend& backend) noexcept
+    : _backend(&backend)
+{
+    _backend->connectionOpened();
+}
+
+backend_lease::backend_lease(backend_lease&& other) noexcept
+    : _backend(std::exchange(other._backend, nullptr))
+{
+}
+
+backend_lease& backend_lease::operator=(backend_lease&& other) noexcept
+{
+    if(&other == this)
+        return *this;
+
+    if(_backend != nullptr)
+        _backend->connectionClosed();
+    _backend = std::exchange(other._backend, nullptr);
+
+    return *this;
+}
+
+backend_lease::~backend_lease()
+{
+    if(_backend != nullptr)
+        _backend->connectionClosed();
+}
+
+//----------------------------------------------------------------------
+
+backend_set::backend_set(std::vector<backend_address> addresses, load_balancing_policy policy, const health_check_options& healthCheckOptions)
+    : _policy(policy)
+    , _healthCheckOptions(healthCheckOptions)
+{
+    if(addresses.empty())
+        throw std::invalid_argument("backend set requires at least one backend");
+
+    _backends.reserve(addresses.size());
+    for(auto& address : addresses)
+        _backends.push_back(std::make_unique<backend>(std::move(address), _backends.size()));
+
+    _hashRing.reserve(_backends.size() * virtualNodesPerBackend);
+    for(const auto& backend : _backends)
+    {
+        for(size_t virtualNode = 0; virtualNode < virtualNodesPerBackend; ++virtualNode)
+        {
+            const auto key = std::format("{}:{}#{}", backend->address(), backend->port(), virtualNode);
+            _hashRing.emplace_back(fnv1a(key), backend->index());
+        }
+    }
+    std::ranges::sort(_hashRing);
+}
+
+backend_lease backend_set::select(const boost::asio::ip::address& clientAddress)
+{
+    const auto healthy = anyHealthy();
+
+    switch (_policy)
+    {
+    case load_balancing_policy::round_robin:
+        return backend_lease{selectRoundRobin(healthy)};
+    case load_balancing_policy::least_connections:
+        return backend_lease{selectLeastConnections(healthy)};
+    case load_balancing_policy::power_of_two_choices:
+        return backend_lease{selectPowerOfTwoChoices(healthy)};
+    case load_balancing_policy::consistent_hashing:
+        return backend_lease{selectConsistentHashing(clientAddress, healthy)};
+    }
+
+    return backend_lease{*_backends.front()};
+}
+
+// When every backend is ejected the selection fails open and ignores health altogether.
+backend& backend_set::selectRoundRobin(bool anyHealthy)
+{
+    for(size_t attempt = 0; attempt < _backends.size(); ++attempt)
+    {
+        auto& backend = *_backends[_nextRoundRobin.fetch_add(1, std::memory_order_relaxed) % _backends.size()];
+        if(!anyHealthy || backend.healthy())
+            return backend;
+    }
+    return *_backends.front();
+}
+
+backend& backend_set::selectLeastConnections(bool anyHealthy)
+{
+    backend* selected = nullptr;
+    for(const auto& backend : _backends)
+    {
+        if(anyHealthy && !backend->healthy())
+            continue;
+
+        if(selected == nullptr || backend->activeConnections() < selected->activeConnections())
+            selected = backend.get();
+    }
+    return *selected;
+}
+
+backend& backend_set::selectPowerOfTwoChoices(bool anyHealthy)
+{
+    thread_local std::minstd_rand random{std::random_device{}()};
+
+    if(_backends.size() == 1)
+        return *_backends.front();
+
+    std::uniform_int_distribution<size_t> distribution(0, _backends.size() - 1);
+
+    const auto pick = [&]() -> backend& {
+        for(size_t attempt = 0; attempt < _backends.size(); ++attempt)
+        {
+            auto& backend = *_backends[distribution(random)];
+            if(!anyHealthy || backend.healthy())
+                return backend;
+        }
+        return selectRoundRobin(anyHealthy);
+    };
+
+    auto& first = pick();
+    auto& second = pick();
+    return second.activeConnections() < first.activeConnections() ? second : first;
+}
+
+backend& backend_set::selectConsistentHashing(const boost::asio::ip::address& clientAddress, bool anyHealthy)
+{
+    const auto hash = hash_address(clientAddress);
+    const auto start = std::ranges::lower_bound(_hashRing, std::make_pair(hash, size_t{0}));
+    const auto startOffset = static_cast<size_t>(start - _hashRing.begin());
+
+    for(size_t offset = 0; offset < _hashRing.size(); ++offset)
+    {
+        auto& backend = *_backends[_hashRing[(startOffset + offset) % _hashRing.size()].second];
+        if(!anyHealthy || backend.healthy())
+            return backend;
+    }
+    return *_backends.front();
+}
+
+bool backend_set::anyHealthy() const noexcept
+{
+    return std::ranges::any_of(_backends, [](const auto& backend){ return backend->healthy(); });
+}
+
+awaitable<void> backend_set::runHealthChecks(boost::asio::io_context& context)
+{
+    boost::asio::steady_timer interval(context);
+
+    while(true)
+    {
+        for(const auto& backend : _backends)
+        {
+            if(co_await checkHealth(context, *backend))
+                continue;
+
+            log_message(log_level::debug, "Health check of {}:{} failed", backend->address(), backend->port());
+        }
+
+        boost::system::error_code error;
+        interval.expires_after(_healthCheckOptions.interval);
+        co_await interval.async_wait(boost::asio::redirect_error(use_awaitable, error));
+    }
+}
+
+awaitable<bool> backend_set::checkHealth(boost::asio::io_context& context, backend& backend)
+{
+    auto resolver = std::make_shared<tcp::resolver>(context);
+    auto socket = std::make_shared<tcp::socket>(context);
+    boost::asio::steady_timer timeout(context, _healthCheckOptions.timeout);
+    timeout.async_wait([resolver, socket](const boost::system::error_code& error){
+        if(error)
+            return;
+
+        // Whichever step is still running fails with operation_aborted.
+        resolver->cancel();
+        boost::system::error_code closeError;
+        socket->close(closeError);
+    });
+
+    boost::system::error_code error;
+    auto started = std::chrono::steady_clock::now();
+    const auto endpoints = co_await resolver->async_resolve(backend.address(), backend.port(), boost::asio::redirect_error(use_awaitable, error));
+    if(!error)
+    {
+        started = std::chrono::steady_clock::now();
+        co_await boost::asio::async_connect(*socket, endpoints, boost::asio::redirect_error(use_awaitable, error));
+    }
+    timeout.cancel();
+
+    if(error)
+    {
+        backend.recordConnectFailure(_healthCheckOptions);
+        co_return false;
+    }
+
+    backend.recordConnectSuccess(std::chrono::steady_clock::now() - started, _healthCheckOptions);
+    co_return true;
+}
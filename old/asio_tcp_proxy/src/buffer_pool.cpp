@@ -0,0 +1,198 @@
+#include <buffer_pool.hpp>
+
+#include <algorithm>
+#include <utility>
+
+pooled_buffer::pooled_buffer(char* data, size_t sizeClass, buffer_pool* owner, size_t registeredSlot) noexcept
+    : _data(data)
+    , _sizeClass(sizeClass)
+    , _owner(owner)
+    , _registeredSlot(registeredSlot)
+{
+}
+
+pooled_buffer::pooled_buffer(pooled_buffer&& other) noexcept
+    : _data(std::exchange(other._data, nullptr))
+    , _sizeClass(other._sizeClass)
+    , _owner(std::exchange(other._owner, nullptr))
+    , _registeredSlot(std::exchange(other._registeredSlot, notRegistered))
+{
+}
+
+pooled_buffer& pooled_buffer::operator=(pooled_buffer&& other) noexcept
+{
+    if(&other == this)
+        return *this;
+
+    release();
+    _data = std::exchange(other._data, nullptr);
+    _sizeClass = other._sizeClass;
+    _owner = std::exchange(other._owner, nullptr);
+    _registeredSlot = std::exchange(other._registeredSlot, notRegistered);
+
+    return *this;
+}
+
+pooled_buffer::~pooled_buffer()
+{
+    release();
+}
+
+std::span<char> pooled_buffer::data() const noexcept
+{
+    return {_data, size()};
+}
+
+size_t pooled_buffer::size() const noexcept
+{
+    if(_data == nullptr)
+        return 0;
+    return buffer_pool::sizeClasses[_sizeClass];
+}
+
+size_t pooled_buffer::sizeClass() const noexcept
+{
+    return _sizeClass;
+}
+
+void pooled_buffer::release() noexcept
+{
+    if(_data == nullptr)
+        return;
+
+#if defined(BOOST_ASIO_HAS_IO_URING)
+    if(registered())
+        std::exchange(_owner, nullptr)->recycleRegistered(std::exchange(_registeredSlot, notRegistered));
+    else
+#endif
+        buffer_pool::local().recycle(std::unique_ptr<char[]>(_data), _sizeClass);
+
+    _data = nullptr;
+}
+
+#if defined(BOOST_ASIO_HAS_IO_URING)
+boost::asio::mutable_registered_buffer pooled_buffer::registeredBuffer() const noexcept
+{
+    return (*_owner->_registration)[_registeredSlot];
+}
+#endif
+
+pooled_buffer buffer_pool::acquire(size_t sizeClass)
+{
+    sizeClass = std::min(sizeClass, sizeClassCount - 1);
+
+#if defined(BOOST_ASIO_HAS_IO_URING)
+    if(sizeClass == 0 && _freeRegisteredSlots.empty() && _hasRemoteSlots.load(std::memory_order_acquire))
+        reclaimRemoteSlots();
+    if(sizeClass == 0 && !_freeRegisteredSlots.empty())
+    {
+        const auto slot = _freeRegisteredSlots.back();
+        _freeRegisteredSlots.pop_back();
+        return {_registeredRegion.get() + slot * sizeClasses[0], 0, this, slot};
+    }
+#endif
+
+    auto& freeBuffers = _freeBuffers[sizeClass];
+    if(freeBuffers.empty())
+        return {std::make_unique_for_overwrite<char[]>(sizeClasses[sizeClass]).release(), sizeClass};
+
+    auto data = std::move(freeBuffers.back());
+    freeBuffers.pop_back();
+    return {data.release(), sizeClass};
+}
+
+void buffer_pool::recycle(std::unique_ptr<char[]> data, size_t sizeClass) noexcept
+{
+    auto& freeBuffers = _freeBuffers[sizeClass];
+    if((freeBuffers.size() + 1) * sizeClasses[sizeClass] > maxCachedBytesPerSizeClass)
+        return;
+
+    try
+    {
+        freeBuffers.push_back(std::move(data));
+    }
+    catch (...)
+    {
+    }
+}
+
+#if defined(BOOST_ASIO_HAS_IO_URING)
+void buffer_pool::registerBuffers(boost::asio::io_context& context, size_t slotCount)
+{
+    _registeredRegion = std::make_unique_for_overwrite<char[]>(slotCount * sizeClasses[0]);
+
+    std::vector<boost::asio::mutable_buffer> slots;
+    slots.reserve(slotCount);
+    _freeRegisteredSlots.reserve(slotCount);
+    _remoteRegisteredSlots.reserve(slotCount);
+    for(size_t slot = 0; slot < slotCount; ++slot)
+    {
+        slots.emplace_back(_registeredRegion.get() + slot * sizeClasses[0], sizeClasses[0]);
+        _freeRegisteredSlots.push_back(slotCount - slot - 1);
+    }
+
+    _registration.emplace(boost::asio::register_buffers(context, slots));
+}
+
+void buffer_pool::unregisterBuffers() noexcept
+{
+    _freeRegisteredSlots.clear();
+    _registration.reset();
+
+    std::lock_guard lock(_remoteSlotsMutex);
+    _remoteRegisteredSlots.clear();
+    _hasRemoteSlots.store(false, std::memory_order_relaxed);
+}
+
+void buffer_pool::reclaimRemoteSlots() noexcept
+{
+    std::lock_guard lock(_remoteSlotsMutex);
+    _freeRegisteredSlots.insert(_freeRegisteredSlots.end(), _remoteRegisteredSlots.begin(), _remoteRegisteredSlots.end());
+    _remoteRegisteredSlots.clear();
+    _hasRemoteSlots.store(false, std::memory_order_relaxed);
+}
+
+// Both slot lists are reserved for every slot at registration, so neither push allocates.
+void buffer_pool::recycleRegistered(size_t slot) noexcept
+{
+    if(this == &local())
+    {
+        if(_registration.has_value())
+            _freeRegisteredSlots.push_back(slot);
+        return;
+    }
+
+    std::lock_guard lock(_remoteSlotsMutex);
+    _remoteRegisteredSlots.push_back(slot);
+    _hasRemoteSlots.store(true, std::memory_order_release);
+}
+#endif
+
+buffer_pool& buffer_pool::local() noexcept
+{
+    thread_local buffer_pool pool;
+    return pool;
+}
+
+void adaptive_buffer_size::update(size_t bytesRead, size_t bufferSize) noexcept
+{
+    if(bytesRead == bufferSize)
+    {
+        _sizeClass = std::min(_sizeClass + 1, buffer_pool::sizeClassCount - 1);
+        _underfilledReads = 0;
+        return;
+    }
+
+    if(bytesRead >= bufferSize / 4)
+    {
+        _underfilledReads = 0;
+        return;
+    }
+
+    if(++_underfilledReads < shrinkAfterUnderfilledReads)
+        return;
+
+    _underfilledReads = 0;
+    if(_sizeClass != 0)
+        --_sizeClass;
+}
@@ -0,0 +1,238 @@
+#include <datagram_batch.hpp>
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/error.hpp>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+
+#ifndef SOL_UDP
+#define SOL_UDP IPPROTO_UDP
+#endif
+#endif
+
+using boost::asio::ip::udp;
+
+datagram_batch::datagram_batch(size_t capacity, size_t slotSize, bool offload)
+    : _capacity(capacity)
+    , _slotSize(slotSize)
+#if defined(__linux__)
+    , _offload(offload)
+#else
+    , _offload(false)
+#endif
+    , _data(std::make_unique_for_overwrite<char[]>(capacity * slotSize))
+    , _senders(capacity)
+    , _sizes(capacity)
+    , _truncated(capacity)
+    , _segmentSizes(capacity)
+#if defined(__linux__)
+    , _receiveHeaders(capacity)
+    , _receiveVectors(capacity)
+    , _receiveControl(offload ? capacity : 0)
+    , _sendHeaders(capacity)
+    , _sendVectors(capacity)
+    , _sendControl(offload ? capacity : 0)
+#endif
+{
+#if defined(__linux__)
+    for(size_t index = 0; index < capacity; ++index)
+    {
+        _receiveVectors[index] = {_data.get() + index * slotSize, slotSize};
+
+        auto& header = _receiveHeaders[index].msg_hdr;
+        header.msg_iov = &_receiveVectors[index];
+        header.msg_iovlen = 1;
+    }
+#endif
+}
+
+std::span<const char> datagram_batch::data(size_t index) const noexcept
+{
+    return {_data.get() + index * _slotSize, _sizes[index]};
+}
+
+const udp::endpoint& datagram_batch::sender(size_t index) const noexcept
+{
+    return _senders[index];
+}
+
+uint16_t datagram_batch::segmentSize(size_t index) const noexcept
+{
+    return _segmentSizes[index];
+}
+
+bool datagram_batch::truncated(size_t index) const noexcept
+{
+    return _truncated[index];
+}
+
+#if defined(__linux__)
+
+size_t datagram_batch::receive(udp::socket& socket, bool withSenders, boost::system::error_code& error)
+{
+    for(size_t index = 0; index < _capacity; ++index)
+    {
+        auto& header = _receiveHeaders[index].msg_hdr;
+        header.msg_name = withSenders ? _senders[index].data() : nullptr;
+        header.msg_namelen = withSenders ? static_cast<socklen_t>(_senders[index].capacity()) : 0;
+        header.msg_control = _offload ? _receiveControl[index].data() : nullptr;
+        header.msg_controllen = _offload ? sizeof(control_buffer) : 0;
+        header.msg_flags = 0;
+    }
+
+    const auto count = ::recvmmsg(socket.native_handle(), _receiveHeaders.data(), static_cast<unsigned int>(_capacity), MSG_DONTWAIT, nullptr);
+    if(count < 0)
+    {
+        if(errno != EAGAIN && errno != EWOULDBLOCK)
+            error.assign(errno, boost::system::system_category());
+        return 0;
+    }
+
+    for(int index = 0; index < count; ++index)
+    {
+        const auto& header = _receiveHeaders[index].msg_hdr;
+        _sizes[index] = _receiveHeaders[index].msg_len;
+        _truncated[index] = (header.msg_flags & MSG_TRUNC) != 0;
+        if(withSenders)
+            _senders[index].resize(header.msg_namelen);
+
+        _segmentSizes[index] = 0;
+        if(!_offload)
+            continue;
+
+        for(auto* control = CMSG_FIRSTHDR(&header); control != nullptr; control = CMSG_NXTHDR(const_cast<msghdr*>(&header), control))
+        {
+            if(control->cmsg_level != SOL_UDP || control->cmsg_type != UDP_GRO)
+                continue;
+
+            int segmentSize = 0;
+            std::memcpy(&segmentSize, CMSG_DATA(control), sizeof(segmentSize));
+            if(static_cast<size_t>(segmentSize) < _sizes[index])
+                _segmentSizes[index] = static_cast<uint16_t>(segmentSize);
+        }
+    }
+
+    return static_cast<size_t>(count);
+}
+
+size_t datagram_batch::send(
+    udp::socket& socket, std::span<const size_t> indices,
+    const udp::endpoint* destination,
+    boost::system::error_code& error
+)
+{
+    for(size_t message = 0; message < indices.size(); ++message)
+    {
+        const auto index = indices[message];
+        const auto datagram = data(index);
+        _sendVectors[message] = {const_cast<char*>(datagram.data()), datagram.size()};
+
+        auto& header = _sendHeaders[message].msg_hdr;
+        header = {};
+        header.msg_name = destination != nullptr ? const_cast<sockaddr*>(destination->data()) : nullptr;
+        header.msg_namelen = destination != nullptr ? static_cast<socklen_t>(destination->size()) : 0;
+        header.msg_iov = &_sendVectors[message];
+        header.msg_iovlen = 1;
+
+        if(_segmentSizes[index] != 0)
+        {
+            header.msg_control = _sendControl[message].data();
+            header.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+
+            auto* control = CMSG_FIRSTHDR(&header);
+            control->cmsg_level = SOL_UDP;
+            control->cmsg_type = UDP_SEGMENT;
+            control->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            std::memcpy(CMSG_DATA(control), &_segmentSizes[index], sizeof(uint16_t));
+        }
+    }
+
+    size_t sent = 0;
+    while(sent < indices.size())
+    {
+        const auto count = ::sendmmsg(socket.native_handle(), _sendHeaders.data() + sent, static_cast<unsigned int>(indices.size() - sent), MSG_DONTWAIT);
+        if(count < 0)
+        {
+            if(errno != EAGAIN && errno != EWOULDBLOCK)
+                error.assign(errno, boost::system::system_category());
+            break;
+        }
+        sent += static_cast<size_t>(count);
+    }
+
+    return sent;
+}
+
+bool enable_generic_receive_offload(udp::socket& socket) noexcept
+{
+    const int enabled = 1;
+    return ::setsockopt(socket.native_handle(), SOL_UDP, UDP_GRO, &enabled, sizeof(enabled)) == 0;
+}
+
+#else
+
+// One datagram per call. Truncation is only detected where the platform reports it as
+// message_size, as Windows does.
+size_t datagram_batch::receive(udp::socket& socket, bool withSenders, boost::system::error_code& error)
+{
+    size_t count = 0;
+    for(; count < _capacity; ++count)
+    {
+        const auto slot = boost::asio::buffer(_data.get() + count * _slotSize, _slotSize);
+        boost::system::error_code receiveError;
+        const auto size = withSenders
+            ? socket.receive_from(slot, _senders[count], 0, receiveError)
+            : socket.receive(slot, 0, receiveError);
+
+        _truncated[count] = receiveError == boost::asio::error::message_size;
+        if(receiveError && !_truncated[count])
+        {
+            if(receiveError != boost::asio::error::would_block)
+                error = receiveError;
+            break;
+        }
+
+        _sizes[count] = _truncated[count] ? _slotSize : size;
+        _segmentSizes[count] = 0;
+    }
+
+    return count;
+}
+
+size_t datagram_batch::send(
+    udp::socket& socket, std::span<const size_t> indices,
+    const udp::endpoint* destination,
+    boost::system::error_code& error
+)
+{
+    size_t sent = 0;
+    for(; sent < indices.size(); ++sent)
+    {
+        const auto slot = data(indices[sent]);
+        const auto datagram = boost::asio::buffer(slot.data(), slot.size());
+        if(destination != nullptr)
+            socket.send_to(datagram, *destination, 0, error);
+        else
+            socket.send(datagram, 0, error);
+
+        if(error)
+        {
+            if(error == boost::asio::error::would_block)
+                error.clear();
+            break;
+        }
+    }
+
+    return sent;
+}
+
+bool enable_generic_receive_offload(udp::socket&) noexcept
+{
+    return false;
+}
+
+#endif
@@ -0,0 +1,143 @@
+#include <delay_queue.hpp>
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+
+#include <recycling_arena.hpp>
+
+using boost::asio::awaitable;
+
+delay_entry::delay_entry(std::function<void()> callback)
+    : _callback(std::move(callback))
+{
+}
+
+delay_entry::~delay_entry()
+{
+    cancel();
+}
+
+void delay_entry::cancel() noexcept
+{
+    if(_queue != nullptr)
+        _queue->remove(*this);
+}
+
+//----------------------------------------------------------------------
+
+delay_queue::delay_queue(boost::asio::io_context& context)
+    : _timer(context)
+{
+}
+
+// Like the timing wheel, entries of objects outliving the queue are detached.
+delay_queue::~delay_queue()
+{
+    for(auto* entry : _heap)
+        entry->_queue = nullptr;
+}
+
+void delay_queue::start()
+{
+    boost::asio::co_spawn(_timer.get_executor(), run(), boost::asio::detached);
+}
+
+void delay_queue::schedule(delay_entry& entry, clock::time_point deadline)
+{
+    const auto earliest = _heap.empty() ? clock::time_point::max() : _heap.front()->_deadline;
+
+    if(entry._queue == this)
+    {
+        const auto earlier = deadline < entry._deadline;
+        entry._deadline = deadline;
+        if(earlier)
+            siftUp(entry._index);
+        else
+            siftDown(entry._index);
+    }
+    else
+    {
+        entry.cancel();
+        entry._queue = this;
+        entry._deadline = deadline;
+        _heap.push_back(&entry);
+        siftUp(_heap.size() - 1);
+    }
+
+    // The loop re-arms for the new earliest deadline.
+    if(deadline < earliest)
+        _timer.cancel();
+}
+
+awaitable<void> delay_queue::run()
+{
+    boost::system::error_code error;
+    while(true)
+    {
+        _timer.expires_at(_heap.empty() ? clock::time_point::max() : _heap.front()->_deadline);
+        co_await _timer.async_wait(boost::asio::redirect_error(use_arena, error));
+
+        const auto now = clock::now();
+        while(!_heap.empty() && _heap.front()->_deadline <= now)
+        {
+            // The callback may reschedule or destroy the entry and cancel others.
+            auto& entry = *_heap.front();
+            remove(entry);
+            entry._callback();
+        }
+    }
+}
+
+void delay_queue::remove(delay_entry& entry) noexcept
+{
+    const auto index = entry._index;
+    entry._queue = nullptr;
+
+    auto* last = _heap.back();
+    _heap.pop_back();
+    if(last == &entry)
+        return;
+
+    place(last, index);
+    siftUp(index);
+    siftDown(last->_index);
+}
+
+void delay_queue::siftUp(size_t index) noexcept
+{
+    auto* entry = _heap[index];
+    while(index != 0)
+    {
+        const auto parent = (index - 1) / 2;
+        if(_heap[parent]->_deadline <= entry->_deadline)
+            break;
+        place(_heap[parent], index);
+        index = parent;
+    }
+    place(entry, index);
+}
+
+void delay_queue::siftDown(size_t index) noexcept
+{
+    auto* entry = _heap[index];
+    while(true)
+    {
+        auto child = index * 2 + 1;
+        if(child >= _heap.size())
+            break;
+        if(child + 1 < _heap.size() && _heap[child + 1]->_deadline < _heap[child]->_deadline)
+            ++child;
+        if(entry->_deadline <= _heap[child]->_deadline)
+            break;
+        place(_heap[child], index);
+        index = child;
+    }
+    place(entry, index);
+}
+
+void delay_queue::place(delay_entry* entry, size_t index) noexcept
+{
+    _heap[index] = entry;
+    entry->_index = index;
+}
@@ -0,0 +1,125 @@
+#include <forwarding_pipe.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <boost/asio/redirect_error.hpp>
+
+#include <recycling_arena.hpp>
+
+using boost::asio::awaitable;
+
+forwarding_pipe::forwarding_pipe(const boost::asio::any_io_executor& executor, const forwarding_pipe_options& options)
+    : _options(options)
+    , _dataAvailable(executor)
+    , _spaceAvailable(executor)
+{
+}
+
+void forwarding_pipe::push(pooled_buffer buffer, size_t size, std::chrono::steady_clock::time_point readAt)
+{
+    const auto wasEmpty = _chunks.empty();
+    _queuedBytes += size;
+
+    const auto appendable = coalescing()
+        && size <= _options.coalesceCopyLimit
+        && _chunks.size() > _gatheredChunks
+        && _chunks.back().buffer.size() - _chunks.back().size >= size;
+
+    if(appendable)
+    {
+        auto& tail = _chunks.back();
+        std::memcpy(tail.buffer.data().data() + tail.size, buffer.data().data(), size);
+        tail.size += size;
+    }
+    else
+    {
+        _chunks.push_back({std::move(buffer), size, readAt});
+    }
+
+    // A coalescing writer only needs waking for the first chunk or once the threshold is reached.
+    if(!coalescing() || wasEmpty || _queuedBytes >= _options.coalesceBytes)
+        _dataAvailable.cancel();
+}
+
+void forwarding_pipe::close() noexcept
+{
+    _closed = true;
+    _dataAvailable.cancel();
+    _spaceAvailable.cancel();
+}
+
+void forwarding_pipe::abort() noexcept
+{
+    _aborted = true;
+    _chunks.clear();
+    _queuedBytes = 0;
+    _gatheredChunks = 0;
+    close();
+}
+
+// The timers are waited on directly rather than through a helper coroutine, every nested
+// coroutine call costs a frame allocation per wait.
+awaitable<void> forwarding_pipe::waitForSpace()
+{
+    boost::system::error_code error;
+    while(!_closed && _queuedBytes > _options.lowWatermark)
+    {
+        _spaceAvailable.expires_at(boost::asio::steady_timer::time_point::max());
+        co_await _spaceAvailable.async_wait(boost::asio::redirect_error(use_arena, error));
+    }
+}
+
+awaitable<bool> forwarding_pipe::waitForData()
+{
+    boost::system::error_code error;
+    while(_chunks.empty())
+    {
+        if(_closed)
+            co_return false;
+
+        _dataAvailable.expires_at(boost::asio::steady_timer::time_point::max());
+        co_await _dataAvailable.async_wait(boost::asio::redirect_error(use_arena, error));
+    }
+
+    if(coalescing())
+    {
+        const auto deadline = _chunks.front().readAt + _options.coalesceDelay;
+        while(!_closed && _queuedBytes < _options.coalesceBytes && std::chrono::steady_clock::now() < deadline)
+        {
+            _dataAvailable.expires_at(deadline);
+            co_await _dataAvailable.async_wait(boost::asio::redirect_error(use_arena, error));
+        }
+    }
+
+    co_return !_chunks.empty();
+}
+
+size_t forwarding_pipe::gather(std::vector<boost::asio::const_buffer>& buffers)
+{
+    const auto count = std::min(_chunks.size(), _options.maxGatherBuffers);
+    _gatheredChunks = count;
+
+    buffers.clear();
+    for(size_t chunkIndex = 0; chunkIndex < count; ++chunkIndex)
+    {
+        const auto& chunk = _chunks[chunkIndex];
+        buffers.emplace_back(chunk.buffer.data().data(), chunk.size);
+    }
+
+    return count;
+}
+
+void forwarding_pipe::consume(size_t chunkCount, latency_histogram& latency) noexcept
+{
+    const auto writtenAt = std::chrono::steady_clock::now();
+    for(; chunkCount != 0 && !_chunks.empty(); --chunkCount)
+    {
+        latency.record(writtenAt - _chunks.front().readAt);
+        _queuedBytes -= _chunks.front().size;
+        _chunks.pop_front();
+    }
+    _gatheredChunks = 0;
+
+    if(_queuedBytes <= _options.lowWatermark)
+        _spaceAvailable.cancel();
+}
@@ -0,0 +1,150 @@
+#include <heap_statistics.hpp>
+
+#if defined(ASIO_TCP_PROXY_COUNT_ALLOCATIONS)
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__) || defined(__linux__)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#elif defined(__FreeBSD__)
+#include <malloc_np.h>
+#else
+#error "ASIO_TCP_PROXY_COUNT_ALLOCATIONS needs malloc_usable_size or malloc_size"
+#endif
+
+namespace
+{
+    // Bytes the allocator actually reserved for `pointer`, so frees subtract what was added.
+    size_t usable_size(void* pointer) noexcept
+    {
+#if defined(__APPLE__)
+        return malloc_size(pointer);
+#else
+        return malloc_usable_size(pointer);
+#endif
+    }
+
+    constinit std::atomic<uint64_t> allocations{0};
+    constinit std::atomic<size_t> bytesInUse{0};
+
+    void* counted_allocate(size_t size) noexcept
+    {
+        auto* pointer = std::malloc(size == 0 ? 1 : size);
+        if(pointer == nullptr)
+            return nullptr;
+
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        bytesInUse.fetch_add(usable_size(pointer), std::memory_order_relaxed);
+        return pointer;
+    }
+
+    void* counted_allocate_aligned(size_t size, std::align_val_t alignment) noexcept
+    {
+        const auto align = static_cast<size_t>(alignment);
+        auto* pointer = std::aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) / align * align);
+        if(pointer == nullptr)
+            return nullptr;
+
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        bytesInUse.fetch_add(usable_size(pointer), std::memory_order_relaxed);
+        return pointer;
+    }
+
+    void counted_free(void* pointer) noexcept
+    {
+        if(pointer == nullptr)
+            return;
+
+        bytesInUse.fetch_sub(usable_size(pointer), std::memory_order_relaxed);
+        std::free(pointer);
+    }
+}
+
+void* operator new(size_t size)
+{
+    if(auto* pointer = counted_allocate(size))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    if(auto* pointer = counted_allocate_aligned(size, alignment))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return counted_allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return counted_allocate(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    counted_free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    counted_free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    counted_free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+    counted_free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+    counted_free(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept
+{
+    counted_free(pointer);
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept
+{
+    counted_free(pointer);
+}
+
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept
+{
+    counted_free(pointer);
+}
+
+std::optional<heap_statistics> current_heap_statistics() noexcept
+{
+    return heap_statistics{allocations.load(std::memory_order_relaxed), bytesInUse.load(std::memory_order_relaxed)};
+}
+#else
+std::optional<heap_statistics> current_heap_statistics() noexcept
+{
+    return std::nullopt;
+}
+#endif
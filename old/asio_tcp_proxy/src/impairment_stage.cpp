@@ -0,0 +1,164 @@
+#include <impairment_stage.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <boost/asio/redirect_error.hpp>
+
+#include <recycling_arena.hpp>
+
+using boost::asio::awaitable;
+
+impairment_stage::impairment_stage(
+    const boost::asio::any_io_executor& executor,
+    delay_queue& delays,
+    const impairment_options& options,
+    uint64_t seed,
+    sink output,
+    std::function<void()> onDrained
+)
+    : _options(options)
+    , _delays(delays)
+    , _sink(std::move(output))
+    , _onDrained(std::move(onDrained))
+    , _origin(clock::now())
+    , _linkFreeAt(_origin)
+    , _lastReleaseAt(_origin)
+    , _random(static_cast<std::minstd_rand::result_type>(seed % std::minstd_rand::modulus) + 1)
+    , _spaceAvailable(executor)
+    , _release([this]{ release(); })
+{
+    while(_segmentSizeClass + 1 < buffer_pool::sizeClassCount && buffer_pool::sizeClasses[_segmentSizeClass] < _options.segmentSize)
+        ++_segmentSizeClass;
+    _options.segmentSize = std::min(_options.segmentSize, buffer_pool::sizeClasses[_segmentSizeClass]);
+}
+
+void impairment_stage::push(pooled_buffer buffer, size_t size, clock::time_point readAt)
+{
+    if(_failed)
+        return;
+
+    if(_options.segmentSize == 0 || size <= _options.segmentSize)
+    {
+        hold(std::move(buffer), size, readAt, readAt);
+        return;
+    }
+
+    // All segments but the last are copied out, the last one keeps the read buffer.
+    auto* data = buffer.data().data();
+    auto sentAt = readAt;
+    size_t offset = 0;
+    for(; size - offset > _options.segmentSize; offset += _options.segmentSize)
+    {
+        auto segment = buffer_pool::local().acquire(_segmentSizeClass);
+        std::memcpy(segment.data().data(), data + offset, _options.segmentSize);
+        hold(std::move(segment), _options.segmentSize, readAt, sentAt);
+        sentAt += _options.segmentGap;
+    }
+
+    std::memmove(data, data + offset, size - offset);
+    hold(std::move(buffer), size - offset, readAt, sentAt);
+}
+
+void impairment_stage::close()
+{
+    _closing = true;
+    if(_chunks.empty())
+        finish();
+}
+
+void impairment_stage::abort() noexcept
+{
+    _failed = true;
+    _chunks.clear();
+    _heldBytes = 0;
+    _release.cancel();
+    _spaceAvailable.cancel();
+    if(_closing)
+        finish();
+}
+
+awaitable<void> impairment_stage::waitForSpace()
+{
+    boost::system::error_code error;
+    while(!_failed && full())
+    {
+        _spaceAvailable.expires_at(boost::asio::steady_timer::time_point::max());
+        co_await _spaceAvailable.async_wait(boost::asio::redirect_error(use_arena, error));
+    }
+}
+
+void impairment_stage::hold(pooled_buffer buffer, size_t size, clock::time_point readAt, clock::time_point sentAt)
+{
+    const auto releaseAt = arrivalTime(size, sentAt);
+    _heldBytes += size;
+    _chunks.push_back({std::move(buffer), size, readAt, releaseAt});
+
+    if(_chunks.size() == 1)
+        _delays.schedule(_release, releaseAt);
+}
+
+void impairment_stage::release()
+{
+    const auto now = clock::now();
+    while(!_chunks.empty() && _chunks.front().releaseAt <= now)
+    {
+        auto chunk = std::move(_chunks.front());
+        _chunks.pop_front();
+        _heldBytes -= chunk.size;
+
+        if(!_sink(std::move(chunk.buffer), chunk.size, chunk.readAt))
+        {
+            abort();
+            return;
+        }
+    }
+
+    if(!_chunks.empty())
+        _delays.schedule(_release, _chunks.front().releaseAt);
+    else if(_closing)
+        finish();
+
+    if(!full())
+        _spaceAvailable.cancel();
+}
+
+void impairment_stage::finish()
+{
+    if(auto onDrained = std::exchange(_onDrained, nullptr))
+        onDrained();
+}
+
+// Reads leave over the emulated link one after another, then take the latency to arrive.
+// Jitter never lets a read overtake the one before it, TCP would reorder them anyway.
+impairment_stage::clock::time_point impairment_stage::arrivalTime(size_t size, clock::time_point sentAt)
+{
+    auto departure = sentAt;
+    if(_options.bandwidth != 0)
+    {
+        const auto transmission = std::chrono::nanoseconds(static_cast<int64_t>(static_cast<double>(size) * 1e9 / static_cast<double>(_options.bandwidth)));
+        _linkFreeAt = std::max(_linkFreeAt, sentAt) + transmission;
+        departure = _linkFreeAt;
+    }
+
+    auto delay = clock::duration(_options.latency);
+    if(_options.jitter.count() != 0)
+    {
+        const auto jitter = std::chrono::duration_cast<clock::duration>(_options.jitter).count();
+        delay += clock::duration(std::uniform_int_distribution<clock::rep>(-jitter, jitter)(_random));
+    }
+
+    auto arrival = std::max(departure + std::max(delay, clock::duration::zero()), _lastReleaseAt);
+
+    // The stall occupies the end of every interval.
+    if(_options.stallInterval.count() != 0 && _options.stallDuration.count() != 0)
+    {
+        const auto interval = clock::duration(_options.stallInterval);
+        const auto phase = (arrival - _origin) % interval;
+        if(phase >= interval - clock::duration(_options.stallDuration))
+            arrival += interval - phase;
+    }
+
+    _lastReleaseAt = arrival;
+    return arrival;
+}
@@ -0,0 +1,121 @@
+#include <logging.hpp>
+
+#include <cstdio>
+#include <string>
+
+std::string_view to_string(log_level level) noexcept
+{
+    switch (level)
+    {
+    case log_level::trace:
+        return "trace";
+    case log_level::debug:
+        return "debug";
+    case log_level::info:
+        return "info";
+    case log_level::warning:
+        return "warning";
+    case log_level::error:
+        return "error";
+    case log_level::off:
+        return "off";
+    }
+    return "unknown";
+}
+
+log_record* log_ring::beginPush() noexcept
+{
+    const auto head = _head.load(std::memory_order_relaxed);
+    const auto tail = _tail.load(std::memory_order_acquire);
+    if(head - tail == capacity)
+        return nullptr;
+
+    return &_records[head & (capacity - 1)];
+}
+
+void log_ring::endPush() noexcept
+{
+    _head.fetch_add(1, std::memory_order_release);
+}
+
+void log_ring::drop() noexcept
+{
+    _dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t log_ring::takeDropped() noexcept
+{
+    return _dropped.exchange(0, std::memory_order_relaxed);
+}
+
+logger::logger()
+    : _flusher([this](std::stop_token stopToken){ run(std::move(stopToken)); })
+{
+}
+
+logger::~logger()
+{
+    _flusher.request_stop();
+    if(_flusher.joinable())
+        _flusher.join();
+    flush();
+}
+
+logger& logger::instance()
+{
+    static logger instance;
+    return instance;
+}
+
+log_ring& logger::localRing()
+{
+    thread_local log_ring* ring = nullptr;
+    if(ring != nullptr)
+        return *ring;
+
+    auto newRing = std::make_unique<log_ring>();
+    ring = newRing.get();
+
+    std::lock_guard lock(_ringsMutex);
+    _rings.push_back(std::move(newRing));
+    return *ring;
+}
+
+void logger::flush()
+{
+    std::string batch;
+
+    {
+        std::lock_guard lock(_ringsMutex);
+        for(auto& ring : _rings)
+        {
+            ring->drain([&](const log_record& record){
+                std::format_to(
+                    std::back_inserter(batch),
+                    "[{:%T}] [{}] {}\n",
+                    std::chrono::floor<std::chrono::milliseconds>(record.timestamp),
+                    to_string(record.level),
+                    std::string_view{record.text.data(), record.length}
+                );
+            });
+
+            if(const auto dropped = ring->takeDropped(); dropped != 0)
+                std::format_to(std::back_inserter(batch), "[warning] dropped {} log records\n", dropped);
+        }
+    }
+
+    if(batch.empty())
+        return;
+
+    std::fwrite(batch.data(), 1, batch.size(), stdout);
+    std::fflush(stdout);
+}
+
+void logger::run(std::stop_token stopToken)
+{
+    while(!stopToken.stop_requested())
+    {
+        flush();
+        std::this_thread::sleep_for(flushInterval);
+    }
+}
@@ -1,176 +1,96 @@
+#include <algorithm>
 #include <cstdlib>
-#include <deque>
-#include <iostream>
-#include <list>
 #include <memory>
-#include <set>
-#include <string>
-#include <string_view>
-#include <span>
-#include <print>
-#include <format>
-#include <iostream>
+#include <thread>
 #include <utility>
-#include <boost/asio/awaitable.hpp>
-#include <boost/asio/detached.hpp>
+#include <vector>
 #include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
 #include <boost/asio/io_context.hpp>
-#include <boost/asio/ip/tcp.hpp>
-#include <boost/asio/read.hpp>
-#include <boost/asio/connect.hpp>
-#include <boost/asio/redirect_error.hpp>
 #include <boost/asio/signal_set.hpp>
-#include <boost/asio/steady_timer.hpp>
-#include <boost/asio/use_awaitable.hpp>
-#include <boost/asio/write.hpp>
 
-using boost::asio::ip::tcp;
-using boost::asio::awaitable;
+#include <admission_control.hpp>
+#include <backend_set.hpp>
+#include <logging.hpp>
+#include <metrics.hpp>
+#include <proxy_config.hpp>
+#include <stats_server.hpp>
+#include <tcp_proxy.hpp>
+
 using boost::asio::co_spawn;
 using boost::asio::detached;
-using boost::asio::redirect_error;
-using boost::asio::use_awaitable;
 
-class proxy_session
-    : public std::enable_shared_from_this<proxy_session>
+int main(int argc, char* argv[])
 {
-private:
-    boost::asio::io_context& _context;
-    tcp::socket _clientSocket;
-    tcp::socket _serverSocket;
-public:
-    proxy_session(boost::asio::io_context& context, tcp::socket clientSocket, tcp::socket serverSocket)
-        : _context(context)
-        , _clientSocket(std::move(clientSocket))
-        , _serverSocket(std::move(serverSocket))
-    {
-    }
-public:
-    void start()
-    {
-        co_spawn(
-            _context,
-            [self = shared_from_this()]{ return self->forwardServerToClient(); },
-            detached
-        );
-
-        co_spawn(
-            _context,
-            [self = shared_from_this()]{ return self->forwardClientToServer(); },
-            detached
-        );
-    }
-private:
-    awaitable<void> forward(tcp::socket& from, tcp::socket& to)
-    {
-        constexpr static size_t bufferSize = 1024*1024;
-        std::vector<char> data(bufferSize);
-
-        while(true)
-        {
-            auto bytesRead = co_await from.async_read_some(boost::asio::buffer(data), use_awaitable);
-            if(bytesRead != 0)
-                std::print(std::cout, "Read bytes: {}\n", bytesRead);
-            co_await async_write(to, boost::asio::buffer(data, bytesRead), use_awaitable);
-        }
-    }
-
-    awaitable<void> forwardServerToClient()
-    {
-        co_await forward(_serverSocket, _clientSocket);
-    }
-
-    awaitable<void> forwardClientToServer()
+    try
     {
-        co_await forward(_clientSocket, _serverSocket);
-    }
-};
+        // Without a config file the proxy serves its historical single route.
+        const auto config = argc > 1 ? load_proxy_config(argv[1]) : default_proxy_config();
 
-//----------------------------------------------------------------------
+        std::vector<std::unique_ptr<backend_set>> backends;
+        for(const auto& route : config.routes)
+            backends.push_back(std::make_unique<backend_set>(route.backends, route.policy));
 
-awaitable<void> start_tcp_proxy(
-    boost::asio::io_context& context,
-    std::string_view proxiedAddress, std::string_view proxiedPort,
-    uint16_t proxyPort
-)
-{
-    tcp::resolver resolver(context);
-    tcp::acceptor acceptor(context, {tcp::v4(), proxyPort});
+        admission_control admission(config.admission);
 
-    for (;;)
-    {
-        std::print(std::cout, "Waiting for next client\n");
-        try
+        const auto workerCount = config.threads != 0 ? config.threads : std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::unique_ptr<proxy_worker>> workers;
+        workers.reserve(workerCount);
+        for(size_t workerIndex = 0; workerIndex < workerCount; ++workerIndex)
         {
-            tcp::socket clientSocket = co_await acceptor.async_accept(use_awaitable);
-            const auto endpoint = clientSocket.remote_endpoint();
-            const auto address = endpoint.address();
-            const auto port = endpoint.port();
-            std::print(std::cout, "Received connection from: {}:{}\n", address.to_string(), port);
-            try
-            {
-                const auto proxiedResolvedAddress = co_await resolver.async_resolve(proxiedAddress, proxiedPort, use_awaitable);
+            workers.push_back(std::make_unique<proxy_worker>(workerIndex, config.resolveTimeToLive));
+            for(size_t routeIndex = 0; routeIndex < config.routes.size(); ++routeIndex)
+                workers.back()->addRoute(config.routes[routeIndex].options, *backends[routeIndex]);
+            if(config.capture.has_value())
+                workers.back()->capture(*config.capture);
+        }
 
-                tcp::socket serverSocket(context);
-                std::print(std::cout, "Trying to establish connection to {}:{}\n", proxiedAddress, proxiedPort);
-                try
-                {
-                    co_await boost::asio::async_connect(serverSocket, proxiedResolvedAddress, use_awaitable);
-                    std::print(std::cout, "Established connection to {}:{}\n", proxiedAddress, proxiedPort);
+        auto& io_context = workers.front()->context();
 
-                    try
-                    {
-                        std::make_shared<proxy_session>(context, std::move(clientSocket), std::move(serverSocket))->start();
-                    }
-                    catch (const std::exception& exception)
-                    {
-                        std::print("Failed to start proxy session: {}\n",exception.what());
-                    }
-                }
-                catch (const std::exception& exception)
-                {
-                    std::print("Failed to establish connection to address: {}:{}, {}\n", proxiedAddress, proxiedPort, exception.what());
-                }
-            }
-            catch (const std::exception& exception)
-            {
-                std::print("Failed to resolve address: {}:{}, {}\n", proxiedAddress, proxiedPort, exception.what());
-            }
-        }
-        catch (const std::exception& exception)
+        for(size_t routeIndex = 0; routeIndex < config.routes.size(); ++routeIndex)
         {
-            std::print("Failed to accept connection: {}\n", exception.what());
+            co_spawn(
+                io_context,
+                start_tcp_proxy(io_context, workers, routeIndex, admission),
+                detached
+            );
+
+            co_spawn(
+                io_context,
+                backends[routeIndex]->runHealthChecks(io_context),
+                detached
+            );
         }
-    }
-}
-
-//----------------------------------------------------------------------
-
-int main(int argc, char* argv[])
-{
-    constexpr std::string_view serverAddress = "localhost";
-    constexpr std::string_view serverPort = "25565";
-    constexpr uint16_t connectionPort = 25566;
-
-    try
-    {
-        boost::asio::io_context io_context(1);
 
         co_spawn(
             io_context,
-            start_tcp_proxy(io_context, serverAddress, serverPort, connectionPort),
+            run_stats_server(
+                io_context,
+                config.stats,
+                [&]{ return render_metrics(workers); }
+            ),
             detached
         );
 
         boost::asio::signal_set signals(io_context, SIGINT, SIGTERM);
-        signals.async_wait([&](auto, auto){ io_context.stop(); });
+        signals.async_wait([&](auto, auto){
+            for(auto& worker : workers)
+                worker->stop();
+        });
+
+        for(auto& worker : workers)
+            worker->start();
 
-        io_context.run();
+        std::vector<std::jthread> threads;
+        for(size_t workerIndex = 1; workerIndex < workers.size(); ++workerIndex)
+            threads.emplace_back([&worker = *workers[workerIndex]]{ worker.run(); });
+
+        workers.front()->run();
     }
     catch (const std::exception& exception)
     {
-        std::print("Finished spoofing: {}", exception.what());
+        log_message(log_level::error, "Finished spoofing: {}", exception.what());
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,305 @@
+#include <metrics.hpp>
+
+#include <array>
+#include <format>
+#include <iterator>
+#include <optional>
+#include <utility>
+
+#include <backend_set.hpp>
+#include <heap_statistics.hpp>
+#include <tcp_proxy.hpp>
+
+namespace
+{
+    constexpr std::array<std::pair<double, std::string_view>, 4> quantiles{{
+        {50.0, "0.5"},
+        {90.0, "0.9"},
+        {99.0, "0.99"},
+        {99.9, "0.999"}
+    }};
+
+    struct direction_snapshot
+    {
+        uint64_t bytes{0};
+        uint64_t messages{0};
+        uint64_t writes{0};
+        histogram_snapshot forwardingLatency;
+    public:
+        void merge(const direction_metrics& metrics)
+        {
+            bytes += metrics.bytes.load();
+            messages += metrics.messages.load();
+            writes += metrics.writes.load();
+            forwardingLatency.merge(metrics.forwardingLatency);
+        }
+        void merge(const direction_snapshot& snapshot)
+        {
+            bytes += snapshot.bytes;
+            messages += snapshot.messages;
+            writes += snapshot.writes;
+            forwardingLatency.merge(snapshot.forwardingLatency);
+        }
+    };
+
+    void render_histogram(std::string& out, std::string_view name, std::string_view labels, const histogram_snapshot& histogram)
+    {
+        const auto separator = labels.empty() ? "" : ",";
+        for(const auto& [percentile, quantile] : quantiles)
+        {
+            std::format_to(
+                std::back_inserter(out),
+                "{}{{{}{}quantile=\"{}\"}} {:.9f}\n",
+                name, labels, separator, quantile, static_cast<double>(histogram.percentile(percentile)) * 1e-9
+            );
+        }
+        std::format_to(std::back_inserter(out), "{}_max{{{}}} {:.9f}\n", name, labels, static_cast<double>(histogram.max()) * 1e-9);
+        std::format_to(std::back_inserter(out), "{}_count{{{}}} {}\n", name, labels, histogram.count());
+    }
+
+    void render_direction(std::string& out, std::string_view labels, std::string_view direction, const direction_snapshot& snapshot)
+    {
+        std::format_to(std::back_inserter(out), "proxy_bytes_total{{{},direction=\"{}\"}} {}\n", labels, direction, snapshot.bytes);
+        std::format_to(std::back_inserter(out), "proxy_messages_total{{{},direction=\"{}\"}} {}\n", labels, direction, snapshot.messages);
+        std::format_to(std::back_inserter(out), "proxy_writes_total{{{},direction=\"{}\"}} {}\n", labels, direction, snapshot.writes);
+        render_histogram(out, "proxy_forwarding_latency_seconds", std::format("{},direction=\"{}\"", labels, direction), snapshot.forwardingLatency);
+    }
+
+    struct udp_direction_snapshot
+    {
+        uint64_t datagrams{0};
+        uint64_t bytes{0};
+        uint64_t receiveCalls{0};
+        uint64_t sendCalls{0};
+        uint64_t dropped{0};
+    public:
+        void merge(const udp_direction_metrics& metrics)
+        {
+            datagrams += metrics.datagrams.load();
+            bytes += metrics.bytes.load();
+            receiveCalls += metrics.receiveCalls.load();
+            sendCalls += metrics.sendCalls.load();
+            dropped += metrics.dropped.load();
+        }
+    };
+
+    void render_udp_direction(std::string& out, std::string_view labels, std::string_view direction, const udp_direction_snapshot& snapshot)
+    {
+        std::format_to(std::back_inserter(out), "proxy_udp_datagrams_total{{{},direction=\"{}\"}} {}\n", labels, direction, snapshot.datagrams);
+        std::format_to(std::back_inserter(out), "proxy_udp_bytes_total{{{},direction=\"{}\"}} {}\n", labels, direction, snapshot.bytes);
+        std::format_to(std::back_inserter(out), "proxy_udp_receive_calls_total{{{},direction=\"{}\"}} {}\n", labels, direction, snapshot.receiveCalls);
+        std::format_to(std::back_inserter(out), "proxy_udp_send_calls_total{{{},direction=\"{}\"}} {}\n", labels, direction, snapshot.sendCalls);
+        std::format_to(std::back_inserter(out), "proxy_udp_dropped_total{{{},direction=\"{}\"}} {}\n", labels, direction, snapshot.dropped);
+    }
+
+    struct compression_snapshot
+    {
+        uint64_t framesCompressed{0};
+        uint64_t bytesBeforeCompression{0};
+        uint64_t bytesAfterCompression{0};
+        uint64_t framesDecompressed{0};
+        uint64_t bytesDecompressed{0};
+        histogram_snapshot compressionTime;
+        histogram_snapshot decompressionTime;
+    public:
+        void merge(const compression_metrics& metrics)
+        {
+            framesCompressed += metrics.framesCompressed.load();
+            bytesBeforeCompression += metrics.bytesBeforeCompression.load();
+            bytesAfterCompression += metrics.bytesAfterCompression.load();
+            framesDecompressed += metrics.framesDecompressed.load();
+            bytesDecompressed += metrics.bytesDecompressed.load();
+            compressionTime.merge(metrics.compressionTime);
+            decompressionTime.merge(metrics.decompressionTime);
+        }
+    };
+
+    void render_compression(std::string& out, std::string_view labels, const compression_snapshot& snapshot)
+    {
+        std::format_to(std::back_inserter(out), "proxy_compressed_frames_total{{{}}} {}\n", labels, snapshot.framesCompressed);
+        std::format_to(std::back_inserter(out), "proxy_compression_input_bytes_total{{{}}} {}\n", labels, snapshot.bytesBeforeCompression);
+        std::format_to(std::back_inserter(out), "proxy_compression_output_bytes_total{{{}}} {}\n", labels, snapshot.bytesAfterCompression);
+        std::format_to(std::back_inserter(out), "proxy_decompressed_frames_total{{{}}} {}\n", labels, snapshot.framesDecompressed);
+        std::format_to(std::back_inserter(out), "proxy_decompression_output_bytes_total{{{}}} {}\n", labels, snapshot.bytesDecompressed);
+        render_histogram(out, "proxy_compression_time_seconds", labels, snapshot.compressionTime);
+        render_histogram(out, "proxy_decompression_time_seconds", labels, snapshot.decompressionTime);
+    }
+
+    void render_route(std::string& out, std::span<const std::unique_ptr<proxy_worker>> workers, size_t routeIndex)
+    {
+        const auto& options = workers.front()->route(routeIndex).options();
+        const auto& backends = workers.front()->route(routeIndex).backends();
+        const auto listenerLabels = std::format(
+            "listener=\"{}:{}\",route=\"{}\"", options.listen.address().to_string(), options.listen.port(), options.name
+        );
+
+        uint64_t acceptedConnections = 0;
+        uint64_t rejectedConnections = 0;
+        std::array<uint64_t, 4> throttledConnections{};
+        histogram_snapshot acceptLatency;
+        for(const auto& worker : workers)
+        {
+            const auto& metrics = worker->route(routeIndex).metrics().listener();
+            acceptedConnections += metrics.acceptedConnections.load();
+            rejectedConnections += metrics.rejectedConnections.load();
+            for(size_t reason = 0; reason < throttledConnections.size(); ++reason)
+                throttledConnections[reason] += metrics.throttledConnections[reason].load();
+            acceptLatency.merge(metrics.acceptLatency);
+        }
+
+        udp_direction_snapshot udpClientToServer;
+        udp_direction_snapshot udpServerToClient;
+        uint64_t udpFlowsOpened = 0;
+        uint64_t udpFlowsClosed = 0;
+        uint64_t udpFlowsRejected = 0;
+        for(const auto& worker : workers)
+        {
+            const auto& metrics = worker->route(routeIndex).metrics().udp();
+            udpClientToServer.merge(metrics.clientToServer);
+            udpServerToClient.merge(metrics.serverToClient);
+            udpFlowsOpened += metrics.flowsOpened.load();
+            udpFlowsClosed += metrics.flowsClosed.load();
+            udpFlowsRejected += metrics.flowsRejected.load();
+        }
+
+        uint64_t mirrorSessions = 0;
+        uint64_t mirrorBytes = 0;
+        uint64_t mirrorDroppedBytes = 0;
+        uint64_t mirrorDisconnects = 0;
+        uint64_t mirrorConnectFailures = 0;
+        histogram_snapshot mirrorLag;
+        for(const auto& worker : workers)
+        {
+            const auto& metrics = worker->route(routeIndex).metrics().mirror();
+            mirrorSessions += metrics.sessions.load();
+            mirrorBytes += metrics.bytes.load();
+            mirrorDroppedBytes += metrics.droppedBytes.load();
+            mirrorDisconnects += metrics.disconnects.load();
+            mirrorConnectFailures += metrics.connectFailures.load();
+            mirrorLag.merge(metrics.lag);
+        }
+
+        uint64_t listenerActiveSessions = 0;
+        direction_snapshot listenerClientToServer;
+        direction_snapshot listenerServerToClient;
+
+        std::string backendsOut;
+        for(size_t backendIndex = 0; backendIndex < backends.size(); ++backendIndex)
+        {
+            const auto& backend = backends[backendIndex];
+
+            uint64_t sessionsOpened = 0;
+            uint64_t sessionsClosed = 0;
+            uint64_t sessionsTimedOut = 0;
+            direction_snapshot clientToServer;
+            direction_snapshot serverToClient;
+            histogram_snapshot connectLatency;
+            compression_snapshot compression;
+            for(const auto& worker : workers)
+            {
+                const auto& metrics = worker->route(routeIndex).metrics().backend(backendIndex);
+                sessionsOpened += metrics.sessionsOpened.load();
+                sessionsClosed += metrics.sessionsClosed.load();
+                sessionsTimedOut += metrics.sessionsTimedOut.load();
+                clientToServer.merge(metrics.clientToServer);
+                serverToClient.merge(metrics.serverToClient);
+                connectLatency.merge(metrics.connectLatency);
+                compression.merge(metrics.compression);
+            }
+
+            const auto activeSessions = sessionsOpened - std::min(sessionsOpened, sessionsClosed);
+            listenerActiveSessions += activeSessions;
+            listenerClientToServer.merge(clientToServer);
+            listenerServerToClient.merge(serverToClient);
+
+            const auto labels = std::format("{},backend=\"{}:{}\"", listenerLabels, backend.address(), backend.port());
+            std::format_to(std::back_inserter(backendsOut), "proxy_backend_healthy{{{}}} {}\n", labels, backend.healthy() ? 1 : 0);
+            std::format_to(std::back_inserter(backendsOut), "proxy_active_sessions{{{}}} {}\n", labels, activeSessions);
+            std::format_to(std::back_inserter(backendsOut), "proxy_sessions_total{{{}}} {}\n", labels, sessionsOpened);
+            std::format_to(std::back_inserter(backendsOut), "proxy_session_timeouts_total{{{}}} {}\n", labels, sessionsTimedOut);
+            std::format_to(std::back_inserter(backendsOut), "proxy_connect_failures_total{{{}}} {}\n", labels, backend.failedConnections());
+            render_histogram(backendsOut, "proxy_connect_latency_seconds", labels, connectLatency);
+            render_direction(backendsOut, labels, "client_to_server", clientToServer);
+            render_direction(backendsOut, labels, "server_to_client", serverToClient);
+            render_compression(backendsOut, labels, compression);
+        }
+
+        std::format_to(std::back_inserter(out), "proxy_accepted_connections_total{{{}}} {}\n", listenerLabels, acceptedConnections);
+        std::format_to(std::back_inserter(out), "proxy_rejected_connections_total{{{}}} {}\n", listenerLabels, rejectedConnections);
+        for(size_t reason = 1; reason < throttledConnections.size(); ++reason)
+        {
+            std::format_to(
+                std::back_inserter(out),
+                "proxy_throttled_connections_total{{{},reason=\"{}\"}} {}\n",
+                listenerLabels, to_string(static_cast<admission_result>(reason)), throttledConnections[reason]
+            );
+        }
+        std::format_to(std::back_inserter(out), "proxy_active_sessions{{{}}} {}\n", listenerLabels, listenerActiveSessions);
+        render_histogram(out, "proxy_accept_latency_seconds", listenerLabels, acceptLatency);
+        render_direction(out, listenerLabels, "client_to_server", listenerClientToServer);
+        render_direction(out, listenerLabels, "server_to_client", listenerServerToClient);
+        std::format_to(std::back_inserter(out), "proxy_udp_flows_total{{{}}} {}\n", listenerLabels, udpFlowsOpened);
+        std::format_to(std::back_inserter(out), "proxy_udp_active_flows{{{}}} {}\n", listenerLabels, udpFlowsOpened - std::min(udpFlowsOpened, udpFlowsClosed));
+        std::format_to(std::back_inserter(out), "proxy_udp_rejected_flows_total{{{}}} {}\n", listenerLabels, udpFlowsRejected);
+        render_udp_direction(out, listenerLabels, "client_to_server", udpClientToServer);
+        render_udp_direction(out, listenerLabels, "server_to_client", udpServerToClient);
+        if(mirrorSessions != 0)
+        {
+            std::format_to(std::back_inserter(out), "proxy_mirror_sessions_total{{{}}} {}\n", listenerLabels, mirrorSessions);
+            std::format_to(std::back_inserter(out), "proxy_mirror_bytes_total{{{}}} {}\n", listenerLabels, mirrorBytes);
+            std::format_to(std::back_inserter(out), "proxy_mirror_dropped_bytes_total{{{}}} {}\n", listenerLabels, mirrorDroppedBytes);
+            std::format_to(std::back_inserter(out), "proxy_mirror_disconnects_total{{{}}} {}\n", listenerLabels, mirrorDisconnects);
+            std::format_to(std::back_inserter(out), "proxy_mirror_connect_failures_total{{{}}} {}\n", listenerLabels, mirrorConnectFailures);
+            render_histogram(out, "proxy_mirror_lag_seconds", listenerLabels, mirrorLag);
+        }
+        out += backendsOut;
+    }
+}
+
+worker_metrics::worker_metrics(size_t backendCount)
+{
+    _backends.reserve(backendCount);
+    for(size_t backendIndex = 0; backendIndex < backendCount; ++backendIndex)
+        _backends.push_back(std::make_unique<backend_metrics>());
+}
+
+std::string render_metrics(std::span<const std::unique_ptr<proxy_worker>> workers)
+{
+    std::string out;
+
+    for(size_t routeIndex = 0; routeIndex < workers.front()->routeCount(); ++routeIndex)
+        render_route(out, workers, routeIndex);
+
+    std::optional<uint64_t> captureDroppedRecords;
+    for(const auto& worker : workers)
+    {
+        if(const auto* capture = worker->captureWriter())
+            captureDroppedRecords = captureDroppedRecords.value_or(0) + capture->droppedRecords();
+    }
+
+    uint64_t arenaAllocations = 0;
+    uint64_t arenaHeapAllocations = 0;
+    uint64_t arenaCachedBytes = 0;
+    for(const auto& worker : workers)
+    {
+        worker->visitArena([&](const recycling_arena& arena){
+            arenaAllocations += arena.allocations();
+            arenaHeapAllocations += arena.heapAllocations();
+            arenaCachedBytes += arena.cachedBytes();
+        });
+    }
+
+    if(captureDroppedRecords.has_value())
+        std::format_to(std::back_inserter(out), "proxy_capture_dropped_records_total {}\n", *captureDroppedRecords);
+
+    std::format_to(std::back_inserter(out), "proxy_arena_allocations_total {}\n", arenaAllocations);
+    std::format_to(std::back_inserter(out), "proxy_arena_heap_allocations_total {}\n", arenaHeapAllocations);
+    std::format_to(std::back_inserter(out), "proxy_arena_cached_bytes {}\n", arenaCachedBytes);
+    if(const auto heap = current_heap_statistics())
+    {
+        std::format_to(std::back_inserter(out), "proxy_heap_allocations_total {}\n", heap->allocations);
+        std::format_to(std::back_inserter(out), "proxy_heap_bytes_in_use {}\n", heap->bytesInUse);
+    }
+
+    return out;
+}
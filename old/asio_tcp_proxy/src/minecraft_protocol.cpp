@@ -0,0 +1,393 @@
+#include <minecraft_protocol.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include <zlib_codec.hpp>
+
+namespace
+{
+    constexpr int32_t handshakePacket = 0x00;
+    constexpr int32_t encryptionRequestPacket = 0x01;
+    constexpr int32_t loginSuccessPacket = 0x02;
+    constexpr int32_t setCompressionPacket = 0x03;
+
+    constexpr int32_t loginIntent = 2;
+    constexpr int32_t transferIntent = 3;
+
+    constexpr uint8_t legacyPingPrefix = 0xFE;
+    constexpr size_t maxFrameLengthSize = 3;
+
+    size_t size_class_for(size_t size) noexcept
+    {
+        for(size_t sizeClass = 0; sizeClass < buffer_pool::sizeClassCount; ++sizeClass)
+        {
+            if(buffer_pool::sizeClasses[sizeClass] >= size)
+                return sizeClass;
+        }
+        return buffer_pool::sizeClassCount - 1;
+    }
+
+    std::vector<char>& scratch()
+    {
+        thread_local std::vector<char> buffer;
+        return buffer;
+    }
+}
+
+varint_status read_varint(std::span<const char> data, size_t& offset, int32_t& value) noexcept
+{
+    uint32_t result = 0;
+    for(size_t index = 0; index < maxVarIntSize; ++index)
+    {
+        if(offset + index >= data.size())
+            return varint_status::incomplete;
+
+        const auto byte = static_cast<uint8_t>(data[offset + index]);
+        result |= static_cast<uint32_t>(byte & 0x7F) << (7 * index);
+        if((byte & 0x80) == 0)
+        {
+            value = static_cast<int32_t>(result);
+            offset += index + 1;
+            return varint_status::complete;
+        }
+    }
+
+    return varint_status::malformed;
+}
+
+size_t write_varint(int32_t value, char* out) noexcept
+{
+    auto remaining = static_cast<uint32_t>(value);
+    size_t size = 0;
+    do
+    {
+        auto byte = static_cast<uint8_t>(remaining & 0x7F);
+        remaining >>= 7;
+        if(remaining != 0)
+            byte |= 0x80;
+        out[size++] = static_cast<char>(byte);
+    }
+    while(remaining != 0);
+
+    return size;
+}
+
+size_t varint_size(int32_t value) noexcept
+{
+    auto remaining = static_cast<uint32_t>(value);
+    size_t size = 1;
+    while((remaining >>= 7) != 0)
+        ++size;
+    return size;
+}
+
+//----------------------------------------------------------------------
+
+void minecraft_frame_reader::append(std::span<const char> data)
+{
+    if(_offset != 0)
+    {
+        _data.erase(_data.begin(), _data.begin() + static_cast<std::ptrdiff_t>(_offset));
+        _offset = 0;
+    }
+    _data.insert(_data.end(), data.begin(), data.end());
+}
+
+varint_status minecraft_frame_reader::next(std::span<const char>& frame) noexcept
+{
+    const auto data = remaining();
+
+    size_t lengthSize = 0;
+    int32_t length = 0;
+    const auto status = read_varint(data, lengthSize, length);
+    if(status != varint_status::complete)
+        return data.size() > maxFrameLengthSize ? varint_status::malformed : status;
+    if(lengthSize > maxFrameLengthSize || length < 0 || length > maxFrameLength)
+        return varint_status::malformed;
+    if(data.size() - lengthSize < static_cast<size_t>(length))
+        return varint_status::incomplete;
+
+    frame = data.subspan(lengthSize, static_cast<size_t>(length));
+    _offset += lengthSize + static_cast<size_t>(length);
+    return varint_status::complete;
+}
+
+std::span<const char> minecraft_frame_reader::remaining() const noexcept
+{
+    return std::span<const char>(_data).subspan(_offset);
+}
+
+void minecraft_frame_reader::clear() noexcept
+{
+    _data.clear();
+    _offset = 0;
+}
+
+//----------------------------------------------------------------------
+
+// Serializes forwarded frames into pooled buffers and queues them on a pipe.
+class minecraft_connection::output
+{
+private:
+    forwarding_pipe& _pipe;
+    std::chrono::steady_clock::time_point _readAt;
+    pooled_buffer _buffer;
+    size_t _size{0};
+public:
+    output(forwarding_pipe& pipe, std::chrono::steady_clock::time_point readAt)
+        : _pipe(pipe)
+        , _readAt(readAt)
+    {
+    }
+public:
+    void write(std::span<const char> data)
+    {
+        while(!data.empty())
+        {
+            if(!_buffer || _size == _buffer.size())
+            {
+                flush();
+                _buffer = buffer_pool::local().acquire(size_class_for(data.size()));
+            }
+
+            const auto count = std::min(data.size(), _buffer.size() - _size);
+            std::memcpy(_buffer.data().data() + _size, data.data(), count);
+            _size += count;
+            data = data.subspan(count);
+        }
+    }
+    void writeVarInt(int32_t value)
+    {
+        std::array<char, maxVarIntSize> bytes;
+        write({bytes.data(), write_varint(value, bytes.data())});
+    }
+    void writeFrame(std::span<const char> frame)
+    {
+        writeVarInt(static_cast<int32_t>(frame.size()));
+        write(frame);
+    }
+    void flush()
+    {
+        if(_size != 0)
+            _pipe.push(std::move(_buffer), _size, _readAt);
+        _size = 0;
+    }
+};
+
+minecraft_connection::minecraft_connection(const minecraft_options& options, compression_metrics& metrics)
+    : _options(options)
+    , _metrics(metrics)
+{
+}
+
+bool minecraft_connection::process(
+    minecraft_direction direction,
+    pooled_buffer buffer, size_t size, std::chrono::steady_clock::time_point readAt,
+    forwarding_pipe& pipe
+)
+{
+    auto& reader = direction == minecraft_direction::serverbound ? _serverbound : _clientbound;
+    const auto data = std::span<const char>(buffer.data().data(), size);
+
+    // Legacy server list pings predate the framing.
+    const auto legacyPing = _state == state::handshake
+        && direction == minecraft_direction::serverbound
+        && reader.remaining().empty()
+        && !data.empty()
+        && static_cast<uint8_t>(data.front()) == legacyPingPrefix;
+    if(legacyPing)
+        _state = state::passthrough;
+
+    if(_state == state::passthrough)
+    {
+        if(!reader.remaining().empty())
+        {
+            output out(pipe, readAt);
+            out.write(reader.remaining());
+            out.flush();
+            reader.clear();
+        }
+        pipe.push(std::move(buffer), size, readAt);
+        return true;
+    }
+
+    reader.append(data);
+    buffer.release();
+
+    output out(pipe, readAt);
+    std::span<const char> frame;
+    while(true)
+    {
+        const auto status = reader.next(frame);
+        if(status == varint_status::incomplete)
+            break;
+
+        if(status == varint_status::malformed)
+        {
+            if(_state == state::compressed)
+                return false;
+            _state = state::passthrough;
+        }
+        else if(!processFrame(direction, frame, out))
+        {
+            return false;
+        }
+
+        if(_state == state::passthrough)
+        {
+            out.write(reader.remaining());
+            reader.clear();
+            break;
+        }
+    }
+
+    out.flush();
+    return true;
+}
+
+bool minecraft_connection::processFrame(minecraft_direction direction, std::span<const char> frame, output& out)
+{
+    switch (_state)
+    {
+    case state::handshake:
+        if(direction == minecraft_direction::serverbound)
+            return processHandshake(frame, out);
+        out.writeFrame(frame);
+        _state = state::passthrough;
+        return true;
+    case state::login:
+        return processLogin(direction, frame, out);
+    case state::compressed:
+        return direction == minecraft_direction::serverbound ? decompressFrame(frame, out) : compressFrame(frame, out);
+    case state::passthrough:
+        break;
+    }
+
+    out.writeFrame(frame);
+    return true;
+}
+
+bool minecraft_connection::processHandshake(std::span<const char> frame, output& out)
+{
+    out.writeFrame(frame);
+    _state = state::passthrough;
+
+    size_t offset = 0;
+    int32_t packetId = 0;
+    int32_t protocolVersion = 0;
+    int32_t addressLength = 0;
+    int32_t intent = 0;
+
+    if(read_varint(frame, offset, packetId) != varint_status::complete || packetId != handshakePacket)
+        return true;
+    if(read_varint(frame, offset, protocolVersion) != varint_status::complete)
+        return true;
+    if(read_varint(frame, offset, addressLength) != varint_status::complete || addressLength < 0)
+        return true;
+
+    // Server address followed by the unsigned short port.
+    offset += static_cast<size_t>(addressLength) + 2;
+    if(offset > frame.size() || read_varint(frame, offset, intent) != varint_status::complete)
+        return true;
+
+    if(intent == loginIntent || intent == transferIntent)
+        _state = state::login;
+    return true;
+}
+
+bool minecraft_connection::processLogin(minecraft_direction direction, std::span<const char> frame, output& out)
+{
+    size_t offset = 0;
+    int32_t packetId = 0;
+    if(direction == minecraft_direction::serverbound || read_varint(frame, offset, packetId) != varint_status::complete)
+    {
+        out.writeFrame(frame);
+        return true;
+    }
+
+    switch (packetId)
+    {
+    case loginSuccessPacket:
+        if(_options.compressionThreshold >= 0)
+        {
+            // Everything after the injected Set Compression, Login Success included, uses the
+            // compressed format on the client side.
+            std::array<char, 1 + maxVarIntSize> setCompression{static_cast<char>(setCompressionPacket)};
+            const auto setCompressionSize = 1 + write_varint(_options.compressionThreshold, setCompression.data() + 1);
+            out.writeFrame({setCompression.data(), setCompressionSize});
+
+            _state = state::compressed;
+            return compressFrame(frame, out);
+        }
+        _state = state::passthrough;
+        break;
+    case encryptionRequestPacket:
+    case setCompressionPacket:
+        _state = state::passthrough;
+        break;
+    }
+
+    out.writeFrame(frame);
+    return true;
+}
+
+bool minecraft_connection::compressFrame(std::span<const char> frame, output& out)
+{
+    if(frame.size() < static_cast<size_t>(_options.compressionThreshold))
+    {
+        out.writeVarInt(static_cast<int32_t>(frame.size() + 1));
+        out.writeVarInt(0);
+        out.write(frame);
+        return true;
+    }
+
+    auto& compressed = scratch();
+    const auto startedAt = std::chrono::steady_clock::now();
+    const auto compressedSize = zlib_codec::local().compress(frame, compressed, _options.compressionLevel);
+    _metrics.compressionTime.record(std::chrono::steady_clock::now() - startedAt);
+
+    const auto dataLength = static_cast<int32_t>(frame.size());
+    const auto packetLength = varint_size(dataLength) + compressedSize;
+    if(packetLength > static_cast<size_t>(maxFrameLength))
+        return false;
+
+    out.writeVarInt(static_cast<int32_t>(packetLength));
+    out.writeVarInt(dataLength);
+    out.write({compressed.data(), compressedSize});
+
+    _metrics.framesCompressed.add();
+    _metrics.bytesBeforeCompression.add(frame.size());
+    _metrics.bytesAfterCompression.add(compressedSize);
+    return true;
+}
+
+bool minecraft_connection::decompressFrame(std::span<const char> frame, output& out)
+{
+    size_t offset = 0;
+    int32_t dataLength = 0;
+    if(read_varint(frame, offset, dataLength) != varint_status::complete || dataLength < 0 || dataLength > maxUncompressedLength)
+        return false;
+
+    const auto payload = frame.subspan(offset);
+    if(dataLength == 0)
+    {
+        out.writeFrame(payload);
+        return true;
+    }
+
+    auto& decompressed = scratch();
+    decompressed.resize(static_cast<size_t>(dataLength));
+
+    const auto startedAt = std::chrono::steady_clock::now();
+    if(!zlib_codec::local().decompress(payload, decompressed))
+        return false;
+    _metrics.decompressionTime.record(std::chrono::steady_clock::now() - startedAt);
+
+    out.writeFrame(decompressed);
+
+    _metrics.framesDecompressed.add();
+    _metrics.bytesDecompressed.add(decompressed.size());
+    return true;
+}
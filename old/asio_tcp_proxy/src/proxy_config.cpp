@@ -0,0 +1,455 @@
+#include <proxy_config.hpp>
+
+#include <charconv>
+#include <format>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+using boost::asio::ip::tcp;
+
+namespace
+{
+    enum class config_section
+    {
+        none,
+        global,
+        profile,
+        route
+    };
+
+    // Capture keys apply only once capture_directory enables capturing, wherever it appears.
+    struct global_settings
+    {
+        capture_options capture;
+        bool captureEnabled{false};
+        // First capture key other than capture_directory, reported if capturing stays off.
+        size_t captureLine{0};
+    };
+
+    // Route keys that depend on other keys or sections, resolved once the whole file is read.
+    struct route_settings
+    {
+        std::string profile;
+        size_t profileLine{0};
+        std::optional<mirror_overflow> mirrorOverflow;
+        size_t mirrorOverflowLine{0};
+    };
+
+    std::string_view trim(std::string_view text) noexcept
+    {
+        const auto first = text.find_first_not_of(" \t\r");
+        if(first == std::string_view::npos)
+            return {};
+        const auto last = text.find_last_not_of(" \t\r");
+        return text.substr(first, last - first + 1);
+    }
+
+    template<typename T>
+    T parse_number(std::string_view text)
+    {
+        T value{};
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if(error != std::errc{} || end != text.data() + text.size())
+            throw std::invalid_argument(std::format("'{}' is not a number", text));
+        return value;
+    }
+
+    bool parse_bool(std::string_view text)
+    {
+        if(text == "true" || text == "yes" || text == "on" || text == "1")
+            return true;
+        if(text == "false" || text == "no" || text == "off" || text == "0")
+            return false;
+        throw std::invalid_argument(std::format("'{}' is not a boolean", text));
+    }
+
+    // A number followed by us, ms, s, m or h, seconds without a unit.
+    std::chrono::steady_clock::duration parse_duration(std::string_view text)
+    {
+        const auto unit = text.find_first_not_of("0123456789");
+        const auto count = parse_number<int64_t>(text.substr(0, unit));
+        const auto suffix = unit == std::string_view::npos ? std::string_view("s") : text.substr(unit);
+
+        if(suffix == "us")
+            return std::chrono::microseconds(count);
+        if(suffix == "ms")
+            return std::chrono::milliseconds(count);
+        if(suffix == "s")
+            return std::chrono::seconds(count);
+        if(suffix == "m")
+            return std::chrono::minutes(count);
+        if(suffix == "h")
+            return std::chrono::hours(count);
+        throw std::invalid_argument(std::format("'{}' is not a duration", text));
+    }
+
+    // host:port, with the host in brackets for IPv6 addresses.
+    std::pair<std::string_view, std::string_view> split_host_port(std::string_view text)
+    {
+        const auto separator = text.rfind(':');
+        if(separator == std::string_view::npos || separator == 0 || separator + 1 == text.size())
+            throw std::invalid_argument(std::format("'{}' is not host:port", text));
+
+        auto host = text.substr(0, separator);
+        if(host.size() >= 2 && host.front() == '[' && host.back() == ']')
+            host = host.substr(1, host.size() - 2);
+        return {host, text.substr(separator + 1)};
+    }
+
+    tcp::endpoint parse_endpoint(std::string_view text)
+    {
+        const auto [host, port] = split_host_port(text);
+        boost::system::error_code error;
+        const auto address = boost::asio::ip::make_address(std::string(host), error);
+        if(error)
+            throw std::invalid_argument(std::format("'{}' is not an IP address", host));
+        return {address, parse_number<uint16_t>(port)};
+    }
+
+    backend_address parse_backend(std::string_view text)
+    {
+        const auto [host, port] = split_host_port(text);
+        return {std::string(host), std::string(port)};
+    }
+
+    void set_global(proxy_config& config, global_settings& settings, std::string_view key, std::string_view value, size_t lineNumber)
+    {
+        if(key.starts_with("capture_") && key != "capture_directory" && settings.captureLine == 0)
+            settings.captureLine = lineNumber;
+
+        if(key == "threads")
+            config.threads = parse_number<size_t>(value);
+        else if(key == "stats")
+            config.stats = parse_endpoint(value);
+        else if(key == "resolve_ttl")
+            config.resolveTimeToLive = parse_duration(value);
+        else if(key == "max_sessions")
+            config.admission.maxSessions = parse_number<size_t>(value);
+        else if(key == "address_rate")
+            config.admission.perAddress.rate = parse_number<double>(value);
+        else if(key == "address_burst")
+            config.admission.perAddress.burst = parse_number<double>(value);
+        else if(key == "accept_rate")
+            config.admission.accepts.rate = parse_number<double>(value);
+        else if(key == "accept_burst")
+            config.admission.accepts.burst = parse_number<double>(value);
+        else if(key == "capture_directory")
+        {
+            settings.capture.directory = std::string(value);
+            settings.captureEnabled = true;
+        }
+        else if(key == "capture_payloads")
+            settings.capture.payloads = parse_bool(value);
+        else if(key == "capture_file_size")
+            settings.capture.fileSize = parse_number<size_t>(value);
+        else if(key == "capture_max_files")
+            settings.capture.maxFiles = parse_number<size_t>(value);
+        else
+            throw std::invalid_argument(std::format("unknown global setting '{}'", key));
+    }
+
+    void set_profile(socket_profile& profile, std::string_view key, std::string_view value)
+    {
+        if(key == "no_delay")
+            profile.noDelay = parse_bool(value);
+        else if(key == "quick_ack")
+            profile.quickAck = parse_bool(value);
+        else if(key == "cork")
+            profile.cork = parse_bool(value);
+        else if(key == "not_sent_lowat")
+            profile.notSentLowWatermark = parse_number<int>(value);
+        else if(key == "receive_buffer")
+            profile.receiveBufferSize = parse_number<int>(value);
+        else if(key == "send_buffer")
+            profile.sendBufferSize = parse_number<int>(value);
+        else if(key == "busy_poll")
+            profile.busyPoll = parse_number<int>(value);
+        else if(key == "keepalive")
+            profile.keepAlive = parse_bool(value);
+        else if(key == "keepalive_idle")
+            profile.keepAliveIdle = std::chrono::duration_cast<std::chrono::seconds>(parse_duration(value));
+        else if(key == "keepalive_interval")
+            profile.keepAliveInterval = std::chrono::duration_cast<std::chrono::seconds>(parse_duration(value));
+        else if(key == "keepalive_count")
+            profile.keepAliveCount = parse_number<int>(value);
+        else if(key == "backlog")
+            profile.backlog = parse_number<int>(value);
+        else
+            throw std::invalid_argument(std::format("unknown profile setting '{}'", key));
+
+        if(profile.cork && profile.notSentLowWatermark != 0)
+            throw std::invalid_argument("cork and not_sent_lowat exclude each other");
+    }
+
+    template<typename Duration>
+    Duration parse_duration_as(std::string_view text)
+    {
+        return std::chrono::duration_cast<Duration>(parse_duration(text));
+    }
+
+    // Keys of the impair_ settings of a route, without the prefix.
+    void set_impairment(impairment_options& impairment, std::string_view key, std::string_view value)
+    {
+        if(key == "latency")
+            impairment.latency = parse_duration_as<std::chrono::microseconds>(value);
+        else if(key == "jitter")
+            impairment.jitter = parse_duration_as<std::chrono::microseconds>(value);
+        else if(key == "bandwidth")
+            impairment.bandwidth = parse_number<uint64_t>(value);
+        else if(key == "segment_size")
+            impairment.segmentSize = parse_number<size_t>(value);
+        else if(key == "segment_gap")
+            impairment.segmentGap = parse_duration_as<std::chrono::microseconds>(value);
+        else if(key == "stall_interval")
+            impairment.stallInterval = parse_duration_as<std::chrono::milliseconds>(value);
+        else if(key == "stall_duration")
+            impairment.stallDuration = parse_duration_as<std::chrono::milliseconds>(value);
+        else
+            throw std::invalid_argument(std::format("unknown impairment setting 'impair_{}'", key));
+    }
+
+    void set_route(route_config& route, route_settings& settings, std::string_view key, std::string_view value, size_t lineNumber)
+    {
+        auto& options = route.options;
+        if(key.starts_with("impair_"))
+        {
+            if(!options.session.impairment.has_value())
+                options.session.impairment.emplace();
+            set_impairment(*options.session.impairment, key.substr(7), value);
+            return;
+        }
+
+        if(key == "listen")
+        {
+            options.listen = parse_endpoint(value);
+        }
+        else if(key == "profile")
+        {
+            settings.profile = std::string(value);
+            settings.profileLine = lineNumber;
+        }
+        else if(key == "backend")
+        {
+            route.backends.push_back(parse_backend(value));
+        }
+        else if(key == "policy")
+        {
+            const auto policy = parse_load_balancing_policy(value);
+            if(!policy.has_value())
+                throw std::invalid_argument(std::format("unknown load balancing policy '{}'", value));
+            route.policy = *policy;
+        }
+        else if(key == "minecraft")
+        {
+            if(parse_bool(value))
+            {
+#if !defined(ASIO_TCP_PROXY_MINECRAFT)
+                throw std::invalid_argument("minecraft requires a proxy built with ASIO_TCP_PROXY_MINECRAFT");
+#endif
+                options.session.minecraft = minecraft_options{};
+                options.session.serverToClient.coalesceDelay = options.session.minecraft->coalesceDelay;
+            }
+        }
+        else if(key == "udp")
+        {
+            if(parse_bool(value))
+                options.udp = udp_proxy_options{};
+        }
+        else if(key == "mirror")
+        {
+            const auto backend = parse_backend(value);
+            options.session.mirror = mirror_options{backend.address, backend.port};
+        }
+        else if(key == "mirror_overflow")
+        {
+            if(value == "drop")
+                settings.mirrorOverflow = mirror_overflow::drop;
+            else if(value == "disconnect")
+                settings.mirrorOverflow = mirror_overflow::disconnect;
+            else
+                throw std::invalid_argument(std::format("unknown mirror overflow '{}'", value));
+            settings.mirrorOverflowLine = lineNumber;
+        }
+        else if(key == "bytes_per_second")
+        {
+            options.session.bytesPerSecond = parse_number<uint64_t>(value);
+        }
+        else if(key == "burst_bytes")
+        {
+            options.session.burstBytes = parse_number<uint64_t>(value);
+        }
+        else if(key == "idle_timeout")
+        {
+            options.session.idleTimeout = parse_duration(value);
+        }
+        else if(key == "half_closed_timeout")
+        {
+            options.session.halfClosedTimeout = parse_duration(value);
+        }
+        else if(key == "connect_timeout")
+        {
+            options.backendPool.connectTimeout = parse_duration(value);
+        }
+        else if(key == "idle_connections")
+        {
+            options.backendPool.idleConnections = parse_number<size_t>(value);
+        }
+        else
+        {
+            throw std::invalid_argument(std::format("unknown route setting '{}'", key));
+        }
+    }
+}
+
+proxy_config default_proxy_config()
+{
+    proxy_config config;
+    auto& route = config.routes.emplace_back();
+    route.backends.push_back({"localhost", "25565"});
+    return config;
+}
+
+proxy_config load_proxy_config(const std::string& path)
+{
+    std::ifstream file(path);
+    if(!file)
+        throw std::runtime_error(std::format("Failed to open config file {}", path));
+
+    proxy_config config;
+    global_settings globalSettings;
+    std::map<std::string, socket_profile, std::less<>> profiles;
+    // Profiles may be defined after the routes that use them.
+    std::vector<route_settings> routeSettings;
+
+    auto section = config_section::none;
+    socket_profile* profile = nullptr;
+    route_config* route = nullptr;
+
+    std::string line;
+    size_t lineNumber = 0;
+    while(std::getline(file, line))
+    {
+        ++lineNumber;
+        try
+        {
+            auto text = std::string_view(line);
+            text = trim(text.substr(0, text.find('#')));
+            if(text.empty())
+                continue;
+
+            if(text.front() == '[')
+            {
+                if(text.back() != ']')
+                    throw std::invalid_argument("unterminated section header");
+
+                const auto header = trim(text.substr(1, text.size() - 2));
+                const auto space = header.find(' ');
+                const auto kind = header.substr(0, space);
+                const auto name = space == std::string_view::npos ? std::string_view() : trim(header.substr(space));
+
+                if(kind == "global" && name.empty())
+                {
+                    section = config_section::global;
+                }
+                else if(kind == "profile" && !name.empty())
+                {
+                    if(!profiles.emplace(std::string(name), socket_profile{}).second)
+                        throw std::invalid_argument(std::format("duplicate profile '{}'", name));
+                    section = config_section::profile;
+                    profile = &profiles.find(name)->second;
+                }
+                else if(kind == "route" && !name.empty())
+                {
+                    for(const auto& existing : config.routes)
+                    {
+                        if(existing.options.name == name)
+                            throw std::invalid_argument(std::format("duplicate route '{}'", name));
+                    }
+                    section = config_section::route;
+                    route = &config.routes.emplace_back();
+                    route->options.name = std::string(name);
+                    routeSettings.emplace_back();
+                }
+                else
+                {
+                    throw std::invalid_argument(std::format("unknown section '{}'", header));
+                }
+                continue;
+            }
+
+            const auto equals = text.find('=');
+            if(equals == std::string_view::npos)
+                throw std::invalid_argument("expected key = value");
+            const auto key = trim(text.substr(0, equals));
+            const auto value = trim(text.substr(equals + 1));
+
+            switch (section)
+            {
+            case config_section::none:
+                throw std::invalid_argument("setting outside of a section");
+            case config_section::global:
+                set_global(config, globalSettings, key, value, lineNumber);
+                break;
+            case config_section::profile:
+                set_profile(*profile, key, value);
+                break;
+            case config_section::route:
+                set_route(*route, routeSettings.back(), key, value, lineNumber);
+                break;
+            }
+        }
+        catch (const std::invalid_argument& exception)
+        {
+            throw std::runtime_error(std::format("{}:{}: {}", path, lineNumber, exception.what()));
+        }
+    }
+
+    if(config.routes.empty())
+        throw std::runtime_error(std::format("{}: no routes configured", path));
+
+    if(globalSettings.captureEnabled)
+        config.capture = globalSettings.capture;
+    else if(globalSettings.captureLine != 0)
+        throw std::runtime_error(std::format("{}:{}: capture settings require capture_directory", path, globalSettings.captureLine));
+
+    for(size_t routeIndex = 0; routeIndex < config.routes.size(); ++routeIndex)
+    {
+        auto& configured = config.routes[routeIndex];
+        const auto& settings = routeSettings[routeIndex];
+        if(configured.backends.empty())
+            throw std::runtime_error(std::format("{}: route {} has no backends", path, configured.options.name));
+
+        for(size_t otherIndex = 0; otherIndex < routeIndex; ++otherIndex)
+        {
+            if(config.routes[otherIndex].options.listen == configured.options.listen)
+            {
+                throw std::runtime_error(std::format(
+                    "{}: routes {} and {} both listen on {}:{}", path, config.routes[otherIndex].options.name, configured.options.name,
+                    configured.options.listen.address().to_string(), configured.options.listen.port()
+                ));
+            }
+        }
+
+        if(settings.mirrorOverflow.has_value())
+        {
+            if(!configured.options.session.mirror.has_value())
+                throw std::runtime_error(std::format("{}:{}: mirror_overflow requires mirror", path, settings.mirrorOverflowLine));
+            configured.options.session.mirror->overflow = *settings.mirrorOverflow;
+        }
+
+        if(settings.profile.empty())
+            continue;
+
+        const auto found = profiles.find(settings.profile);
+        if(found == profiles.end())
+            throw std::runtime_error(std::format("{}:{}: unknown profile '{}'", path, settings.profileLine, settings.profile));
+        configured.options.session.sockets = found->second;
+    }
+
+    return config;
+}
@@ -0,0 +1,347 @@
+#include <proxy_session.hpp>
+
+#include <algorithm>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/write.hpp>
+
+#include <buffer_pool.hpp>
+#include <recycling_arena.hpp>
+
+using boost::asio::ip::tcp;
+using boost::asio::awaitable;
+using boost::asio::co_spawn;
+using boost::asio::detached;
+
+proxy_session::proxy_session(
+    boost::asio::io_context& context,
+    timing_wheel& timers,
+    delay_queue& delays,
+    tcp::socket clientSocket,
+    tcp::socket serverSocket,
+    backend_lease backend,
+    session_slot slot,
+    std::shared_ptr<session_mirror> mirror,
+    capture_writer* capture,
+    backend_metrics& metrics,
+    const proxy_session_options& options
+)
+    : _context(context)
+    , _timers(timers)
+    , _clientSocket(std::move(clientSocket))
+    , _serverSocket(std::move(serverSocket))
+    , _backend(std::move(backend))
+    , _slot(std::move(slot))
+    , _metrics(metrics)
+    , _id(_nextId.fetch_add(1, std::memory_order_relaxed))
+    , _clientToServerPipe(context.get_executor(), options.clientToServer)
+    , _serverToClientPipe(context.get_executor(), options.serverToClient)
+    , _mirror(std::move(mirror))
+    , _capture(capture)
+    , _bytesPerSecond(options.bytesPerSecond)
+    , _burstBytes(options.burstBytes)
+    , _idleTimeout(options.idleTimeout)
+    , _halfClosedTimeout(options.halfClosedTimeout)
+    , _lastActivity(std::chrono::steady_clock::now())
+    , _quickAck(options.sockets.quickAck)
+    , _cork(options.sockets.cork)
+    , _idleTimer([this]{ onIdleTimeout(); })
+{
+#if defined(ASIO_TCP_PROXY_MINECRAFT)
+    if(options.minecraft.has_value())
+        _minecraft = std::make_unique<minecraft_connection>(*options.minecraft, _metrics.compression);
+#endif
+
+    if(options.impairment.has_value())
+    {
+        const auto impair = [&](minecraft_direction direction, forwarding_pipe& pipe, uint64_t seed){
+            return std::make_unique<impairment_stage>(
+                context.get_executor(), delays, *options.impairment, seed,
+                [this, direction, &pipe](pooled_buffer buffer, size_t size, std::chrono::steady_clock::time_point readAt){
+                    return deliver(direction, pipe, std::move(buffer), size, readAt);
+                },
+                [&pipe]{ pipe.close(); }
+            );
+        };
+        _clientToServerImpairment = impair(minecraft_direction::serverbound, _clientToServerPipe, _id * 2);
+        _serverToClientImpairment = impair(minecraft_direction::clientbound, _serverToClientPipe, _id * 2 + 1);
+    }
+}
+
+proxy_session::~proxy_session()
+{
+    _metrics.sessionsClosed.add();
+    if(_mirror)
+        _mirror->finish();
+    if(_capture)
+        _capture->record(capture_record_type::session_close, _id, std::chrono::steady_clock::now());
+
+    log_message(
+        log_level::info,
+        "Session {} to {}:{} closed: client->server {} bytes in {} reads, server->client {} bytes in {} reads",
+        _id,
+        _backend->address(), _backend->port(),
+        _clientToServer.bytes, _clientToServer.reads,
+        _serverToClient.bytes, _serverToClient.reads
+    );
+}
+
+void proxy_session::start()
+{
+    _clientSocket.non_blocking(true);
+    _serverSocket.non_blocking(true);
+    _metrics.sessionsOpened.add();
+    scheduleIdleTimeout();
+    if(_mirror)
+        _mirror->start();
+    if(_capture)
+        _capture->record(capture_record_type::session_open, _id, _lastActivity);
+
+    spawnDirection(minecraft_direction::clientbound, _serverSocket, _clientSocket, _serverToClientPipe, _serverToClient, _metrics.serverToClient);
+    spawnDirection(minecraft_direction::serverbound, _clientSocket, _serverSocket, _clientToServerPipe, _clientToServer, _metrics.clientToServer);
+}
+
+void proxy_session::spawnDirection(
+    minecraft_direction direction,
+    tcp::socket& from, tcp::socket& to,
+    forwarding_pipe& pipe, direction_counters& counters, direction_metrics& metrics
+)
+{
+    co_spawn(
+        _context,
+        [self = shared_from_this(), direction, &from, &pipe, &counters, &metrics]{ return self->forward(direction, from, pipe, counters, metrics); },
+        detached
+    );
+
+    co_spawn(
+        _context,
+        [self = shared_from_this(), &pipe, &from, &to, &metrics]{ return self->drain(pipe, from, to, metrics); },
+        detached
+    );
+}
+
+// Reads into a fresh pooled buffer while previously read ones are still being written.
+// With the epoll reactor no buffer is held while waiting for the socket to become readable.
+awaitable<void> proxy_session::forward(
+    minecraft_direction direction,
+    tcp::socket& from, forwarding_pipe& pipe, direction_counters& counters, direction_metrics& metrics
+)
+{
+    thread_local log_sampler readSampler(1024);
+
+    adaptive_buffer_size bufferSize;
+    boost::system::error_code error;
+    auto* impairment = &pipe == &_clientToServerPipe ? _clientToServerImpairment.get() : _serverToClientImpairment.get();
+
+    // Shaped directions read at most a burst at a time, larger reads would overdraw the bucket.
+    std::optional<byte_rate_limiter> shaping;
+    std::optional<boost::asio::steady_timer> shapingTimer;
+    size_t maxSizeClass = buffer_pool::sizeClassCount - 1;
+    if(_bytesPerSecond != 0)
+    {
+        shaping.emplace(_bytesPerSecond, _burstBytes, std::chrono::steady_clock::now());
+        shapingTimer.emplace(_context);
+        while(maxSizeClass != 0 && buffer_pool::sizeClasses[maxSizeClass] > _burstBytes)
+            --maxSizeClass;
+    }
+
+    while(!pipe.closed())
+    {
+        if(pipe.full())
+        {
+            co_await pipe.waitForSpace();
+            continue;
+        }
+        if(impairment && impairment->full())
+        {
+            co_await impairment->waitForSpace();
+            continue;
+        }
+
+        if(shaping)
+        {
+            if(const auto delay = shaping->delay(std::chrono::steady_clock::now()); delay > delay.zero())
+            {
+                shapingTimer->expires_after(delay);
+                co_await shapingTimer->async_wait(boost::asio::redirect_error(use_arena, error));
+                continue;
+            }
+        }
+
+#if defined(BOOST_ASIO_HAS_IO_URING)
+        // Completion-based reads: the buffer is held while the read is in flight, registered
+        // slots are read into with fixed-buffer operations.
+        auto buffer = buffer_pool::local().acquire(std::min(bufferSize.sizeClass(), maxSizeClass));
+
+        const auto bytesRead = buffer.registered()
+            ? co_await from.async_read_some(buffer.registeredBuffer(), boost::asio::redirect_error(use_arena, error))
+            : co_await from.async_read_some(boost::asio::buffer(buffer.data().data(), buffer.size()), boost::asio::redirect_error(use_arena, error));
+        if(error || pipe.closed())
+            break;
+#else
+        co_await from.async_wait(tcp::socket::wait_read, boost::asio::redirect_error(use_arena, error));
+        if(error || pipe.closed())
+            break;
+
+        auto buffer = buffer_pool::local().acquire(std::min(bufferSize.sizeClass(), maxSizeClass));
+
+        const auto bytesRead = from.read_some(boost::asio::buffer(buffer.data().data(), buffer.size()), error);
+        if(error == boost::asio::error::would_block)
+            continue;
+        if(error)
+            break;
+#endif
+
+        const auto readAt = std::chrono::steady_clock::now();
+        _lastActivity = readAt;
+        if(_quickAck)
+            set_quick_ack(from);
+        if(shaping)
+            shaping->consume(bytesRead);
+        counters.record(bytesRead);
+        metrics.bytes.add(bytesRead);
+        metrics.messages.add();
+        if(readSampler.sample())
+            log_message(log_level::trace, "Session {} read {} bytes", _id, bytesRead);
+        if(_capture)
+        {
+            const auto type = direction == minecraft_direction::serverbound ? capture_record_type::client_to_server : capture_record_type::server_to_client;
+            _capture->record(type, _id, readAt, {buffer.data().data(), bytesRead});
+        }
+
+        bufferSize.update(bytesRead, buffer.size());
+        if(impairment)
+            impairment->push(std::move(buffer), bytesRead, readAt);
+        else if(!deliver(direction, pipe, std::move(buffer), bytesRead, readAt))
+            break;
+    }
+
+    // With an impairment stage the pipe is closed once the held reads have been released.
+    if(impairment)
+        impairment->close();
+    else
+        pipe.close();
+}
+
+bool proxy_session::deliver(
+    minecraft_direction direction,
+    forwarding_pipe& pipe, pooled_buffer buffer, size_t size, std::chrono::steady_clock::time_point readAt
+)
+{
+    if(pipe.aborted())
+        return false;
+
+#if defined(ASIO_TCP_PROXY_MINECRAFT)
+    if(_minecraft)
+    {
+        if(_minecraft->process(direction, std::move(buffer), size, readAt, pipe))
+            return true;
+
+        log_message(log_level::warning, "Session {} closed on a malformed Minecraft frame", _id);
+        boost::system::error_code error;
+        _clientSocket.shutdown(tcp::socket::shutdown_both, error);
+        _serverSocket.shutdown(tcp::socket::shutdown_both, error);
+        return false;
+    }
+#endif
+
+    pipe.push(std::move(buffer), size, readAt);
+    return true;
+}
+
+// Writes everything queued so far with a single gather write, then forwards the end of stream.
+// A finished direction leaves the session half-closed: the other one keeps forwarding until its
+// peer closes as well or the half-closed timeout expires.
+awaitable<void> proxy_session::drain(forwarding_pipe& pipe, tcp::socket& from, tcp::socket& to, direction_metrics& metrics)
+{
+    std::vector<boost::asio::const_buffer> buffers;
+    boost::system::error_code error;
+    bool corked = false;
+
+    // Only suspends in waitForData when there is nothing to write yet.
+    while(pipe.ready() || co_await pipe.waitForData())
+    {
+        // A single buffer leaves as it is anyway, corking only pays off when a batch spans
+        // several and would otherwise end in partial segments between them.
+        const auto chunkCount = pipe.gather(buffers);
+        if(_cork && !corked && chunkCount > 1)
+        {
+            set_cork(to, true);
+            corked = true;
+        }
+
+        co_await async_write(to, buffers, boost::asio::redirect_error(use_arena, error));
+        metrics.writes.add();
+        _lastActivity = std::chrono::steady_clock::now();
+        if(error)
+        {
+            // Stops only this direction's reader: cancelling operations on `from` would also
+            // abort the opposite direction's write to it.
+            pipe.abort();
+            from.shutdown(tcp::socket::shutdown_receive, error);
+            break;
+        }
+
+        // Copied only once the primary write completed, the mirror never delays it.
+        if(_mirror && &pipe == &_clientToServerPipe)
+            _mirror->copy(buffers);
+        pipe.consume(chunkCount, metrics.forwardingLatency);
+
+        // Pushes out the partial segment at the end of the batch.
+        if(corked && !pipe.ready())
+        {
+            set_cork(to, false);
+            corked = false;
+        }
+    }
+
+    if(!pipe.aborted())
+        to.shutdown(tcp::socket::shutdown_send, error);
+
+    --_openDirections;
+    scheduleIdleTimeout();
+}
+
+// The deadline is only moved forward lazily: activity just updates _lastActivity, and an
+// expiry that comes too early reschedules itself for the remaining time.
+void proxy_session::scheduleIdleTimeout()
+{
+    const auto timeout = _openDirections == 2 ? _idleTimeout : _halfClosedTimeout;
+    if(timeout == timeout.zero() || _openDirections == 0)
+    {
+        _idleTimer.cancel();
+        return;
+    }
+
+    _timers.schedule(_idleTimer, _lastActivity + timeout);
+}
+
+void proxy_session::onIdleTimeout()
+{
+    const auto timeout = _openDirections == 2 ? _idleTimeout : _halfClosedTimeout;
+    if(std::chrono::steady_clock::now() < _lastActivity + timeout)
+    {
+        scheduleIdleTimeout();
+        return;
+    }
+
+    _metrics.sessionsTimedOut.add();
+    log_message(log_level::info, "Session {} closed after {} ms without activity", _id, std::chrono::duration_cast<std::chrono::milliseconds>(timeout).count());
+    terminate();
+}
+
+void proxy_session::terminate() noexcept
+{
+    _clientToServerPipe.abort();
+    _serverToClientPipe.abort();
+    if(_clientToServerImpairment)
+        _clientToServerImpairment->abort();
+    if(_serverToClientImpairment)
+        _serverToClientImpairment->abort();
+
+    boost::system::error_code error;
+    _clientSocket.close(error);
+    _serverSocket.close(error);
+}
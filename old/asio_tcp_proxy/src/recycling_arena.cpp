@@ -0,0 +1,56 @@
+#include <recycling_arena.hpp>
+
+#include <algorithm>
+#include <new>
+
+recycling_arena::~recycling_arena()
+{
+    for(auto* block : _freeBlocks)
+    {
+        while(block != nullptr)
+            ::operator delete(std::exchange(block, block->next));
+    }
+}
+
+void* recycling_arena::allocate(size_t size)
+{
+    _allocations.add();
+
+    const auto sizeClass = (std::max<size_t>(size, 1) + granularity - 1) / granularity - 1;
+    if(sizeClass >= classCount)
+    {
+        _heapAllocations.add();
+        return ::operator new(size);
+    }
+
+    auto*& head = _freeBlocks[sizeClass];
+    if(head == nullptr)
+    {
+        _heapAllocations.add();
+        return ::operator new((sizeClass + 1) * granularity);
+    }
+
+    --_cachedBlocks[sizeClass];
+    _cachedBytes.store(_cachedBytes.load(std::memory_order_relaxed) - (sizeClass + 1) * granularity, std::memory_order_relaxed);
+    return std::exchange(head, head->next);
+}
+
+void recycling_arena::deallocate(void* pointer, size_t size) noexcept
+{
+    const auto sizeClass = (std::max<size_t>(size, 1) + granularity - 1) / granularity - 1;
+    if(sizeClass >= classCount || _cachedBlocks[sizeClass] >= maxCachedBlocksPerClass)
+    {
+        ::operator delete(pointer);
+        return;
+    }
+
+    _freeBlocks[sizeClass] = new(pointer) free_block{_freeBlocks[sizeClass]};
+    ++_cachedBlocks[sizeClass];
+    _cachedBytes.store(_cachedBytes.load(std::memory_order_relaxed) + (sizeClass + 1) * granularity, std::memory_order_relaxed);
+}
+
+recycling_arena& recycling_arena::local() noexcept
+{
+    thread_local recycling_arena arena;
+    return arena;
+}
@@ -0,0 +1,59 @@
+#include <resolver_cache.hpp>
+
+#include <format>
+#include <boost/asio/error.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+resolver_cache::resolver_cache(boost::asio::io_context& context, clock::duration timeToLive)
+    : _resolver(context)
+    , _timeToLive(timeToLive)
+{
+}
+
+boost::asio::awaitable<resolver_cache::results_type> resolver_cache::resolve(std::string_view host, std::string_view port)
+{
+    abort_handle abort;
+    co_return co_await resolve(host, port, abort);
+}
+
+boost::asio::awaitable<resolver_cache::results_type> resolver_cache::resolve(std::string_view host, std::string_view port, abort_handle& abort)
+{
+    auto key = std::format("{}:{}", host, port);
+
+    const auto now = clock::now();
+    if(const auto it = _entries.find(key); it != _entries.end() && it->second.expiry > now)
+        co_return it->second.results;
+
+    auto lookup = std::make_shared<pending_lookup>(boost::asio::steady_timer(_resolver.get_executor(), boost::asio::steady_timer::time_point::max()));
+    _resolver.async_resolve(host, port, [lookup](const boost::system::error_code& error, results_type results){
+        lookup->results = std::move(results);
+        lookup->error = error;
+        lookup->done = true;
+        lookup->signal.cancel();
+    });
+
+    abort._lookup = lookup;
+    boost::system::error_code error;
+    co_await lookup->signal.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, error));
+    abort._lookup.reset();
+
+    if(!lookup->done)
+        throw boost::system::system_error(boost::asio::error::operation_aborted);
+    if(lookup->error)
+        throw boost::system::system_error(lookup->error);
+
+    _entries.insert_or_assign(std::move(key), entry{lookup->results, clock::now() + _timeToLive});
+    co_return lookup->results;
+}
+
+void resolver_cache::invalidate(std::string_view host, std::string_view port)
+{
+    _entries.erase(std::format("{}:{}", host, port));
+}
+
+void resolver_cache::abort_handle::abort()
+{
+    if(_lookup != nullptr && !_lookup->done)
+        _lookup->signal.cancel();
+}
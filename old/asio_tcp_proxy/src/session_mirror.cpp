@@ -0,0 +1,215 @@
+#include <session_mirror.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/connect.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/write.hpp>
+
+#include <buffer_pool.hpp>
+#include <logging.hpp>
+#include <recycling_arena.hpp>
+
+using boost::asio::ip::tcp;
+using boost::asio::awaitable;
+using boost::asio::co_spawn;
+using boost::asio::detached;
+using boost::asio::use_awaitable;
+
+namespace
+{
+    size_t size_class_for(size_t size) noexcept
+    {
+        size_t sizeClass = 0;
+        while(sizeClass + 1 < buffer_pool::sizeClassCount && buffer_pool::sizeClasses[sizeClass] < size)
+            ++sizeClass;
+        return sizeClass;
+    }
+}
+
+session_mirror::session_mirror(
+    boost::asio::io_context& context,
+    timing_wheel& timers,
+    resolver_cache& resolverCache,
+    mirror_metrics& metrics,
+    const mirror_options& options
+)
+    : _context(context)
+    , _timers(timers)
+    , _resolverCache(resolverCache)
+    , _metrics(metrics)
+    , _options(options)
+    , _socket(context)
+    , _pipe(context.get_executor())
+{
+}
+
+void session_mirror::start()
+{
+    _metrics.sessions.add();
+    co_spawn(_context, [self = shared_from_this()]{ return self->run(); }, detached);
+}
+
+// Consecutive buffers are packed into as few pooled buffers as possible, small writes
+// would otherwise each hold a buffer of the smallest size class.
+void session_mirror::copy(std::span<const boost::asio::const_buffer> buffers)
+{
+    if(_pipe.closed())
+        return;
+
+    size_t totalSize = 0;
+    for(const auto& buffer : buffers)
+        totalSize += buffer.size();
+
+    if(_pipe.queuedBytes() + totalSize > _options.maxQueuedBytes)
+    {
+        if(_options.overflow == mirror_overflow::drop)
+        {
+            _metrics.droppedBytes.add(totalSize);
+            return;
+        }
+
+        log_message(log_level::warning, "Disconnecting shadow {}:{}, it fell {} bytes behind", _options.address, _options.port, _pipe.queuedBytes());
+        _metrics.droppedBytes.add(totalSize);
+        _metrics.disconnects.add();
+        disconnect();
+        return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    pooled_buffer target;
+    size_t targetSize = 0;
+
+    for(const auto& buffer : buffers)
+    {
+        const auto* data = static_cast<const char*>(buffer.data());
+        auto remaining = buffer.size();
+        while(remaining != 0)
+        {
+            if(!target || targetSize == target.size())
+            {
+                if(target)
+                    _pipe.push(std::move(target), targetSize, now);
+                target = buffer_pool::local().acquire(size_class_for(totalSize));
+                targetSize = 0;
+            }
+
+            const auto count = std::min(remaining, target.size() - targetSize);
+            std::memcpy(target.data().data() + targetSize, data, count);
+            targetSize += count;
+            totalSize -= count;
+            data += count;
+            remaining -= count;
+        }
+    }
+
+    if(target)
+        _pipe.push(std::move(target), targetSize, now);
+}
+
+void session_mirror::finish() noexcept
+{
+    _pipe.close();
+}
+
+awaitable<void> session_mirror::run()
+{
+    // As for backends, the timeout covers the lookup too.
+    resolver_cache::abort_handle lookup;
+    bool timedOut = false;
+    wheel_timer timeout([&]{
+        timedOut = true;
+        lookup.abort();
+        boost::system::error_code error;
+        _socket.close(error);
+    });
+    _timers.schedule(timeout, std::chrono::steady_clock::now() + _options.connectTimeout);
+
+    bool resolved = false;
+    bool failed = false;
+    try
+    {
+        const auto endpoints = co_await _resolverCache.resolve(_options.address, _options.port, lookup);
+        resolved = true;
+        if(timedOut)
+            throw boost::system::system_error(boost::asio::error::timed_out);
+
+        co_await boost::asio::async_connect(_socket, endpoints, use_awaitable);
+        timeout.cancel();
+    }
+    catch (const std::exception& exception)
+    {
+        log_message(log_level::warning, "Failed to connect to shadow {}:{}, {}", _options.address, _options.port, timedOut ? "timed out" : exception.what());
+        failed = true;
+    }
+
+    if(failed)
+    {
+        _metrics.connectFailures.add();
+        if(!resolved || !timedOut)
+            _resolverCache.invalidate(_options.address, _options.port);
+        disconnect();
+        co_return;
+    }
+
+    _socket.non_blocking(true);
+    co_spawn(_context, [self = shared_from_this()]{ return self->discardResponses(); }, detached);
+
+    std::vector<boost::asio::const_buffer> buffers;
+    boost::system::error_code error;
+
+    while(_pipe.ready() || co_await _pipe.waitForData())
+    {
+        const auto chunkCount = _pipe.gather(buffers);
+        const auto bytesWritten = co_await async_write(_socket, buffers, boost::asio::redirect_error(use_arena, error));
+        _metrics.bytes.add(bytesWritten);
+        if(error)
+        {
+            if(!_pipe.aborted())
+                _metrics.disconnects.add();
+            disconnect();
+            co_return;
+        }
+
+        _pipe.consume(chunkCount, _metrics.lag);
+    }
+
+    if(!_pipe.aborted())
+        _socket.shutdown(tcp::socket::shutdown_send, error);
+}
+
+// Keeps the shadow's send side from stalling; its responses go nowhere.
+awaitable<void> session_mirror::discardResponses()
+{
+    thread_local std::array<char, 16 * 1024> scratch;
+    boost::system::error_code error;
+
+    while(_socket.is_open())
+    {
+        co_await _socket.async_wait(tcp::socket::wait_read, boost::asio::redirect_error(use_arena, error));
+        if(error)
+            break;
+
+        _socket.read_some(boost::asio::buffer(scratch.data(), scratch.size()), error);
+        if(error == boost::asio::error::would_block)
+            continue;
+        if(error)
+            break;
+    }
+
+    // The shadow closed on its own, nothing more can be mirrored.
+    if(!_pipe.closed())
+        _metrics.disconnects.add();
+    disconnect();
+}
+
+void session_mirror::disconnect() noexcept
+{
+    _pipe.abort();
+
+    boost::system::error_code error;
+    _socket.close(error);
+}
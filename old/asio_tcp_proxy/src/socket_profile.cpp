@@ -0,0 +1,104 @@
+#include <socket_profile.hpp>
+
+#if !defined(_WIN32)
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+
+#include <settable_socket_option.hpp>
+
+using boost::asio::ip::tcp;
+
+// Each option is only set where the platform defines it; TCP_QUICKACK, TCP_CORK and
+// SO_BUSY_POLL are Linux only.
+namespace
+{
+#if defined(TCP_QUICKACK)
+    using quick_ack = settable_socket_option<IPPROTO_TCP, TCP_QUICKACK>;
+#endif
+#if defined(TCP_CORK)
+    using cork = settable_socket_option<IPPROTO_TCP, TCP_CORK>;
+#endif
+#if defined(TCP_NOTSENT_LOWAT)
+    using not_sent_low_watermark = settable_socket_option<IPPROTO_TCP, TCP_NOTSENT_LOWAT>;
+#endif
+#if defined(SO_BUSY_POLL)
+    using busy_poll = settable_socket_option<SOL_SOCKET, SO_BUSY_POLL>;
+#endif
+#if defined(TCP_KEEPIDLE)
+    using keep_alive_idle = settable_socket_option<IPPROTO_TCP, TCP_KEEPIDLE>;
+#endif
+#if defined(TCP_KEEPINTVL)
+    using keep_alive_interval = settable_socket_option<IPPROTO_TCP, TCP_KEEPINTVL>;
+#endif
+#if defined(TCP_KEEPCNT)
+    using keep_alive_count = settable_socket_option<IPPROTO_TCP, TCP_KEEPCNT>;
+#endif
+
+    template<typename Socket>
+    void apply_buffer_sizes(Socket& socket, const socket_profile& profile, boost::system::error_code& error)
+    {
+        if(profile.receiveBufferSize != 0)
+            socket.set_option(boost::asio::socket_base::receive_buffer_size(profile.receiveBufferSize), error);
+        if(profile.sendBufferSize != 0)
+            socket.set_option(boost::asio::socket_base::send_buffer_size(profile.sendBufferSize), error);
+    }
+}
+
+void apply_socket_profile(tcp::socket& socket, const socket_profile& profile)
+{
+    boost::system::error_code error;
+
+    socket.set_option(tcp::no_delay(profile.noDelay), error);
+    apply_buffer_sizes(socket, profile, error);
+
+#if defined(TCP_NOTSENT_LOWAT)
+    if(profile.notSentLowWatermark != 0)
+        socket.set_option(not_sent_low_watermark(profile.notSentLowWatermark), error);
+#endif
+#if defined(SO_BUSY_POLL)
+    if(profile.busyPoll != 0)
+        socket.set_option(busy_poll(profile.busyPoll), error);
+#endif
+    if(profile.quickAck)
+        set_quick_ack(socket);
+
+    if(profile.keepAlive)
+    {
+        socket.set_option(boost::asio::socket_base::keep_alive(true), error);
+#if defined(TCP_KEEPIDLE)
+        if(profile.keepAliveIdle.count() != 0)
+            socket.set_option(keep_alive_idle(static_cast<int>(profile.keepAliveIdle.count())), error);
+#endif
+#if defined(TCP_KEEPINTVL)
+        if(profile.keepAliveInterval.count() != 0)
+            socket.set_option(keep_alive_interval(static_cast<int>(profile.keepAliveInterval.count())), error);
+#endif
+#if defined(TCP_KEEPCNT)
+        if(profile.keepAliveCount != 0)
+            socket.set_option(keep_alive_count(profile.keepAliveCount), error);
+#endif
+    }
+}
+
+void apply_socket_profile(tcp::acceptor& acceptor, const socket_profile& profile)
+{
+    boost::system::error_code error;
+    apply_buffer_sizes(acceptor, profile, error);
+}
+
+void set_quick_ack([[maybe_unused]] tcp::socket& socket) noexcept
+{
+#if defined(TCP_QUICKACK)
+    boost::system::error_code error;
+    socket.set_option(quick_ack(1), error);
+#endif
+}
+
+void set_cork([[maybe_unused]] tcp::socket& socket, [[maybe_unused]] bool enabled) noexcept
+{
+#if defined(TCP_CORK)
+    boost::system::error_code error;
+    socket.set_option(cork(enabled ? 1 : 0), error);
+#endif
+}
@@ -0,0 +1,73 @@
+#include <stats_server.hpp>
+
+#include <format>
+#include <string_view>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/write.hpp>
+
+#include <logging.hpp>
+
+using boost::asio::ip::tcp;
+using boost::asio::awaitable;
+using boost::asio::use_awaitable;
+
+namespace
+{
+    constexpr size_t maxRequestSize = 8 * 1024;
+
+    awaitable<void> serve_stats_request(tcp::socket socket, const std::function<std::string()>& render)
+    {
+        std::string request;
+        boost::system::error_code error;
+        co_await boost::asio::async_read_until(
+            socket,
+            boost::asio::dynamic_buffer(request, maxRequestSize),
+            "\r\n\r\n",
+            boost::asio::redirect_error(use_awaitable, error)
+        );
+        if(error)
+            co_return;
+
+        const std::string_view requestLine{request.data(), request.find("\r\n")};
+
+        std::string response;
+        if(requestLine.starts_with("GET /metrics ") || requestLine.starts_with("GET /stats "))
+        {
+            const auto body = render();
+            response = std::format(
+                "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: {}\r\nConnection: close\r\n\r\n{}",
+                body.size(), body
+            );
+        }
+        else
+        {
+            response = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        }
+
+        co_await boost::asio::async_write(socket, boost::asio::buffer(response), boost::asio::redirect_error(use_awaitable, error));
+        socket.shutdown(tcp::socket::shutdown_both, error);
+    }
+}
+
+awaitable<void> run_stats_server(boost::asio::io_context& context, tcp::endpoint endpoint, std::function<std::string()> render)
+{
+    tcp::acceptor acceptor(context, endpoint);
+    log_message(log_level::info, "Serving stats on http://{}:{}/metrics", endpoint.address().to_string(), endpoint.port());
+
+    for (;;)
+    {
+        boost::system::error_code error;
+        tcp::socket socket = co_await acceptor.async_accept(boost::asio::redirect_error(use_awaitable, error));
+        if(error)
+        {
+            log_message(log_level::error, "Failed to accept stats connection: {}", error.message());
+            continue;
+        }
+
+        boost::asio::co_spawn(context, serve_stats_request(std::move(socket), render), boost::asio::detached);
+    }
+}
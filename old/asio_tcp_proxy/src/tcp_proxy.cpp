@@ -0,0 +1,245 @@
+#include <tcp_proxy.hpp>
+
+#include <algorithm>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/ip/udp.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include <buffer_pool.hpp>
+#include <logging.hpp>
+#include <proxy_session.hpp>
+#include <socket_profile.hpp>
+
+using boost::asio::ip::tcp;
+using boost::asio::awaitable;
+using boost::asio::co_spawn;
+using boost::asio::detached;
+using boost::asio::use_awaitable;
+
+worker_route::worker_route(proxy_worker& worker, const route_options& options, backend_set& backends)
+    : _options(options)
+    , _backends(backends)
+    , _metrics(backends.size())
+{
+    _backendPools.reserve(backends.size());
+    for(size_t backendIndex = 0; backendIndex < backends.size(); ++backendIndex)
+    {
+        _backendPools.push_back(std::make_unique<backend_connection_pool>(
+            worker.context(),
+            worker.timers(),
+            worker.resolverCache(),
+            backends[backendIndex],
+            _metrics.backend(backendIndex),
+            backends.healthCheckOptions(),
+            options.backendPool
+        ));
+    }
+
+    if(options.udp.has_value() && (udp_proxy::sharedListeningPort || worker.index() == 0))
+    {
+        _udpProxy = std::make_unique<udp_proxy>(
+            worker.context(), worker.timers(), backends, worker.resolverCache(), _metrics.udp(),
+            boost::asio::ip::udp::endpoint(options.listen.address(), options.listen.port()), *options.udp
+        );
+    }
+}
+
+void worker_route::start()
+{
+    for(auto& backendPool : _backendPools)
+        backendPool->start();
+    if(_udpProxy)
+        _udpProxy->start();
+}
+
+//----------------------------------------------------------------------
+
+proxy_worker::proxy_worker(size_t index, std::chrono::steady_clock::duration resolveTimeToLive)
+    : _index(index)
+    , _workGuard(boost::asio::make_work_guard(_context))
+    , _timers(_context)
+    , _delays(_context)
+    , _resolverCache(_context, resolveTimeToLive)
+{
+}
+
+size_t proxy_worker::addRoute(const route_options& options, backend_set& backends)
+{
+    _routes.push_back(std::make_unique<worker_route>(*this, options, backends));
+    return _routes.size() - 1;
+}
+
+void proxy_worker::capture(const capture_options& options)
+{
+    _capture = std::make_unique<capture_writer>(options, _index);
+}
+
+void proxy_worker::start()
+{
+    _timers.start();
+    _delays.start();
+    for(auto& route : _routes)
+        route->start();
+}
+
+void proxy_worker::run()
+{
+    {
+        std::lock_guard lock(_arenaMutex);
+        _arena = &recycling_arena::local();
+    }
+#if defined(BOOST_ASIO_HAS_IO_URING)
+    buffer_pool::local().registerBuffers(_context, buffer_pool::registeredSlotsPerThread);
+    _context.run();
+    buffer_pool::local().unregisterBuffers();
+#else
+    _context.run();
+#endif
+    std::lock_guard lock(_arenaMutex);
+    _arena = nullptr;
+}
+
+void proxy_worker::stop()
+{
+    _workGuard.reset();
+    _context.stop();
+}
+
+//----------------------------------------------------------------------
+
+namespace
+{
+    constexpr size_t maxBackendAttempts = 3;
+
+    awaitable<void> start_proxy_session(
+        proxy_worker& worker,
+        worker_route& route,
+        tcp::socket clientSocket,
+        boost::asio::ip::address clientAddress,
+        session_slot slot,
+        std::chrono::steady_clock::time_point acceptedAt
+    )
+    {
+        auto& listenerMetrics = route.metrics().listener();
+        listenerMetrics.acceptedConnections.add();
+        const auto& sessionOptions = route.sessionOptions();
+        apply_socket_profile(clientSocket, sessionOptions.sockets);
+        const auto attempts = std::min(route.backends().size(), maxBackendAttempts);
+
+        for(size_t attempt = 0; attempt < attempts; ++attempt)
+        {
+            auto backend = route.backends().select(clientAddress);
+            const auto& proxiedAddress = backend->address();
+            const auto& proxiedPort = backend->port();
+
+            try
+            {
+                log_message(log_level::debug, "Trying to establish connection to {}:{}", proxiedAddress, proxiedPort);
+                tcp::socket serverSocket = co_await route.backendPool(backend->index()).acquire();
+                log_message(log_level::info, "Established connection to {}:{}", proxiedAddress, proxiedPort);
+
+                try
+                {
+                    apply_socket_profile(serverSocket, sessionOptions.sockets);
+                    auto& backendMetrics = route.metrics().backend(backend->index());
+
+                    std::shared_ptr<session_mirror> mirror;
+                    if(sessionOptions.mirror.has_value())
+                    {
+                        mirror = std::make_shared<session_mirror>(
+                            worker.context(), worker.timers(), worker.resolverCache(), route.metrics().mirror(), *sessionOptions.mirror
+                        );
+                    }
+
+                    std::make_shared<proxy_session>(
+                        worker.context(), worker.timers(), worker.delays(), std::move(clientSocket), std::move(serverSocket), std::move(backend), std::move(slot),
+                        std::move(mirror), worker.captureWriter(), backendMetrics, sessionOptions
+                    )->start();
+                    listenerMetrics.acceptLatency.record(std::chrono::steady_clock::now() - acceptedAt);
+                }
+                catch (const std::exception& exception)
+                {
+                    log_message(log_level::error, "Failed to start proxy session: {}", exception.what());
+                }
+                co_return;
+            }
+            catch (const std::exception& exception)
+            {
+                log_message(log_level::error, "Failed to establish connection to address: {}:{}, {}", proxiedAddress, proxiedPort, exception.what());
+            }
+        }
+
+        listenerMetrics.rejectedConnections.add();
+    }
+}
+
+awaitable<void> start_tcp_proxy(
+    boost::asio::io_context& acceptContext,
+    std::span<const std::unique_ptr<proxy_worker>> workers,
+    size_t routeIndex,
+    admission_control& admission
+)
+{
+    const auto& options = workers.front()->route(routeIndex).options();
+    const auto& profile = options.session.sockets;
+
+    // Buffer sizes set on the listening socket are inherited by accepted sockets before
+    // the handshake completes, which is the only way to influence the window scale.
+    tcp::acceptor acceptor(acceptContext);
+    acceptor.open(options.listen.protocol());
+    acceptor.set_option(tcp::acceptor::reuse_address(true));
+    apply_socket_profile(acceptor, profile);
+    acceptor.bind(options.listen);
+    acceptor.listen(profile.backlog);
+    log_message(log_level::info, "Route {} listening on {}:{}", options.name, options.listen.address().to_string(), options.listen.port());
+
+    size_t nextWorker = 0;
+
+    // Written by the accepting thread, which runs the first worker.
+    auto& acceptorMetrics = workers.front()->route(routeIndex).metrics().listener();
+    log_sampler throttleSampler(1024);
+
+    for (;;)
+    {
+        log_message(log_level::debug, "Waiting for next client");
+        try
+        {
+            auto& worker = *workers[nextWorker % workers.size()];
+
+            tcp::endpoint endpoint;
+            tcp::socket clientSocket = co_await acceptor.async_accept(worker.context(), endpoint, use_awaitable);
+            const auto acceptedAt = std::chrono::steady_clock::now();
+            const auto address = endpoint.address();
+
+            // Turned away before any session state or backend connection exists. The reset
+            // avoids leaving a TIME_WAIT entry behind for every rejected client.
+            session_slot slot;
+            if(const auto result = admission.admit(address, acceptedAt, slot); result != admission_result::admitted)
+            {
+                acceptorMetrics.throttledConnections[static_cast<size_t>(result)].add();
+                if(throttleSampler.sample())
+                    log_message(log_level::warning, "Throttled connection from {} ({})", address.to_string(), to_string(result));
+
+                boost::system::error_code error;
+                clientSocket.set_option(tcp::socket::linger(true, 0), error);
+                clientSocket.close(error);
+                continue;
+            }
+
+            ++nextWorker;
+            log_message(log_level::info, "Received connection from: {}:{}", address.to_string(), endpoint.port());
+
+            co_spawn(
+                worker.context(),
+                start_proxy_session(worker, worker.route(routeIndex), std::move(clientSocket), address, std::move(slot), acceptedAt),
+                detached
+            );
+        }
+        catch (const std::exception& exception)
+        {
+            log_message(log_level::error, "Failed to accept connection: {}", exception.what());
+        }
+    }
+}
@@ -0,0 +1,206 @@
+#include <timing_wheel.hpp>
+
+#include <algorithm>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+
+#include <recycling_arena.hpp>
+
+using boost::asio::awaitable;
+
+wheel_timer::wheel_timer(std::function<void()> callback)
+    : _callback(std::move(callback))
+{
+}
+
+wheel_timer::~wheel_timer()
+{
+    cancel();
+}
+
+void wheel_timer::cancel() noexcept
+{
+    if(_wheel != nullptr)
+        _wheel->remove(*this);
+}
+
+//----------------------------------------------------------------------
+
+timing_wheel::timing_wheel(boost::asio::io_context& context, clock::duration resolution)
+    : _timer(context)
+    , _resolution(std::max<clock::duration>(resolution, std::chrono::milliseconds(1)))
+    , _origin(clock::now())
+{
+    for(auto& level : _slots)
+    {
+        for(auto& slot : level)
+            slot._next = slot._previous = &slot;
+    }
+    _expiring._next = _expiring._previous = &_expiring;
+}
+
+// Timers owned by objects that outlive the wheel, such as sessions held by coroutine frames
+// until the io_context goes away, are detached so that their destructors leave the wheel alone.
+timing_wheel::~timing_wheel()
+{
+    const auto detach = [](timer_list_node& list){
+        for(auto* node = list._next; node != &list;)
+        {
+            auto& timer = static_cast<wheel_timer&>(*std::exchange(node, node->_next));
+            timer._wheel = nullptr;
+            timer._next = timer._previous = nullptr;
+        }
+    };
+
+    for(auto& level : _slots)
+    {
+        for(auto& slot : level)
+            detach(slot);
+    }
+    detach(_expiring);
+}
+
+void timing_wheel::start()
+{
+    boost::asio::co_spawn(_timer.get_executor(), run(), boost::asio::detached);
+}
+
+void timing_wheel::schedule(wheel_timer& timer, clock::time_point deadline)
+{
+    if(timer._wheel == this)
+        remove(timer);
+    else
+        timer.cancel();
+
+    // The tick is not advanced while the wheel is empty.
+    if(_size == 0)
+        _currentTick = std::max(_currentTick, tickOf(clock::now()));
+
+    // Rounded up, a timer never fires before its deadline.
+    const auto sinceOrigin = std::max(deadline - _origin, clock::duration::zero());
+    timer._expiryTick = std::max<uint64_t>((sinceOrigin + _resolution - clock::duration(1)) / _resolution, _currentTick + 1);
+    timer._wheel = this;
+    insert(timer);
+
+    // The ticking loop sleeps while the wheel is empty.
+    if(++_size == 1)
+        _timer.cancel();
+}
+
+awaitable<void> timing_wheel::run()
+{
+    boost::system::error_code error;
+    while(true)
+    {
+        if(_size == 0)
+            _timer.expires_at(clock::time_point::max());
+        else
+            _timer.expires_at(_origin + _resolution * (_currentTick + 1));
+
+        co_await _timer.async_wait(boost::asio::redirect_error(use_arena, error));
+        advance(tickOf(clock::now()));
+    }
+}
+
+void timing_wheel::advance(uint64_t tick)
+{
+    // While empty the wheel jumps ahead; slots are only meaningful relative to pending timers.
+    if(_size == 0)
+    {
+        _currentTick = std::max(_currentTick, tick);
+        return;
+    }
+
+    while(_currentTick < tick && _size != 0)
+    {
+        ++_currentTick;
+
+        for(size_t level = 1; level < levelCount; ++level)
+        {
+            if((_currentTick & ((uint64_t{1} << (slotBits * level)) - 1)) != 0)
+                break;
+            cascade(level);
+        }
+
+        splice(_slots[0][_currentTick & (slotsPerLevel - 1)], _expiring);
+        while(_expiring._next != &_expiring)
+        {
+            // The callback may reschedule or destroy the timer and cancel others.
+            auto& timer = static_cast<wheel_timer&>(*_expiring._next);
+            remove(timer);
+            timer._callback();
+        }
+    }
+
+    _currentTick = std::max(_currentTick, tick);
+}
+
+void timing_wheel::insert(wheel_timer& timer) noexcept
+{
+    const auto delta = timer._expiryTick - _currentTick;
+
+    size_t level = 0;
+    while(level + 1 < levelCount && delta >= (uint64_t{1} << (slotBits * (level + 1))))
+        ++level;
+
+    // Beyond the top level the timer parks in the furthest slot and is re-inserted from there.
+    const auto expiryTick = level + 1 == levelCount && delta >= (uint64_t{1} << (slotBits * levelCount))
+        ? _currentTick + (uint64_t{1} << (slotBits * levelCount)) - 1
+        : timer._expiryTick;
+
+    link(_slots[level][(expiryTick >> (slotBits * level)) & (slotsPerLevel - 1)], timer);
+}
+
+void timing_wheel::cascade(size_t level) noexcept
+{
+    timer_list_node pending;
+    pending._next = pending._previous = &pending;
+    splice(_slots[level][(_currentTick >> (slotBits * level)) & (slotsPerLevel - 1)], pending);
+
+    while(pending._next != &pending)
+    {
+        auto& timer = static_cast<wheel_timer&>(*pending._next);
+        unlink(timer);
+        insert(timer);
+    }
+}
+
+void timing_wheel::remove(wheel_timer& timer) noexcept
+{
+    unlink(timer);
+    timer._wheel = nullptr;
+    --_size;
+}
+
+uint64_t timing_wheel::tickOf(clock::time_point time) const noexcept
+{
+    return static_cast<uint64_t>(std::max(time - _origin, clock::duration::zero()) / _resolution);
+}
+
+void timing_wheel::link(timer_list_node& list, timer_list_node& node) noexcept
+{
+    node._previous = list._previous;
+    node._next = &list;
+    list._previous->_next = &node;
+    list._previous = &node;
+}
+
+void timing_wheel::unlink(timer_list_node& node) noexcept
+{
+    node._previous->_next = node._next;
+    node._next->_previous = node._previous;
+    node._next = node._previous = nullptr;
+}
+
+void timing_wheel::splice(timer_list_node& from, timer_list_node& to) noexcept
+{
+    if(from._next == &from)
+        return;
+
+    from._next->_previous = to._previous;
+    to._previous->_next = from._next;
+    from._previous->_next = &to;
+    to._previous = from._previous;
+    from._next = from._previous = &from;
+}
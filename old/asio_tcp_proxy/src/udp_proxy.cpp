@@ -0,0 +1,342 @@
+#include <udp_proxy.hpp>
+
+#include <algorithm>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include <logging.hpp>
+#include <settable_socket_option.hpp>
+
+using boost::asio::ip::udp;
+using boost::asio::awaitable;
+using boost::asio::co_spawn;
+using boost::asio::detached;
+using boost::asio::use_awaitable;
+
+namespace
+{
+#if defined(__linux__)
+    using reuse_port = settable_socket_option<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+
+    // Batches taken per readiness notification before other sockets of the worker get a turn.
+    constexpr size_t maxBatchesPerWakeup = 8;
+    constexpr size_t offloadSlotSize = 64 * 1024;
+}
+
+udp_proxy::flow::flow(
+    const udp::endpoint& client,
+    udp::socket socket,
+    backend_lease backend,
+    clock::time_point lastActivity,
+    std::function<void()> onIdle
+)
+    : client(client)
+    , socket(std::move(socket))
+    , backend(std::move(backend))
+    , lastActivity(lastActivity)
+    , idleTimer(std::move(onIdle))
+{
+}
+
+size_t udp_proxy::endpoint_hash::operator()(const udp::endpoint& endpoint) const noexcept
+{
+    const auto address = endpoint.address();
+    uint64_t hash = 14695981039346656037ull;
+    const auto mix = [&](uint8_t byte){
+        hash ^= byte;
+        hash *= 1099511628211ull;
+    };
+
+    if(address.is_v4())
+    {
+        for(const auto byte : address.to_v4().to_bytes())
+            mix(byte);
+    }
+    else
+    {
+        for(const auto byte : address.to_v6().to_bytes())
+            mix(byte);
+    }
+    mix(static_cast<uint8_t>(endpoint.port() >> 8));
+    mix(static_cast<uint8_t>(endpoint.port()));
+
+    return static_cast<size_t>(hash);
+}
+
+udp_proxy::udp_proxy(
+    boost::asio::io_context& context,
+    timing_wheel& timers,
+    backend_set& backends,
+    resolver_cache& resolverCache,
+    udp_metrics& metrics,
+    const udp::endpoint& listen,
+    const udp_proxy_options& options
+)
+    : _context(context)
+    , _timers(timers)
+    , _backends(backends)
+    , _resolverCache(resolverCache)
+    , _metrics(metrics)
+    , _options(options)
+    , _socket(context)
+    , _batch(options.batchSize, options.genericOffload ? offloadSlotSize : options.maxDatagramSize, options.genericOffload)
+{
+    _socket.open(listen.protocol());
+    _socket.set_option(udp::socket::reuse_address(true));
+#if defined(__linux__)
+    _socket.set_option(reuse_port(1));
+#endif
+    configureSocket(_socket);
+    _socket.bind(listen);
+}
+
+void udp_proxy::start()
+{
+    co_spawn(_context, receiveFromClients(), detached);
+}
+
+void udp_proxy::configureSocket(udp::socket& socket)
+{
+    boost::system::error_code error;
+    socket.set_option(udp::socket::receive_buffer_size(_options.socketBufferSize), error);
+    socket.set_option(udp::socket::send_buffer_size(_options.socketBufferSize), error);
+    socket.non_blocking(true);
+
+    if(_options.genericOffload && !enable_generic_receive_offload(socket))
+        log_message(log_level::warning, "UDP generic receive offload is not supported by the kernel");
+}
+
+//----------------------------------------------------------------------
+
+awaitable<void> udp_proxy::receiveFromClients()
+{
+    std::vector<std::pair<flow*, size_t>> routed;
+    std::vector<size_t> indices;
+    routed.reserve(_batch.capacity());
+    indices.reserve(_batch.capacity());
+
+    auto& metrics = _metrics.clientToServer;
+    boost::system::error_code error;
+
+    while(_socket.is_open())
+    {
+        co_await _socket.async_wait(udp::socket::wait_read, boost::asio::redirect_error(use_awaitable, error));
+        if(error == boost::asio::error::operation_aborted)
+            break;
+
+        for(size_t batch = 0; batch < maxBatchesPerWakeup; ++batch)
+        {
+            const auto count = _batch.receive(_socket, true, error);
+            if(error)
+            {
+                log_message(log_level::warning, "UDP receive failed: {}", error.message());
+                error.clear();
+            }
+            if(count == 0)
+                break;
+
+            metrics.receiveCalls.add();
+            const auto now = clock::now();
+
+            routed.clear();
+            for(size_t index = 0; index < count; ++index)
+            {
+                const auto datagram = _batch.data(index);
+                metrics.datagrams.add();
+                metrics.bytes.add(datagram.size());
+
+                auto* flow = _batch.truncated(index)
+                    ? nullptr
+                    : findOrOpenFlow(_batch.sender(index), now);
+                if(flow == nullptr)
+                {
+                    metrics.dropped.add();
+                    continue;
+                }
+
+                flow->lastActivity = now;
+                if(flow->connected)
+                {
+                    routed.emplace_back(flow, index);
+                }
+                else if(flow->pending.size() < _options.maxPendingDatagrams)
+                {
+                    flow->pending.emplace_back(datagram.begin(), datagram.end());
+                }
+                else
+                {
+                    metrics.dropped.add();
+                }
+            }
+
+            // One batch send per flow, datagrams of a flow keep their order.
+            std::stable_sort(routed.begin(), routed.end(), [](const auto& left, const auto& right){ return left.first < right.first; });
+            for(auto group = routed.begin(); group != routed.end();)
+            {
+                auto* flow = group->first;
+                indices.clear();
+                for(; group != routed.end() && group->first == flow; ++group)
+                    indices.push_back(group->second);
+
+                const auto sent = _batch.send(flow->socket, indices, nullptr, error);
+                metrics.sendCalls.add();
+                metrics.dropped.add(indices.size() - sent);
+                error.clear();
+            }
+
+            if(count < _batch.capacity())
+                break;
+        }
+    }
+}
+
+awaitable<void> udp_proxy::receiveFromBackend(std::shared_ptr<flow> flow)
+{
+    std::vector<size_t> indices;
+    indices.reserve(_batch.capacity());
+
+    auto& metrics = _metrics.serverToClient;
+    boost::system::error_code error;
+
+    while(!flow->closed)
+    {
+        co_await flow->socket.async_wait(udp::socket::wait_read, boost::asio::redirect_error(use_awaitable, error));
+        if(error || flow->closed)
+            break;
+
+        for(size_t batch = 0; batch < maxBatchesPerWakeup; ++batch)
+        {
+            // Refused datagrams from ICMP port unreachable surface here and are not fatal.
+            const auto count = _batch.receive(flow->socket, false, error);
+            error.clear();
+            if(count == 0)
+                break;
+
+            metrics.receiveCalls.add();
+            flow->lastActivity = clock::now();
+
+            indices.clear();
+            for(size_t index = 0; index < count; ++index)
+            {
+                const auto datagram = _batch.data(index);
+                metrics.datagrams.add();
+                metrics.bytes.add(datagram.size());
+
+                if(_batch.truncated(index))
+                    metrics.dropped.add();
+                else
+                    indices.push_back(index);
+            }
+
+            const auto sent = _batch.send(_socket, indices, &flow->client, error);
+            metrics.sendCalls.add();
+            metrics.dropped.add(indices.size() - sent);
+            error.clear();
+
+            if(count < _batch.capacity())
+                break;
+        }
+    }
+}
+
+awaitable<void> udp_proxy::connectFlow(std::shared_ptr<flow> flow)
+{
+    const auto& backend = *flow->backend.get();
+    bool failed = false;
+
+    try
+    {
+        const auto endpoints = co_await _resolverCache.resolve(backend.address(), backend.port());
+        const udp::endpoint endpoint(endpoints.begin()->endpoint().address(), endpoints.begin()->endpoint().port());
+
+        if(flow->closed)
+            co_return;
+
+        flow->socket.open(endpoint.protocol());
+        configureSocket(flow->socket);
+        flow->socket.connect(endpoint);
+    }
+    catch (const std::exception& exception)
+    {
+        log_message(log_level::error, "Failed to open UDP flow to {}:{}, {}", backend.address(), backend.port(), exception.what());
+        failed = true;
+    }
+
+    if(failed)
+    {
+        closeFlow(*flow);
+        co_return;
+    }
+
+    flow->connected = true;
+    for(const auto& datagram : flow->pending)
+    {
+        boost::system::error_code error;
+        flow->socket.send(boost::asio::buffer(datagram), 0, error);
+        if(error)
+            _metrics.clientToServer.dropped.add();
+    }
+    flow->pending = {};
+
+    co_await receiveFromBackend(std::move(flow));
+}
+
+udp_proxy::flow* udp_proxy::findOrOpenFlow(const udp::endpoint& client, clock::time_point now)
+{
+    if(const auto iterator = _flows.find(client); iterator != _flows.end())
+        return iterator->second.get();
+
+    if(_flows.size() >= _options.maxFlows)
+    {
+        _metrics.flowsRejected.add();
+        return nullptr;
+    }
+
+    auto newFlow = std::make_shared<flow>(client, udp::socket(_context), _backends.select(client.address()), now, [this, client]{ expireFlow(client); });
+    auto* result = newFlow.get();
+    _flows.emplace(client, newFlow);
+    _timers.schedule(newFlow->idleTimer, now + _options.flowIdleTimeout);
+    _metrics.flowsOpened.add();
+
+    log_message(log_level::info, "UDP flow from {}:{} to {}:{}", client.address().to_string(), client.port(), newFlow->backend->address(), newFlow->backend->port());
+    co_spawn(_context, connectFlow(std::move(newFlow)), detached);
+
+    return result;
+}
+
+// Activity only updates lastActivity, the timer is pushed back when it expires too early.
+void udp_proxy::expireFlow(const udp::endpoint& client)
+{
+    const auto iterator = _flows.find(client);
+    if(iterator == _flows.end())
+        return;
+
+    const auto flow = iterator->second;
+    if(const auto deadline = flow->lastActivity + _options.flowIdleTimeout; clock::now() < deadline)
+    {
+        _timers.schedule(flow->idleTimer, deadline);
+        return;
+    }
+
+    log_message(log_level::debug, "UDP flow from {}:{} expired", flow->client.address().to_string(), flow->client.port());
+    closeFlow(*flow);
+}
+
+void udp_proxy::closeFlow(flow& flow) noexcept
+{
+    if(flow.closed)
+        return;
+
+    flow.closed = true;
+    flow.idleTimer.cancel();
+    _metrics.flowsClosed.add();
+
+    if(const auto iterator = _flows.find(flow.client); iterator != _flows.end() && iterator->second.get() == &flow)
+        _flows.erase(iterator);
+
+    boost::system::error_code error;
+    flow.socket.close(error);
+}
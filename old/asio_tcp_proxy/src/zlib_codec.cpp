@@ -0,0 +1,114 @@
+#include <zlib_codec.hpp>
+
+#include <new>
+#include <stdexcept>
+
+#if defined(ASIO_TCP_PROXY_LIBDEFLATE)
+#include <libdeflate.h>
+#endif
+
+#if defined(ASIO_TCP_PROXY_LIBDEFLATE)
+
+zlib_codec::zlib_codec()
+    : _decompressor(libdeflate_alloc_decompressor())
+{
+    if(_decompressor == nullptr)
+        throw std::bad_alloc();
+}
+
+zlib_codec::~zlib_codec()
+{
+    libdeflate_free_compressor(_compressor);
+    libdeflate_free_decompressor(_decompressor);
+}
+
+size_t zlib_codec::compress(std::span<const char> data, std::vector<char>& out, int level)
+{
+    if(_compressor == nullptr || level != _level)
+    {
+        libdeflate_free_compressor(_compressor);
+        _compressor = libdeflate_alloc_compressor(level);
+        if(_compressor == nullptr)
+            throw std::bad_alloc();
+        _level = level;
+    }
+
+    out.resize(libdeflate_zlib_compress_bound(_compressor, data.size()));
+    const auto size = libdeflate_zlib_compress(_compressor, data.data(), data.size(), out.data(), out.size());
+    if(size == 0)
+        throw std::runtime_error("Compressed data exceeds its bound");
+
+    return size;
+}
+
+bool zlib_codec::decompress(std::span<const char> data, std::span<char> out)
+{
+    return libdeflate_zlib_decompress(_decompressor, data.data(), data.size(), out.data(), out.size(), nullptr) == LIBDEFLATE_SUCCESS;
+}
+
+#else
+
+zlib_codec::zlib_codec()
+    : _inflateStream(std::make_unique<z_stream>())
+{
+    if(inflateInit(_inflateStream.get()) != Z_OK)
+        throw std::bad_alloc();
+}
+
+zlib_codec::~zlib_codec()
+{
+    if(_deflateStream)
+        deflateEnd(_deflateStream.get());
+    inflateEnd(_inflateStream.get());
+}
+
+size_t zlib_codec::compress(std::span<const char> data, std::vector<char>& out, int level)
+{
+    if(!_deflateStream || level != _level)
+    {
+        if(_deflateStream)
+            deflateEnd(_deflateStream.get());
+        _deflateStream = std::make_unique<z_stream>();
+        if(deflateInit(_deflateStream.get(), level) != Z_OK)
+        {
+            _deflateStream.reset();
+            throw std::bad_alloc();
+        }
+        _level = level;
+    }
+
+    auto& stream = *_deflateStream;
+    deflateReset(&stream);
+
+    out.resize(deflateBound(&stream, static_cast<uLong>(data.size())));
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(out.data());
+    stream.avail_out = static_cast<uInt>(out.size());
+
+    if(deflate(&stream, Z_FINISH) != Z_STREAM_END)
+        throw std::runtime_error("Compressed data exceeds its bound");
+
+    return static_cast<size_t>(stream.total_out);
+}
+
+bool zlib_codec::decompress(std::span<const char> data, std::span<char> out)
+{
+    auto& stream = *_inflateStream;
+    inflateReset(&stream);
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(out.data());
+    stream.avail_out = static_cast<uInt>(out.size());
+
+    return inflate(&stream, Z_FINISH) == Z_STREAM_END && stream.total_out == out.size();
+}
+
+#endif
+
+zlib_codec& zlib_codec::local()
+{
+    thread_local zlib_codec codec;
+    return codec;
+}
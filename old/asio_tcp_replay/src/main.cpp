@@ -0,0 +1,458 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <map>
+#include <memory>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/connect.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/write.hpp>
+
+#include <capture_file.hpp>
+#include <histogram.hpp>
+
+using boost::asio::ip::tcp;
+using boost::asio::awaitable;
+using boost::asio::co_spawn;
+using boost::asio::detached;
+using boost::asio::redirect_error;
+using boost::asio::use_awaitable;
+using clock_type = std::chrono::steady_clock;
+
+struct replay_options
+{
+    std::vector<std::string> captureFiles;
+    std::string host = "localhost";
+    std::string port = "25565";
+    // Recorded time is divided by the speed, 2 replays twice as fast.
+    double speed = 1.0;
+    // How long a session waits for outstanding responses after it finished sending.
+    std::chrono::milliseconds grace{2000};
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+};
+
+struct client_chunk
+{
+    clock_type::duration offset;
+    uint32_t length;
+    std::span<const char> payload;
+};
+
+// Response data the session received in the capture. It is considered answered once as many
+// bytes arrived in total as had been recorded up to its end, and its latency is measured from
+// the send of the last client chunk recorded before it.
+struct expected_response
+{
+    uint64_t endOffset;
+    // Index into the client chunks, -1 when it preceded all of them and counts from connect.
+    ptrdiff_t trigger;
+    clock_type::duration recordedLatency;
+};
+
+struct recorded_session
+{
+    uint64_t id;
+    int64_t openedAt{0};
+    int64_t closedAt{0};
+    std::vector<client_chunk> clientChunks;
+    std::vector<expected_response> responses;
+};
+
+// Written by the thread of a single io_context, merged once the run is over.
+struct thread_statistics
+{
+    latency_histogram connectLatency;
+    latency_histogram responseLatency;
+    latency_histogram recordedLatency;
+    latency_histogram sendLag;
+    local_counter sessions;
+    local_counter connectFailures;
+    local_counter bytesSent;
+    local_counter bytesReceived;
+    local_counter missingResponses;
+    local_counter errors;
+};
+
+//----------------------------------------------------------------------
+
+namespace
+{
+    struct session_state
+    {
+        tcp::socket socket;
+        boost::asio::steady_timer graceTimer;
+        clock_type::time_point connectedAt;
+        std::vector<clock_type::time_point> sentAt;
+    };
+
+    // Files may be given in any order, a shell glob puts capture-0-10.bin before
+    // capture-0-2.bin. Records are put back in order per session before they are interpreted.
+    std::vector<recorded_session> load_sessions(std::span<capture_reader> readers)
+    {
+        std::vector<capture_reader::record> records;
+        for(auto& reader : readers)
+        {
+            capture_reader::record record;
+            while(reader.next(record))
+                records.push_back(record);
+        }
+        std::ranges::stable_sort(records, {}, [](const capture_reader::record& record){
+            return std::pair(record.header.session, record.header.timestamp);
+        });
+
+        std::map<uint64_t, recorded_session> sessions;
+        std::map<uint64_t, std::pair<int64_t, uint64_t>> lastClientChunk;
+        std::map<uint64_t, uint64_t> receivedBytes;
+
+        for(const auto& record : records)
+        {
+            const auto& header = record.header;
+            auto& session = sessions.try_emplace(header.session, recorded_session{
+                .id = header.session, .openedAt = 0, .closedAt = 0, .clientChunks = {}, .responses = {}
+            }).first->second;
+            // Sessions whose open record went to an earlier, missing file start at their first record.
+            if(session.openedAt == 0 || header.type == capture_record_type::session_open)
+                session.openedAt = header.timestamp;
+            session.closedAt = std::max(session.closedAt, header.timestamp);
+
+            const auto offset = clock_type::duration(std::chrono::nanoseconds(header.timestamp - session.openedAt));
+            if(header.type == capture_record_type::client_to_server)
+            {
+                session.clientChunks.push_back({offset, header.length, record.payload});
+                lastClientChunk[header.session] = {header.timestamp, session.clientChunks.size() - 1};
+            }
+            else if(header.type == capture_record_type::server_to_client)
+            {
+                auto& received = receivedBytes[header.session];
+                received += header.length;
+
+                const auto trigger = lastClientChunk.find(header.session);
+                const auto triggeredAt = trigger != lastClientChunk.end() ? trigger->second.first : session.openedAt;
+                session.responses.push_back({
+                    received,
+                    trigger != lastClientChunk.end() ? static_cast<ptrdiff_t>(trigger->second.second) : -1,
+                    std::chrono::nanoseconds(header.timestamp - triggeredAt)
+                });
+            }
+        }
+
+        std::vector<recorded_session> result;
+        result.reserve(sessions.size());
+        for(auto& [id, session] : sessions)
+            result.push_back(std::move(session));
+        std::ranges::sort(result, {}, &recorded_session::openedAt);
+        return result;
+    }
+
+    awaitable<void> wait_until(boost::asio::steady_timer& timer, clock_type::time_point time)
+    {
+        boost::system::error_code error;
+        timer.expires_at(time);
+        co_await timer.async_wait(redirect_error(use_awaitable, error));
+    }
+
+    awaitable<void> receive_responses(std::shared_ptr<session_state> state, const recorded_session& session, thread_statistics& statistics)
+    {
+        std::vector<char> buffer(64 * 1024);
+        uint64_t received = 0;
+        size_t nextResponse = 0;
+        boost::system::error_code error;
+
+        while(true)
+        {
+            const auto bytesRead = co_await state->socket.async_read_some(boost::asio::buffer(buffer), redirect_error(use_awaitable, error));
+            if(error)
+                break;
+
+            const auto now = clock_type::now();
+            received += bytesRead;
+            statistics.bytesReceived.add(bytesRead);
+
+            for(; nextResponse < session.responses.size() && session.responses[nextResponse].endOffset <= received; ++nextResponse)
+            {
+                const auto& response = session.responses[nextResponse];
+                const auto sentAt = response.trigger < 0 ? state->connectedAt : state->sentAt[static_cast<size_t>(response.trigger)];
+
+                // Responses that overtake their request in the replay have nothing to be measured against.
+                if(sentAt == clock_type::time_point{})
+                    continue;
+
+                statistics.responseLatency.record(now - sentAt);
+                statistics.recordedLatency.record(response.recordedLatency);
+            }
+        }
+
+        statistics.missingResponses.add(session.responses.size() - nextResponse);
+        state->graceTimer.cancel();
+    }
+
+    awaitable<void> replay_session(
+        tcp::resolver::results_type endpoints,
+        const recorded_session& session,
+        const replay_options& options,
+        thread_statistics& statistics,
+        clock_type::time_point startAt
+    )
+    {
+        auto executor = co_await boost::asio::this_coro::executor;
+        auto state = std::make_shared<session_state>(tcp::socket(executor), boost::asio::steady_timer(executor));
+        state->sentAt.resize(session.clientChunks.size());
+        boost::asio::steady_timer timer(executor);
+        boost::system::error_code error;
+
+        const auto scaled = [&](clock_type::duration offset){
+            return std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double, clock_type::period>(offset) / options.speed);
+        };
+
+        co_await wait_until(timer, startAt);
+
+        const auto connectStartedAt = clock_type::now();
+        co_await boost::asio::async_connect(state->socket, endpoints, redirect_error(use_awaitable, error));
+        if(error)
+        {
+            statistics.connectFailures.add();
+            co_return;
+        }
+
+        state->connectedAt = clock_type::now();
+        statistics.connectLatency.record(state->connectedAt - connectStartedAt);
+        statistics.sessions.add();
+        state->socket.set_option(tcp::no_delay(true), error);
+
+        co_spawn(executor, receive_responses(state, session, statistics), detached);
+
+        std::vector<char> zeros;
+        for(size_t chunkIndex = 0; chunkIndex < session.clientChunks.size(); ++chunkIndex)
+        {
+            const auto& chunk = session.clientChunks[chunkIndex];
+            const auto scheduledAt = startAt + scaled(chunk.offset);
+            if(scheduledAt > clock_type::now())
+                co_await wait_until(timer, scheduledAt);
+
+            // Captures without payloads replay zeros of the recorded length.
+            auto payload = chunk.payload;
+            if(payload.size() != chunk.length)
+            {
+                zeros.resize(std::max<size_t>(zeros.size(), chunk.length));
+                payload = {zeros.data(), chunk.length};
+            }
+
+            state->sentAt[chunkIndex] = clock_type::now();
+            statistics.sendLag.record(state->sentAt[chunkIndex] - scheduledAt);
+
+            co_await boost::asio::async_write(state->socket, boost::asio::buffer(payload.data(), payload.size()), redirect_error(use_awaitable, error));
+            if(error)
+            {
+                statistics.errors.add();
+                break;
+            }
+            statistics.bytesSent.add(payload.size());
+        }
+
+        if(!error)
+        {
+            const auto closeAt = startAt + scaled(std::chrono::nanoseconds(session.closedAt - session.openedAt));
+            if(closeAt > clock_type::now())
+                co_await wait_until(timer, closeAt);
+            state->socket.shutdown(tcp::socket::shutdown_send, error);
+        }
+
+        // The receiver cancels the wait once the backend closed its side.
+        co_await wait_until(state->graceTimer, clock_type::now() + options.grace);
+        state->socket.close(error);
+    }
+
+    void print_latency(std::string_view name, const histogram_snapshot& histogram)
+    {
+        const auto toMicroseconds = [](uint64_t nanoseconds){ return static_cast<double>(nanoseconds) / 1000.0; };
+        std::print(
+            "  {:<12} p50 {:>10.1f} us  p90 {:>10.1f} us  p99 {:>10.1f} us  p99.9 {:>10.1f} us  max {:>10.1f} us  (n={})\n",
+            name,
+            toMicroseconds(histogram.percentile(50.0)),
+            toMicroseconds(histogram.percentile(90.0)),
+            toMicroseconds(histogram.percentile(99.0)),
+            toMicroseconds(histogram.percentile(99.9)),
+            toMicroseconds(histogram.max()),
+            histogram.count()
+        );
+    }
+}
+
+//----------------------------------------------------------------------
+
+void run_replay(std::span<const recorded_session> sessions, const replay_options& options)
+{
+    std::vector<std::unique_ptr<boost::asio::io_context>> contexts;
+    std::vector<std::unique_ptr<thread_statistics>> statistics;
+    for(size_t threadIndex = 0; threadIndex < options.threads; ++threadIndex)
+    {
+        contexts.push_back(std::make_unique<boost::asio::io_context>(1));
+        statistics.push_back(std::make_unique<thread_statistics>());
+    }
+
+    tcp::resolver resolver(*contexts.front());
+    const auto endpoints = resolver.resolve(options.host, options.port);
+
+    // Sessions start at their recorded offsets from the first one, which keeps the recorded concurrency.
+    const auto origin = sessions.front().openedAt;
+    const auto startedAt = clock_type::now() + std::chrono::milliseconds(100);
+    for(size_t sessionIndex = 0; sessionIndex < sessions.size(); ++sessionIndex)
+    {
+        const auto& session = sessions[sessionIndex];
+        const auto offset = std::chrono::duration<double, std::nano>(static_cast<double>(session.openedAt - origin) / options.speed);
+        const auto threadIndex = sessionIndex % options.threads;
+        co_spawn(
+            *contexts[threadIndex],
+            replay_session(endpoints, session, options, *statistics[threadIndex], startedAt + std::chrono::duration_cast<clock_type::duration>(offset)),
+            detached
+        );
+    }
+
+    std::vector<std::jthread> threads;
+    for(size_t threadIndex = 1; threadIndex < contexts.size(); ++threadIndex)
+        threads.emplace_back([&context = *contexts[threadIndex]]{ context.run(); });
+    contexts.front()->run();
+    threads.clear();
+
+    const auto elapsed = std::chrono::duration<double>(clock_type::now() - startedAt).count();
+
+    histogram_snapshot connectLatency;
+    histogram_snapshot responseLatency;
+    histogram_snapshot recordedLatency;
+    histogram_snapshot sendLag;
+    uint64_t replayedSessions = 0;
+    uint64_t connectFailures = 0;
+    uint64_t bytesSent = 0;
+    uint64_t bytesReceived = 0;
+    uint64_t missingResponses = 0;
+    uint64_t errors = 0;
+    for(const auto& threadStatistics : statistics)
+    {
+        connectLatency.merge(threadStatistics->connectLatency);
+        responseLatency.merge(threadStatistics->responseLatency);
+        recordedLatency.merge(threadStatistics->recordedLatency);
+        sendLag.merge(threadStatistics->sendLag);
+        replayedSessions += threadStatistics->sessions.load();
+        connectFailures += threadStatistics->connectFailures.load();
+        bytesSent += threadStatistics->bytesSent.load();
+        bytesReceived += threadStatistics->bytesReceived.load();
+        missingResponses += threadStatistics->missingResponses.load();
+        errors += threadStatistics->errors.load();
+    }
+
+    std::print("Replay of {} sessions against {}:{} at {}x speed, {:.1f} s\n", sessions.size(), options.host, options.port, options.speed, elapsed);
+    std::print("  sessions     {} replayed, {} failed to connect, {} errors\n", replayedSessions, connectFailures, errors);
+    std::print("  traffic      sent {} bytes, received {} bytes, {} responses missing\n", bytesSent, bytesReceived, missingResponses);
+    print_latency("connect", connectLatency);
+    print_latency("response", responseLatency);
+    print_latency("recorded", recordedLatency);
+    print_latency("send lag", sendLag);
+}
+
+//----------------------------------------------------------------------
+
+bool parse_options(int argc, char* argv[], replay_options& options)
+{
+    for(int argumentIndex = 1; argumentIndex < argc; ++argumentIndex)
+    {
+        const std::string_view argument = argv[argumentIndex];
+        const std::string_view value = argumentIndex + 1 < argc ? argv[argumentIndex + 1] : "";
+
+        const auto parseNumber = [&](auto& number){
+            ++argumentIndex;
+            return std::from_chars(value.data(), value.data() + value.size(), number).ec == std::errc{};
+        };
+
+        if(argument == "--target")
+        {
+            ++argumentIndex;
+            const auto portSeparator = value.rfind(':');
+            if(portSeparator == std::string_view::npos)
+                return false;
+
+            options.host = value.substr(0, portSeparator);
+            options.port = value.substr(portSeparator + 1);
+        }
+        else if(argument == "--speed")
+        {
+            if(!parseNumber(options.speed) || options.speed <= 0.0)
+                return false;
+        }
+        else if(argument == "--grace")
+        {
+            size_t milliseconds;
+            if(!parseNumber(milliseconds))
+                return false;
+            options.grace = std::chrono::milliseconds(milliseconds);
+        }
+        else if(argument == "--threads")
+        {
+            if(!parseNumber(options.threads) || options.threads == 0)
+                return false;
+        }
+        else if(argument.starts_with("--"))
+        {
+            return false;
+        }
+        else
+        {
+            options.captureFiles.emplace_back(argument);
+        }
+    }
+
+    return !options.captureFiles.empty();
+}
+
+int main(int argc, char* argv[])
+{
+    replay_options options;
+    if(!parse_options(argc, argv, options))
+    {
+        std::print(
+            "Usage: {} [--target host:port] [--speed factor] [--grace ms] [--threads N] capture-file...\n"
+            "Re-drives the sessions recorded by the proxy's capture mode against the target, by\n"
+            "default localhost:25565, keeping their recorded start times and chunk timing.\n",
+            argv[0]
+        );
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        std::vector<capture_reader> readers;
+        readers.reserve(options.captureFiles.size());
+        for(const auto& path : options.captureFiles)
+            readers.emplace_back(path);
+
+        const auto sessions = load_sessions(readers);
+        if(sessions.empty())
+        {
+            std::print("No sessions in the capture\n");
+            return EXIT_FAILURE;
+        }
+
+        run_replay(sessions, options);
+    }
+    catch (const std::exception& exception)
+    {
+        std::print("Replay failed: {}\n", exception.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
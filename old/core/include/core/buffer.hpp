@@ -0,0 +1,265 @@
+#pragma once
+
+#include <core/common.hpp>
+#include <core/data_type.hpp>
+
+#include <cstring>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace CORE_NAMESPACE
+{
+namespace internal
+{
+    template<typename T>
+    void check_element_type(data_type type)
+    {
+        if(data_type_of<std::remove_cv_t<T>> != type)
+            throw std::invalid_argument(std::string("buffer holds ") + std::string(data_type_name(type)) + ", not " + std::string(data_type_name(data_type_of<std::remove_cv_t<T>>)));
+    }
+
+    inline void check_range(size_t offset, size_t count, size_t size)
+    {
+        if(offset > size || count > size - offset)
+            throw std::out_of_range("buffer range exceeds its size");
+    }
+}
+
+// Non-owning range of elements of a runtime data_type.
+class const_buffer_view
+{
+private:
+    const std::byte* _data{};
+    size_t _size{};
+    data_type _type{uint8};
+public:
+    constexpr const_buffer_view() noexcept = default;
+    constexpr const_buffer_view(data_type type, const void* data, size_t size) noexcept
+        : _data(static_cast<const std::byte*>(data))
+        , _size(size)
+        , _type(type)
+    {}
+    template<typename T>
+    constexpr const_buffer_view(std::span<T> elements) noexcept
+        : const_buffer_view(data_type_of<std::remove_cv_t<T>>, elements.data(), elements.size())
+    {}
+public:
+    [[nodiscard]] constexpr data_type type() const noexcept
+    {
+        return _type;
+    }
+    [[nodiscard]] constexpr size_t size() const noexcept
+    {
+        return _size;
+    }
+    [[nodiscard]] constexpr size_t byteSize() const
+    {
+        return _size * data_type_size(_type);
+    }
+    [[nodiscard]] constexpr bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+    [[nodiscard]] constexpr const std::byte* data() const noexcept
+    {
+        return _data;
+    }
+    // Throws std::invalid_argument unless T is the view's element type.
+    template<typename T>
+    [[nodiscard]] std::span<const T> elements() const
+    {
+        internal::check_element_type<T>(_type);
+        return {reinterpret_cast<const T*>(_data), _size};
+    }
+    [[nodiscard]] const_buffer_view subview(size_t offset, size_t count) const
+    {
+        internal::check_range(offset, count, _size);
+        return {_type, _data + offset * data_type_size(_type), count};
+    }
+};
+
+class buffer_view
+{
+private:
+    std::byte* _data{};
+    size_t _size{};
+    data_type _type{uint8};
+public:
+    constexpr buffer_view() noexcept = default;
+    constexpr buffer_view(data_type type, void* data, size_t size) noexcept
+        : _data(static_cast<std::byte*>(data))
+        , _size(size)
+        , _type(type)
+    {}
+    template<typename T>
+    requires (!std::is_const_v<T>)
+    constexpr buffer_view(std::span<T> elements) noexcept
+        : buffer_view(data_type_of<T>, elements.data(), elements.size())
+    {}
+public:
+    [[nodiscard]] constexpr data_type type() const noexcept
+    {
+        return _type;
+    }
+    [[nodiscard]] constexpr size_t size() const noexcept
+    {
+        return _size;
+    }
+    [[nodiscard]] constexpr size_t byteSize() const
+    {
+        return _size * data_type_size(_type);
+    }
+    [[nodiscard]] constexpr bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+    [[nodiscard]] constexpr std::byte* data() const noexcept
+    {
+        return _data;
+    }
+    template<typename T>
+    [[nodiscard]] std::span<T> elements() const
+    {
+        internal::check_element_type<T>(_type);
+        return {reinterpret_cast<T*>(_data), _size};
+    }
+    [[nodiscard]] buffer_view subview(size_t offset, size_t count) const
+    {
+        internal::check_range(offset, count, _size);
+        return {_type, _data + offset * data_type_size(_type), count};
+    }
+public:
+    constexpr operator const_buffer_view() const noexcept
+    {
+        return {_type, _data, _size};
+    }
+};
+
+// Owning, zero-initialised column of elements of a runtime data_type. The storage is aligned to
+// a cache line, which is also the widest vector register the kernels use.
+class buffer
+{
+public:
+    constexpr static size_t alignment = 64;
+private:
+    struct aligned_delete
+    {
+        void operator()(std::byte* data) const noexcept
+        {
+            ::operator delete[](data, std::align_val_t{alignment});
+        }
+    };
+private:
+    std::unique_ptr<std::byte[], aligned_delete> _data;
+    size_t _size{};
+    data_type _type{uint8};
+public:
+    buffer() noexcept = default;
+    buffer(data_type type, size_t size)
+        : _data(allocate(size * data_type_size(type)))
+        , _size(size)
+        , _type(type)
+    {
+        if(_data != nullptr)
+            std::memset(_data.get(), 0, byteSize());
+    }
+    buffer(const buffer& other)
+        : _data(allocate(other.byteSize()))
+        , _size(other._size)
+        , _type(other._type)
+    {
+        if(_data != nullptr)
+            std::memcpy(_data.get(), other._data.get(), byteSize());
+    }
+    buffer(buffer&& other) noexcept
+        : _data(std::move(other._data))
+        , _size(std::exchange(other._size, 0))
+        , _type(other._type)
+    {}
+    buffer& operator=(const buffer& other)
+    {
+        if(&other != this)
+            *this = buffer(other);
+        return *this;
+    }
+    buffer& operator=(buffer&& other) noexcept
+    {
+        _data = std::move(other._data);
+        _size = std::exchange(other._size, 0);
+        _type = other._type;
+        return *this;
+    }
+public:
+    [[nodiscard]] data_type type() const noexcept
+    {
+        return _type;
+    }
+    [[nodiscard]] size_t size() const noexcept
+    {
+        return _size;
+    }
+    [[nodiscard]] size_t byteSize() const
+    {
+        return _size * data_type_size(_type);
+    }
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+    [[nodiscard]] std::byte* data() noexcept
+    {
+        return _data.get();
+    }
+    [[nodiscard]] const std::byte* data() const noexcept
+    {
+        return _data.get();
+    }
+public:
+    [[nodiscard]] buffer_view view() noexcept
+    {
+        return {_type, _data.get(), _size};
+    }
+    [[nodiscard]] const_buffer_view view() const noexcept
+    {
+        return {_type, _data.get(), _size};
+    }
+    [[nodiscard]] buffer_view view(size_t offset, size_t count)
+    {
+        return view().subview(offset, count);
+    }
+    [[nodiscard]] const_buffer_view view(size_t offset, size_t count) const
+    {
+        return view().subview(offset, count);
+    }
+    template<typename T>
+    [[nodiscard]] std::span<T> elements()
+    {
+        return view().elements<T>();
+    }
+    template<typename T>
+    [[nodiscard]] std::span<const T> elements() const
+    {
+        return view().elements<T>();
+    }
+public:
+    operator buffer_view() noexcept
+    {
+        return view();
+    }
+    operator const_buffer_view() const noexcept
+    {
+        return view();
+    }
+private:
+    static std::unique_ptr<std::byte[], aligned_delete> allocate(size_t byteSize)
+    {
+        if(byteSize == 0)
+            return nullptr;
+        return std::unique_ptr<std::byte[], aligned_delete>(new(std::align_val_t{alignment}) std::byte[byteSize]);
+    }
+};
+}
@@ -0,0 +1,641 @@
+#pragma once
+
+#include <core/common.hpp>
+#include <core/buffer.hpp>
+#include <core/data_type.hpp>
+#include <core/simd.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Kernels over buffers of any data_type. Element conversions follow one rule everywhere:
+// floating point values are truncated toward zero, values outside the destination's range
+// saturate to it, NaN becomes 0 in integers, and float16 rounds to nearest even. Conversions
+// that pass through float32 exactly, which covers the 8- and 16-bit integers, float16,
+// float32 and int32 on either side, run AVX2 or AVX-512 kernels when active_simd_level()
+// allows, as do float32/float64 conversions and the float32/float16 scale and reductions.
+
+namespace CORE_NAMESPACE
+{
+namespace internal
+{
+    template<typename T>
+    constexpr bool is_floating_value = std::is_floating_point_v<T> || std::is_same_v<T, half>;
+
+    template<typename Destination, typename Source>
+    constexpr Destination convert_value(Source value) noexcept
+    {
+        if constexpr(std::is_same_v<Source, Destination>)
+            return value;
+        else if constexpr(std::is_same_v<Source, half>)
+            return convert_value<Destination>(to_float(value));
+        else if constexpr(std::is_same_v<Destination, half>)
+            return to_half(convert_value<float>(value));
+        else if constexpr(std::is_floating_point_v<Destination>)
+            return static_cast<Destination>(value);
+        else if constexpr(std::is_floating_point_v<Source>)
+        {
+            using limits = std::numeric_limits<Destination>;
+            // Both bounds are powers of two and therefore exact in any floating point type.
+            constexpr auto lower = static_cast<Source>(limits::min());
+            constexpr auto upper = static_cast<Source>(limits::max() / 2 + 1) * 2;
+
+            if(value != value)
+                return 0;
+            if(value <= lower)
+                return limits::min();
+            if(value >= upper)
+                return limits::max();
+            return static_cast<Destination>(value);
+        }
+        else
+        {
+            using limits = std::numeric_limits<Destination>;
+            if(std::cmp_less(value, limits::min()))
+                return limits::min();
+            if(std::cmp_greater(value, limits::max()))
+                return limits::max();
+            return static_cast<Destination>(value);
+        }
+    }
+
+    template<typename Source, typename Destination>
+    void convert_scalar(const Source* source, Destination* destination, size_t count) noexcept
+    {
+        for(size_t index = 0; index < count; ++index)
+            destination[index] = convert_value<Destination>(source[index]);
+    }
+
+    // Types whose every value survives a round trip through float32, or that saturate before
+    // the precision float32 lacks would matter.
+    template<typename T>
+    constexpr bool through_float = std::is_same_v<T, uint8_t> || std::is_same_v<T, int8_t>
+        || std::is_same_v<T, uint16_t> || std::is_same_v<T, int16_t> || std::is_same_v<T, int32_t>
+        || std::is_same_v<T, half> || std::is_same_v<T, float>;
+
+    // Sources whose values float32 holds exactly, so min, max and sum can run on float lanes.
+    template<typename T>
+    constexpr bool exact_in_float = through_float<T> && !std::is_same_v<T, int32_t>;
+
+    template<typename Source, typename Destination>
+    constexpr bool vector_convertible = (through_float<Source> && through_float<Destination>)
+        || (std::is_same_v<Source, float> && std::is_same_v<Destination, double>)
+        || (std::is_same_v<Source, double> && std::is_same_v<Destination, float>);
+
+#if defined(CORE_SIMD_X86)
+    namespace avx2
+    {
+        constexpr size_t width = 8;
+
+        CORE_TARGET_AVX2 inline __m256 load(const uint8_t* source) noexcept
+        {
+            return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(source))));
+        }
+        CORE_TARGET_AVX2 inline __m256 load(const int8_t* source) noexcept
+        {
+            return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(source))));
+        }
+        CORE_TARGET_AVX2 inline __m256 load(const uint16_t* source) noexcept
+        {
+            return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source))));
+        }
+        CORE_TARGET_AVX2 inline __m256 load(const int16_t* source) noexcept
+        {
+            return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source))));
+        }
+        CORE_TARGET_AVX2 inline __m256 load(const int32_t* source) noexcept
+        {
+            return _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source)));
+        }
+        CORE_TARGET_AVX2 inline __m256 load(const half* source) noexcept
+        {
+            return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source)));
+        }
+        CORE_TARGET_AVX2 inline __m256 load(const float* source) noexcept
+        {
+            return _mm256_loadu_ps(source);
+        }
+
+        // NaN lanes become +0, the rest are clamped to [lower, upper] before truncation.
+        CORE_TARGET_AVX2 inline __m256i truncate(__m256 values, float lower, float upper) noexcept
+        {
+            values = _mm256_and_ps(values, _mm256_cmp_ps(values, values, _CMP_ORD_Q));
+            values = _mm256_min_ps(_mm256_max_ps(values, _mm256_set1_ps(lower)), _mm256_set1_ps(upper));
+            return _mm256_cvttps_epi32(values);
+        }
+
+        CORE_TARGET_AVX2 inline void store(uint8_t* destination, __m256 values) noexcept
+        {
+            const auto integers = truncate(values, 0.0f, 255.0f);
+            const auto words = _mm_packs_epi32(_mm256_castsi256_si128(integers), _mm256_extracti128_si256(integers, 1));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(destination), _mm_packus_epi16(words, words));
+        }
+        CORE_TARGET_AVX2 inline void store(int8_t* destination, __m256 values) noexcept
+        {
+            const auto integers = truncate(values, -128.0f, 127.0f);
+            const auto words = _mm_packs_epi32(_mm256_castsi256_si128(integers), _mm256_extracti128_si256(integers, 1));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(destination), _mm_packs_epi16(words, words));
+        }
+        CORE_TARGET_AVX2 inline void store(uint16_t* destination, __m256 values) noexcept
+        {
+            const auto integers = truncate(values, 0.0f, 65535.0f);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), _mm_packus_epi32(_mm256_castsi256_si128(integers), _mm256_extracti128_si256(integers, 1)));
+        }
+        CORE_TARGET_AVX2 inline void store(int16_t* destination, __m256 values) noexcept
+        {
+            const auto integers = truncate(values, -32768.0f, 32767.0f);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), _mm_packs_epi32(_mm256_castsi256_si128(integers), _mm256_extracti128_si256(integers, 1)));
+        }
+        CORE_TARGET_AVX2 inline void store(int32_t* destination, __m256 values) noexcept
+        {
+            // cvtt yields INT32_MIN for everything out of range, the large positive lanes are fixed up.
+            const auto ordered = _mm256_cmp_ps(values, values, _CMP_ORD_Q);
+            const auto overflow = _mm256_cmp_ps(values, _mm256_set1_ps(0x1.0p31f), _CMP_GE_OQ);
+            auto integers = _mm256_cvttps_epi32(values);
+            integers = _mm256_blendv_epi8(integers, _mm256_set1_epi32(std::numeric_limits<int32_t>::max()), _mm256_castps_si256(overflow));
+            integers = _mm256_and_si256(integers, _mm256_castps_si256(ordered));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination), integers);
+        }
+        CORE_TARGET_AVX2 inline void store(half* destination, __m256 values) noexcept
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), _mm256_cvtps_ph(values, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+        }
+        CORE_TARGET_AVX2 inline void store(float* destination, __m256 values) noexcept
+        {
+            _mm256_storeu_ps(destination, values);
+        }
+
+        template<typename Source, typename Destination>
+        CORE_TARGET_AVX2 void convert(const Source* source, Destination* destination, size_t count) noexcept
+        {
+            size_t index = 0;
+            if constexpr(std::is_same_v<Source, float> && std::is_same_v<Destination, double>)
+            {
+                for(; index + 4 <= count; index += 4)
+                    _mm256_storeu_pd(destination + index, _mm256_cvtps_pd(_mm_loadu_ps(source + index)));
+            }
+            else if constexpr(std::is_same_v<Source, double> && std::is_same_v<Destination, float>)
+            {
+                for(; index + 4 <= count; index += 4)
+                    _mm_storeu_ps(destination + index, _mm256_cvtpd_ps(_mm256_loadu_pd(source + index)));
+            }
+            else
+            {
+                for(; index + width <= count; index += width)
+                    store(destination + index, load(source + index));
+            }
+            convert_scalar(source + index, destination + index, count - index);
+        }
+
+        template<typename T>
+        CORE_TARGET_AVX2 void scale(T* values, size_t count, float factor) noexcept
+        {
+            const auto factors = _mm256_set1_ps(factor);
+            size_t index = 0;
+            for(; index + width <= count; index += width)
+                store(values + index, _mm256_mul_ps(load(values + index), factors));
+            for(; index < count; ++index)
+                values[index] = convert_value<T>(convert_value<float>(values[index]) * factor);
+        }
+
+        CORE_TARGET_AVX2 inline float horizontal_min(__m256 values) noexcept
+        {
+            auto lanes = _mm_min_ps(_mm256_castps256_ps128(values), _mm256_extractf128_ps(values, 1));
+            lanes = _mm_min_ps(lanes, _mm_movehl_ps(lanes, lanes));
+            lanes = _mm_min_ss(lanes, _mm_movehdup_ps(lanes));
+            return _mm_cvtss_f32(lanes);
+        }
+        CORE_TARGET_AVX2 inline float horizontal_max(__m256 values) noexcept
+        {
+            auto lanes = _mm_max_ps(_mm256_castps256_ps128(values), _mm256_extractf128_ps(values, 1));
+            lanes = _mm_max_ps(lanes, _mm_movehl_ps(lanes, lanes));
+            lanes = _mm_max_ss(lanes, _mm_movehdup_ps(lanes));
+            return _mm_cvtss_f32(lanes);
+        }
+
+        // NaN lanes are skipped: min_ps and max_ps return their second operand when either is NaN.
+        template<typename T>
+        CORE_TARGET_AVX2 std::optional<std::pair<double, double>> bounds(const T* values, size_t count) noexcept
+        {
+            auto lowest = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+            auto highest = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+            auto ordered = _mm256_setzero_ps();
+            size_t index = 0;
+            for(; index + width <= count; index += width)
+            {
+                const auto lanes = load(values + index);
+                lowest = _mm256_min_ps(lanes, lowest);
+                highest = _mm256_max_ps(lanes, highest);
+                ordered = _mm256_or_ps(ordered, _mm256_cmp_ps(lanes, lanes, _CMP_ORD_Q));
+            }
+
+            float minimum = horizontal_min(lowest);
+            float maximum = horizontal_max(highest);
+            bool found = _mm256_movemask_ps(ordered) != 0;
+            for(; index < count; ++index)
+            {
+                const auto value = convert_value<float>(values[index]);
+                if(value != value)
+                    continue;
+                minimum = std::min(minimum, value);
+                maximum = std::max(maximum, value);
+                found = true;
+            }
+
+            if(!found)
+                return std::nullopt;
+            return std::pair<double, double>{minimum, maximum};
+        }
+
+        // Accumulates in double lanes, so long float32 columns keep their precision.
+        template<typename T>
+        CORE_TARGET_AVX2 double sum(const T* values, size_t count) noexcept
+        {
+            auto low = _mm256_setzero_pd();
+            auto high = _mm256_setzero_pd();
+            size_t index = 0;
+            for(; index + width <= count; index += width)
+            {
+                const auto lanes = load(values + index);
+                low = _mm256_add_pd(low, _mm256_cvtps_pd(_mm256_castps256_ps128(lanes)));
+                high = _mm256_add_pd(high, _mm256_cvtps_pd(_mm256_extractf128_ps(lanes, 1)));
+            }
+
+            const auto total = _mm256_add_pd(low, high);
+            auto pairs = _mm_add_pd(_mm256_castpd256_pd128(total), _mm256_extractf128_pd(total, 1));
+            pairs = _mm_add_sd(pairs, _mm_unpackhi_pd(pairs, pairs));
+
+            double result = _mm_cvtsd_f64(pairs);
+            for(; index < count; ++index)
+                result += convert_value<float>(values[index]);
+            return result;
+        }
+    }
+
+    namespace avx512
+    {
+        constexpr size_t width = 16;
+
+        CORE_TARGET_AVX512 inline __m512 load(const uint8_t* source) noexcept
+        {
+            return _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source))));
+        }
+        CORE_TARGET_AVX512 inline __m512 load(const int8_t* source) noexcept
+        {
+            return _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source))));
+        }
+        CORE_TARGET_AVX512 inline __m512 load(const uint16_t* source) noexcept
+        {
+            return _mm512_cvtepi32_ps(_mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source))));
+        }
+        CORE_TARGET_AVX512 inline __m512 load(const int16_t* source) noexcept
+        {
+            return _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source))));
+        }
+        CORE_TARGET_AVX512 inline __m512 load(const int32_t* source) noexcept
+        {
+            return _mm512_cvtepi32_ps(_mm512_loadu_si512(source));
+        }
+        CORE_TARGET_AVX512 inline __m512 load(const half* source) noexcept
+        {
+            return _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source)));
+        }
+        CORE_TARGET_AVX512 inline __m512 load(const float* source) noexcept
+        {
+            return _mm512_loadu_ps(source);
+        }
+
+        CORE_TARGET_AVX512 inline __m512i truncate(__m512 values, float lower, float upper) noexcept
+        {
+            values = _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(values, values, _CMP_ORD_Q), values);
+            values = _mm512_min_ps(_mm512_max_ps(values, _mm512_set1_ps(lower)), _mm512_set1_ps(upper));
+            return _mm512_cvttps_epi32(values);
+        }
+
+        CORE_TARGET_AVX512 inline void store(uint8_t* destination, __m512 values) noexcept
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), _mm512_cvtepi32_epi8(truncate(values, 0.0f, 255.0f)));
+        }
+        CORE_TARGET_AVX512 inline void store(int8_t* destination, __m512 values) noexcept
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), _mm512_cvtepi32_epi8(truncate(values, -128.0f, 127.0f)));
+        }
+        CORE_TARGET_AVX512 inline void store(uint16_t* destination, __m512 values) noexcept
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination), _mm512_cvtepi32_epi16(truncate(values, 0.0f, 65535.0f)));
+        }
+        CORE_TARGET_AVX512 inline void store(int16_t* destination, __m512 values) noexcept
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination), _mm512_cvtepi32_epi16(truncate(values, -32768.0f, 32767.0f)));
+        }
+        CORE_TARGET_AVX512 inline void store(int32_t* destination, __m512 values) noexcept
+        {
+            const auto ordered = _mm512_cmp_ps_mask(values, values, _CMP_ORD_Q);
+            const auto overflow = _mm512_cmp_ps_mask(values, _mm512_set1_ps(0x1.0p31f), _CMP_GE_OQ);
+            auto integers = _mm512_cvttps_epi32(values);
+            integers = _mm512_mask_mov_epi32(integers, overflow, _mm512_set1_epi32(std::numeric_limits<int32_t>::max()));
+            _mm512_storeu_si512(destination, _mm512_maskz_mov_epi32(ordered, integers));
+        }
+        CORE_TARGET_AVX512 inline void store(half* destination, __m512 values) noexcept
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination), _mm512_cvtps_ph(values, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+        }
+        CORE_TARGET_AVX512 inline void store(float* destination, __m512 values) noexcept
+        {
+            _mm512_storeu_ps(destination, values);
+        }
+
+        template<typename Source, typename Destination>
+        CORE_TARGET_AVX512 void convert(const Source* source, Destination* destination, size_t count) noexcept
+        {
+            size_t index = 0;
+            if constexpr(std::is_same_v<Source, float> && std::is_same_v<Destination, double>)
+            {
+                for(; index + 8 <= count; index += 8)
+                    _mm512_storeu_pd(destination + index, _mm512_cvtps_pd(_mm256_loadu_ps(source + index)));
+            }
+            else if constexpr(std::is_same_v<Source, double> && std::is_same_v<Destination, float>)
+            {
+                for(; index + 8 <= count; index += 8)
+                    _mm256_storeu_ps(destination + index, _mm512_cvtpd_ps(_mm512_loadu_pd(source + index)));
+            }
+            else
+            {
+                for(; index + width <= count; index += width)
+                    store(destination + index, load(source + index));
+            }
+            convert_scalar(source + index, destination + index, count - index);
+        }
+
+        template<typename T>
+        CORE_TARGET_AVX512 void scale(T* values, size_t count, float factor) noexcept
+        {
+            const auto factors = _mm512_set1_ps(factor);
+            size_t index = 0;
+            for(; index + width <= count; index += width)
+                store(values + index, _mm512_mul_ps(load(values + index), factors));
+            for(; index < count; ++index)
+                values[index] = convert_value<T>(convert_value<float>(values[index]) * factor);
+        }
+
+        template<typename T>
+        CORE_TARGET_AVX512 std::optional<std::pair<double, double>> bounds(const T* values, size_t count) noexcept
+        {
+            auto lowest = _mm512_set1_ps(std::numeric_limits<float>::infinity());
+            auto highest = _mm512_set1_ps(-std::numeric_limits<float>::infinity());
+            __mmask16 ordered = 0;
+            size_t index = 0;
+            for(; index + width <= count; index += width)
+            {
+                const auto lanes = load(values + index);
+                lowest = _mm512_min_ps(lanes, lowest);
+                highest = _mm512_max_ps(lanes, highest);
+                ordered |= _mm512_cmp_ps_mask(lanes, lanes, _CMP_ORD_Q);
+            }
+
+            float minimum = _mm512_reduce_min_ps(lowest);
+            float maximum = _mm512_reduce_max_ps(highest);
+            bool found = ordered != 0;
+            for(; index < count; ++index)
+            {
+                const auto value = convert_value<float>(values[index]);
+                if(value != value)
+                    continue;
+                minimum = std::min(minimum, value);
+                maximum = std::max(maximum, value);
+                found = true;
+            }
+
+            if(!found)
+                return std::nullopt;
+            return std::pair<double, double>{minimum, maximum};
+        }
+
+        template<typename T>
+        CORE_TARGET_AVX512 double sum(const T* values, size_t count) noexcept
+        {
+            auto low = _mm512_setzero_pd();
+            auto high = _mm512_setzero_pd();
+            size_t index = 0;
+            for(; index + width <= count; index += width)
+            {
+                const auto lanes = load(values + index);
+                low = _mm512_add_pd(low, _mm512_cvtps_pd(_mm512_castps512_ps256(lanes)));
+                high = _mm512_add_pd(high, _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(lanes), 1))));
+            }
+
+            double result = _mm512_reduce_add_pd(_mm512_add_pd(low, high));
+            for(; index < count; ++index)
+                result += convert_value<float>(values[index]);
+            return result;
+        }
+    }
+#endif
+
+    template<typename Source, typename Destination>
+    void convert_elements(const Source* source, Destination* destination, size_t count) noexcept
+    {
+#if defined(CORE_SIMD_X86)
+        if constexpr(vector_convertible<Source, Destination>)
+        {
+            switch(active_simd_level())
+            {
+            case simd_level::avx512:
+                avx512::convert(source, destination, count);
+                return;
+            case simd_level::avx2:
+                avx2::convert(source, destination, count);
+                return;
+            case simd_level::scalar:
+                break;
+            }
+        }
+#endif
+        convert_scalar(source, destination, count);
+    }
+
+    inline void check_same_size(const_buffer_view source, const_buffer_view destination)
+    {
+        if(source.size() != destination.size())
+            throw std::invalid_argument("buffers differ in size");
+    }
+
+    template<typename FunctionType>
+    void visit_elements(const_buffer_view values, FunctionType&& function)
+    {
+        visit_data_type(values.type(), [&]<typename T>(std::type_identity<T>){
+            function(reinterpret_cast<const T*>(values.data()));
+        });
+    }
+
+    template<typename FunctionType>
+    void visit_elements(buffer_view values, FunctionType&& function)
+    {
+        visit_data_type(values.type(), [&]<typename T>(std::type_identity<T>){
+            function(reinterpret_cast<T*>(values.data()));
+        });
+    }
+
+    template<typename T>
+    std::optional<std::pair<double, double>> bounds(const T* values, size_t count) noexcept
+    {
+#if defined(CORE_SIMD_X86)
+        if constexpr(exact_in_float<T>)
+        {
+            switch(active_simd_level())
+            {
+            case simd_level::avx512:
+                return avx512::bounds(values, count);
+            case simd_level::avx2:
+                return avx2::bounds(values, count);
+            case simd_level::scalar:
+                break;
+            }
+        }
+#endif
+        std::optional<std::pair<T, T>> result;
+        for(size_t index = 0; index < count; ++index)
+        {
+            const auto value = values[index];
+            if constexpr(is_floating_value<T>)
+            {
+                if(convert_value<double>(value) != convert_value<double>(value))
+                    continue;
+            }
+
+            if(!result)
+                result.emplace(value, value);
+            else if(convert_value<double>(value) < convert_value<double>(result->first))
+                result->first = value;
+            else if(convert_value<double>(value) > convert_value<double>(result->second))
+                result->second = value;
+        }
+
+        if(!result)
+            return std::nullopt;
+        return std::pair<double, double>{convert_value<double>(result->first), convert_value<double>(result->second)};
+    }
+}
+
+// Converts every element of source into destination's type; the two must not overlap.
+inline void convert(const_buffer_view source, buffer_view destination)
+{
+    internal::check_same_size(source, destination);
+    internal::visit_elements(source, [&]<typename Source>(const Source* sourceElements){
+        internal::visit_elements(destination, [&]<typename Destination>(Destination* destinationElements){
+            if constexpr(std::is_same_v<Source, Destination>)
+            {
+                if(!source.empty())
+                    std::memmove(destinationElements, sourceElements, source.byteSize());
+            }
+            else
+                internal::convert_elements(sourceElements, destinationElements, source.size());
+        });
+    });
+}
+
+// Copies between buffers of the same type, which may overlap.
+inline void copy(const_buffer_view source, buffer_view destination)
+{
+    internal::check_same_size(source, destination);
+    if(source.type() != destination.type())
+        throw std::invalid_argument("copy between buffers of different types, use convert");
+
+    if(!source.empty())
+        std::memmove(destination.data(), source.data(), source.byteSize());
+}
+
+// Sets every element to value converted to the buffer's type.
+inline void fill(buffer_view destination, double value)
+{
+    internal::visit_elements(destination, [&]<typename T>(T* elements){
+        std::fill_n(elements, destination.size(), internal::convert_value<T>(value));
+    });
+}
+
+// Multiplies every element by factor. float32 and float16 are scaled in float32, other types
+// in double, and the product is converted back.
+inline void scale(buffer_view values, double factor)
+{
+    internal::visit_elements(values, [&]<typename T>(T* elements){
+#if defined(CORE_SIMD_X86)
+        if constexpr(std::is_same_v<T, float> || std::is_same_v<T, half>)
+        {
+            switch(active_simd_level())
+            {
+            case simd_level::avx512:
+                internal::avx512::scale(elements, values.size(), static_cast<float>(factor));
+                return;
+            case simd_level::avx2:
+                internal::avx2::scale(elements, values.size(), static_cast<float>(factor));
+                return;
+            case simd_level::scalar:
+                break;
+            }
+        }
+#endif
+        for(size_t index = 0; index < values.size(); ++index)
+        {
+            if constexpr(std::is_same_v<T, float> || std::is_same_v<T, half>)
+                elements[index] = internal::convert_value<T>(internal::convert_value<float>(elements[index]) * static_cast<float>(factor));
+            else
+                elements[index] = internal::convert_value<T>(internal::convert_value<double>(elements[index]) * factor);
+        }
+    });
+}
+
+// Smallest and largest element, skipping NaNs; nullopt when there is no other element.
+inline std::optional<std::pair<double, double>> bounds(const_buffer_view values)
+{
+    std::optional<std::pair<double, double>> result;
+    internal::visit_elements(values, [&]<typename T>(const T* elements){
+        result = internal::bounds(elements, values.size());
+    });
+    return result;
+}
+
+inline std::optional<double> minimum(const_buffer_view values)
+{
+    const auto result = bounds(values);
+    return result ? std::optional<double>(result->first) : std::nullopt;
+}
+
+inline std::optional<double> maximum(const_buffer_view values)
+{
+    const auto result = bounds(values);
+    return result ? std::optional<double>(result->second) : std::nullopt;
+}
+
+// Accumulated in double; 64-bit integers beyond 2^53 lose precision.
+inline double sum(const_buffer_view values)
+{
+    double result = 0.0;
+    internal::visit_elements(values, [&]<typename T>(const T* elements){
+#if defined(CORE_SIMD_X86)
+        if constexpr(internal::exact_in_float<T>)
+        {
+            switch(active_simd_level())
+            {
+            case simd_level::avx512:
+                result = internal::avx512::sum(elements, values.size());
+                return;
+            case simd_level::avx2:
+                result = internal::avx2::sum(elements, values.size());
+                return;
+            case simd_level::scalar:
+                break;
+            }
+        }
+#endif
+        for(size_t index = 0; index < values.size(); ++index)
+            result += internal::convert_value<double>(elements[index]);
+    });
+    return result;
+}
+}
@@ -2,6 +2,13 @@
 
 #include <core/common.hpp>
 
+#include <bit>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
 namespace CORE_NAMESPACE
 {
 enum data_type : uint64_t
@@ -18,4 +25,121 @@ enum data_type : uint64_t
     float32,
     float64
 };
-}
\ No newline at end of file
+
+// Element of a float16 buffer: the bits of an IEEE 754 binary16 value.
+struct half
+{
+    uint16_t bits;
+
+    constexpr bool operator==(const half& other) const noexcept = default;
+};
+
+// Exact; NaN payloads are kept and quieted, as F16C does.
+constexpr float to_float(half value) noexcept
+{
+    const uint32_t word = static_cast<uint32_t>(value.bits) << 16;
+    const uint32_t sign = word & 0x80000000u;
+    const uint32_t doubled = word + word;
+
+    // Normal values and infinities: rebias the exponent by scaling. Subnormals: build 0.5 + m
+    // from the mantissa and subtract 0.5.
+    const float normalized = std::bit_cast<float>((doubled >> 4) + (0xe0u << 23)) * 0x1.0p-112f;
+    const float denormalized = std::bit_cast<float>((doubled >> 17) | (126u << 23)) - 0.5f;
+    const uint32_t magnitude = doubled < (1u << 27) ? std::bit_cast<uint32_t>(denormalized) : std::bit_cast<uint32_t>(normalized);
+    return std::bit_cast<float>(sign | magnitude);
+}
+
+// Rounds to nearest even, overflows to infinity and maps every NaN to the quiet NaN 0x7e00.
+constexpr half to_half(float value) noexcept
+{
+    const uint32_t word = std::bit_cast<uint32_t>(value);
+    const uint32_t doubled = word + word;
+    const uint32_t sign = word & 0x80000000u;
+
+    // Scaling up then down lets the float unit round at the position of binary16's last bit.
+    const float absolute = std::bit_cast<float>(word & 0x7fffffffu);
+    float base = absolute * 0x1.0p+112f * 0x1.0p-110f;
+    uint32_t bias = doubled & 0xff000000u;
+    if(bias < 0x71000000u)
+        bias = 0x71000000u;
+    base = std::bit_cast<float>((bias >> 1) + 0x07800000u) + base;
+
+    const uint32_t bits = std::bit_cast<uint32_t>(base);
+    const uint32_t magnitude = ((bits >> 13) & 0x7c00u) + (bits & 0x0fffu);
+    return half{static_cast<uint16_t>((sign >> 16) | (doubled > 0xff000000u ? 0x7e00u : magnitude))};
+}
+
+namespace internal
+{
+    template<data_type Type> struct data_type_value;
+    template<> struct data_type_value<uint8> { using type = uint8_t; };
+    template<> struct data_type_value<uint16> { using type = uint16_t; };
+    template<> struct data_type_value<uint32> { using type = uint32_t; };
+    template<> struct data_type_value<uint64> { using type = uint64_t; };
+    template<> struct data_type_value<int8> { using type = int8_t; };
+    template<> struct data_type_value<int16> { using type = int16_t; };
+    template<> struct data_type_value<int32> { using type = int32_t; };
+    template<> struct data_type_value<int64> { using type = int64_t; };
+    template<> struct data_type_value<float16> { using type = half; };
+    template<> struct data_type_value<float32> { using type = float; };
+    template<> struct data_type_value<float64> { using type = double; };
+}
+
+// C++ type of the elements of a data_type.
+template<data_type Type>
+using data_type_value = typename internal::data_type_value<Type>::type;
+
+// data_type whose elements are T.
+template<typename T>
+constexpr data_type data_type_of = []{
+    if constexpr(std::is_same_v<T, uint8_t>) return uint8;
+    else if constexpr(std::is_same_v<T, uint16_t>) return uint16;
+    else if constexpr(std::is_same_v<T, uint32_t>) return uint32;
+    else if constexpr(std::is_same_v<T, uint64_t>) return uint64;
+    else if constexpr(std::is_same_v<T, int8_t>) return int8;
+    else if constexpr(std::is_same_v<T, int16_t>) return int16;
+    else if constexpr(std::is_same_v<T, int32_t>) return int32;
+    else if constexpr(std::is_same_v<T, int64_t>) return int64;
+    else if constexpr(std::is_same_v<T, half>) return float16;
+    else if constexpr(std::is_same_v<T, float>) return float32;
+    else if constexpr(std::is_same_v<T, double>) return float64;
+    else static_assert(sizeof(T) == 0, "no data_type stores this type");
+}();
+
+// Calls function with std::type_identity<data_type_value<type>>. Throws std::invalid_argument
+// for a value outside the enumeration.
+template<typename FunctionType>
+constexpr decltype(auto) visit_data_type(data_type type, FunctionType&& function)
+{
+    switch(type)
+    {
+    case uint8: return std::forward<FunctionType>(function)(std::type_identity<uint8_t>{});
+    case uint16: return std::forward<FunctionType>(function)(std::type_identity<uint16_t>{});
+    case uint32: return std::forward<FunctionType>(function)(std::type_identity<uint32_t>{});
+    case uint64: return std::forward<FunctionType>(function)(std::type_identity<uint64_t>{});
+    case int8: return std::forward<FunctionType>(function)(std::type_identity<int8_t>{});
+    case int16: return std::forward<FunctionType>(function)(std::type_identity<int16_t>{});
+    case int32: return std::forward<FunctionType>(function)(std::type_identity<int32_t>{});
+    case int64: return std::forward<FunctionType>(function)(std::type_identity<int64_t>{});
+    case float16: return std::forward<FunctionType>(function)(std::type_identity<half>{});
+    case float32: return std::forward<FunctionType>(function)(std::type_identity<float>{});
+    case float64: return std::forward<FunctionType>(function)(std::type_identity<double>{});
+    }
+    throw std::invalid_argument("unknown data_type " + std::to_string(static_cast<uint64_t>(type)));
+}
+
+constexpr size_t data_type_size(data_type type)
+{
+    return visit_data_type(type, []<typename T>(std::type_identity<T>){ return sizeof(T); });
+}
+
+constexpr std::string_view data_type_name(data_type type) noexcept
+{
+    constexpr std::string_view names[] = {
+        "uint8", "uint16", "uint32", "uint64",
+        "int8", "int16", "int32", "int64",
+        "float16", "float32", "float64"
+    };
+    return type <= float64 ? names[type] : std::string_view{"unknown"};
+}
+}
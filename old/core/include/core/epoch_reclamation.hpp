@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Epoch-based reclamation. Readers publish the global epoch while inside an epoch_guard, and
+// a retired object is reclaimed only once the epoch has advanced twice past its retirement, by
+// which time every guard that could still reach it has been left. Entering and leaving a guard
+// only write the thread's own record, so readers do not contend with each other.
+class epoch_reclamation
+{
+public:
+    using reclaim_function = void(*)(void* object) noexcept;
+    // Retired objects a thread accumulates before retire() tries to reclaim them. A thread that
+    // stops short of it keeps its objects until it calls collect() or exits, when what is not
+    // yet safe passes to the next collect() on any thread.
+    constexpr static size_t reclaimThreshold = 64;
+private:
+    struct retired_object
+    {
+        void* object;
+        reclaim_function reclaim;
+        uint64_t epoch;
+    };
+
+    struct alignas(64) thread_record
+    {
+        // Epoch observed when the outermost guard was entered, zero outside of guards.
+        std::atomic<uint64_t> epoch{0};
+        std::atomic<bool> inUse{true};
+        // Records are never freed, threads that exit leave theirs for the next thread.
+        thread_record* next{};
+        size_t nesting{0};
+        std::vector<retired_object> retired;
+    };
+
+    class thread_handle
+    {
+    private:
+        thread_record* _record;
+    public:
+        thread_handle();
+        thread_handle(const thread_handle& other) = delete;
+        thread_handle& operator=(const thread_handle& other) = delete;
+        ~thread_handle();
+    public:
+        [[nodiscard]] inline thread_record& record() const noexcept
+        {
+            return *_record;
+        }
+    };
+private:
+    alignas(64) inline static std::atomic<uint64_t> _epoch{1};
+    inline static std::atomic<thread_record*> _records{nullptr};
+    // Objects retired by threads that exited before they could be reclaimed.
+    inline static std::mutex _orphanMutex;
+    inline static std::vector<retired_object> _orphans;
+public:
+    static void enter() noexcept;
+    static void leave() noexcept;
+    // `reclaim` runs on some thread once no guard entered before this call is still active.
+    // Throws std::bad_alloc if the object cannot be recorded, it is then not retired.
+    static void retire(void* object, reclaim_function reclaim);
+    // Advances the epoch as far as active guards allow and reclaims what became safe. Throws
+    // std::bad_alloc if that cannot be set aside, every object then stays retired.
+    static void collect();
+    [[nodiscard]] static inline uint64_t epoch() noexcept
+    {
+        return _epoch.load(std::memory_order_acquire);
+    }
+private:
+    [[nodiscard]] static thread_record& local() noexcept;
+    static void tryAdvance() noexcept;
+    // Removes and returns the entries that are safe at `epoch`; leaves `retired` as it was if
+    // that throws.
+    [[nodiscard]] static std::vector<retired_object> takeReclaimable(std::vector<retired_object>& retired, uint64_t epoch);
+    static void reclaim(const std::vector<retired_object>& reclaimable) noexcept;
+};
+
+// Critical section of a reader; guards nest.
+class epoch_guard
+{
+public:
+    inline epoch_guard() noexcept
+    {
+        epoch_reclamation::enter();
+    }
+    epoch_guard(const epoch_guard& other) = delete;
+    epoch_guard& operator=(const epoch_guard& other) = delete;
+    inline ~epoch_guard()
+    {
+        epoch_reclamation::leave();
+    }
+};
+
+inline epoch_reclamation::thread_handle::thread_handle()
+{
+    for(auto* record = _records.load(std::memory_order_acquire); record != nullptr; record = record->next)
+    {
+        bool inUse = false;
+        if(record->inUse.compare_exchange_strong(inUse, true, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            _record = record;
+            return;
+        }
+    }
+
+    _record = new thread_record{};
+    _record->next = _records.load(std::memory_order_relaxed);
+    while(!_records.compare_exchange_weak(_record->next, _record, std::memory_order_release, std::memory_order_relaxed));
+}
+
+inline epoch_reclamation::thread_handle::~thread_handle()
+{
+    // Out of memory at exit, the objects left are leaked rather than reclaimed too early.
+    try
+    {
+        reclaim(takeReclaimable(_record->retired, epoch()));
+        if(!_record->retired.empty())
+        {
+            std::lock_guard lock(_orphanMutex);
+            _orphans.insert(_orphans.end(), _record->retired.begin(), _record->retired.end());
+        }
+    }
+    catch (const std::bad_alloc&)
+    {
+    }
+    _record->retired.clear();
+
+    _record->nesting = 0;
+    _record->epoch.store(0, std::memory_order_release);
+    _record->inUse.store(false, std::memory_order_release);
+}
+
+inline void epoch_reclamation::enter() noexcept
+{
+    auto& record = local();
+    if(record.nesting++ != 0)
+        return;
+
+    // The fence orders the announcement before every read inside the guard; collect
+    // pairs it with its own before scanning the records.
+    record.epoch.store(_epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+inline void epoch_reclamation::leave() noexcept
+{
+    auto& record = local();
+    if(--record.nesting == 0)
+        record.epoch.store(0, std::memory_order_release);
+}
+
+inline void epoch_reclamation::retire(void* object, reclaim_function reclaim)
+{
+    auto& record = local();
+    record.retired.push_back({object, reclaim, _epoch.load(std::memory_order_acquire)});
+    if(record.retired.size() < reclaimThreshold)
+        return;
+
+    // The object is retired by now, a collect that runs out of memory is left to the next one.
+    try
+    {
+        collect();
+    }
+    catch (const std::bad_alloc&)
+    {
+    }
+}
+
+inline void epoch_reclamation::collect()
+{
+    tryAdvance();
+    const auto current = epoch();
+    reclaim(takeReclaimable(local().retired, current));
+
+    // Reclaim functions may retire and collect in turn, so they run outside the lock.
+    std::vector<retired_object> orphans;
+    if(std::unique_lock lock(_orphanMutex, std::try_to_lock); lock.owns_lock())
+        orphans = takeReclaimable(_orphans, current);
+    reclaim(orphans);
+}
+
+inline epoch_reclamation::thread_record& epoch_reclamation::local() noexcept
+{
+    thread_local thread_handle handle;
+    return handle.record();
+}
+
+inline void epoch_reclamation::tryAdvance() noexcept
+{
+    auto current = _epoch.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    for(auto* record = _records.load(std::memory_order_acquire); record != nullptr; record = record->next)
+    {
+        const auto observed = record->epoch.load(std::memory_order_acquire);
+        if(observed != 0 && observed != current)
+            return;
+    }
+
+    // Losing the race means another thread advanced it already.
+    _epoch.compare_exchange_strong(current, current + 1, std::memory_order_acq_rel, std::memory_order_relaxed);
+}
+
+inline std::vector<epoch_reclamation::retired_object> epoch_reclamation::takeReclaimable(std::vector<retired_object>& retired, uint64_t epoch)
+{
+    // Reclaim functions may retire further objects, so the safe entries are taken out first.
+    const auto unsafe = std::partition(retired.begin(), retired.end(), [epoch](const retired_object& entry){
+        return entry.epoch + 2 > epoch;
+    });
+
+    std::vector<retired_object> reclaimable(unsafe, retired.end());
+    retired.erase(unsafe, retired.end());
+    return reclaimable;
+}
+
+inline void epoch_reclamation::reclaim(const std::vector<retired_object>& reclaimable) noexcept
+{
+    for(const auto& entry : reclaimable)
+        entry.reclaim(entry.object);
+}
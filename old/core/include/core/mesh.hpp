@@ -0,0 +1,210 @@
+#pragma once
+
+#include <core/common.hpp>
+#include <core/buffer.hpp>
+#include <core/data_type.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace CORE_NAMESPACE
+{
+// One vertex attribute, stored as its own column of vertexCount * components elements.
+class vertex_stream
+{
+    friend class mesh;
+private:
+    std::string _name;
+    size_t _components;
+    buffer _data;
+public:
+    vertex_stream(std::string name, data_type type, size_t components, size_t vertexCount)
+        : _name(std::move(name))
+        , _components(components)
+        , _data(type, vertexCount * components)
+    {}
+public:
+    [[nodiscard]] const std::string& name() const noexcept
+    {
+        return _name;
+    }
+    [[nodiscard]] data_type type() const noexcept
+    {
+        return _data.type();
+    }
+    [[nodiscard]] size_t components() const noexcept
+    {
+        return _components;
+    }
+    [[nodiscard]] size_t vertexCount() const noexcept
+    {
+        return _components != 0 ? _data.size() / _components : 0;
+    }
+    // Bytes of one vertex in this stream.
+    [[nodiscard]] size_t stride() const noexcept
+    {
+        return _components * data_type_size(_data.type());
+    }
+    [[nodiscard]] buffer_view view() noexcept
+    {
+        return _data.view();
+    }
+    [[nodiscard]] const_buffer_view view() const noexcept
+    {
+        return _data.view();
+    }
+    template<typename T>
+    [[nodiscard]] std::span<T> elements()
+    {
+        return _data.elements<T>();
+    }
+    template<typename T>
+    [[nodiscard]] std::span<const T> elements() const
+    {
+        return _data.elements<T>();
+    }
+};
+
+// Indexed triangle list with its attributes in separate vertex streams, so each can use the
+// most compact data_type and passes that touch one attribute only stream that one. Indices are
+// stored in 16 bits while the vertices fit, in 32 bits otherwise.
+class mesh
+{
+public:
+    constexpr static uint32_t removedVertex = std::numeric_limits<uint32_t>::max();
+private:
+    std::vector<vertex_stream> _streams;
+    size_t _vertexCount{};
+    buffer _indices;
+public:
+    mesh() = default;
+    explicit mesh(size_t vertexCount)
+        : _vertexCount(vertexCount)
+    {}
+public:
+    [[nodiscard]] size_t vertexCount() const noexcept
+    {
+        return _vertexCount;
+    }
+    [[nodiscard]] size_t indexCount() const noexcept
+    {
+        return _indices.size();
+    }
+    [[nodiscard]] size_t triangleCount() const noexcept
+    {
+        return _indices.size() / 3;
+    }
+public:
+    // Throws std::invalid_argument if a stream of that name exists already.
+    vertex_stream& addStream(std::string name, data_type type, size_t components)
+    {
+        if(findStream(name) != nullptr)
+            throw std::invalid_argument("mesh already has a stream named " + name);
+
+        return _streams.emplace_back(std::move(name), type, components, _vertexCount);
+    }
+    [[nodiscard]] vertex_stream* findStream(std::string_view name) noexcept
+    {
+        const auto found = std::ranges::find(_streams, name, &vertex_stream::name);
+        return found != _streams.end() ? &*found : nullptr;
+    }
+    [[nodiscard]] const vertex_stream* findStream(std::string_view name) const noexcept
+    {
+        const auto found = std::ranges::find(_streams, name, &vertex_stream::name);
+        return found != _streams.end() ? &*found : nullptr;
+    }
+    [[nodiscard]] std::span<vertex_stream> streams() noexcept
+    {
+        return _streams;
+    }
+    [[nodiscard]] std::span<const vertex_stream> streams() const noexcept
+    {
+        return _streams;
+    }
+public:
+    // uint16 or uint32, whichever addresses every vertex.
+    [[nodiscard]] data_type indexType() const noexcept
+    {
+        return indexTypeFor(_vertexCount);
+    }
+    [[nodiscard]] const_buffer_view indexView() const noexcept
+    {
+        return _indices.view();
+    }
+    [[nodiscard]] uint32_t index(size_t position) const noexcept
+    {
+        if(_indices.type() == uint16)
+            return reinterpret_cast<const uint16_t*>(_indices.data())[position];
+        return reinterpret_cast<const uint32_t*>(_indices.data())[position];
+    }
+    [[nodiscard]] std::vector<uint32_t> indices() const
+    {
+        std::vector<uint32_t> result(_indices.size());
+        for(size_t position = 0; position < result.size(); ++position)
+            result[position] = index(position);
+        return result;
+    }
+    // Throws std::invalid_argument unless the indices form whole triangles of existing vertices.
+    void setIndices(std::span<const uint32_t> indices)
+    {
+        if(indices.size() % 3 != 0)
+            throw std::invalid_argument("index count is not a multiple of three");
+        if(std::ranges::any_of(indices, [this](uint32_t index){ return index >= _vertexCount; }))
+            throw std::invalid_argument("index refers to a vertex the mesh does not have");
+
+        buffer stored(indexType(), indices.size());
+        if(stored.type() == uint16)
+            std::ranges::transform(indices, stored.elements<uint16_t>().begin(), [](uint32_t index){ return static_cast<uint16_t>(index); });
+        else if(!indices.empty())
+            std::memcpy(stored.data(), indices.data(), indices.size_bytes());
+        _indices = std::move(stored);
+    }
+    // Moves vertex v to remap[v] in every stream, or drops it for removedVertex, and rewrites the
+    // indices to match. Vertices mapped to the same position must be identical, and referenced
+    // vertices must be kept.
+    void remapVertices(std::span<const uint32_t> remap, size_t newVertexCount)
+    {
+        if(remap.size() != _vertexCount)
+            throw std::invalid_argument("remap table does not cover every vertex");
+        if(std::ranges::any_of(remap, [newVertexCount](uint32_t target){ return target != removedVertex && target >= newVertexCount; }))
+            throw std::invalid_argument("remap moves a vertex past the new vertex count");
+
+        auto indices = this->indices();
+        for(auto& index : indices)
+        {
+            index = remap[index];
+            if(index == removedVertex)
+                throw std::invalid_argument("remap drops a referenced vertex");
+        }
+
+        for(auto& stream : _streams)
+        {
+            vertex_stream remapped(stream._name, stream.type(), stream._components, newVertexCount);
+            const auto stride = stream.stride();
+            const auto* source = stream._data.data();
+            auto* destination = remapped._data.data();
+            for(size_t vertex = 0; vertex < _vertexCount; ++vertex)
+            {
+                if(remap[vertex] != removedVertex)
+                    std::memcpy(destination + remap[vertex] * stride, source + vertex * stride, stride);
+            }
+            stream = std::move(remapped);
+        }
+
+        _vertexCount = newVertexCount;
+        setIndices(indices);
+    }
+private:
+    [[nodiscard]] static data_type indexTypeFor(size_t vertexCount) noexcept
+    {
+        return vertexCount <= size_t{std::numeric_limits<uint16_t>::max()} + 1 ? uint16 : uint32;
+    }
+};
+}
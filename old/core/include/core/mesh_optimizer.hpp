@@ -0,0 +1,448 @@
+#pragma once
+
+#include <core/common.hpp>
+#include <core/buffer_kernels.hpp>
+#include <core/mesh.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Passes that prepare a mesh for rendering, in the order optimize_mesh runs them: merge equal
+// vertices, order triangles for the post-transform vertex cache (Tipsify, Sander et al. 2007),
+// reorder clusters of those triangles against overdraw, and lay the vertices out in the order
+// the triangles fetch them.
+
+namespace CORE_NAMESPACE
+{
+struct vertex_cache_statistics
+{
+    // Vertices the simulated cache had to transform.
+    size_t transformedVertices{};
+    // Transformed vertices per triangle: 3 without any reuse, about 0.5 for a large regular grid.
+    float acmr{};
+    // Transformed vertices per vertex, 1 at best.
+    float atvr{};
+};
+
+struct mesh_optimization_options
+{
+    // Entries of the FIFO post-transform cache the ordering assumes.
+    size_t cacheSize = 16;
+    // How much worse a cluster's cache efficiency may get to reduce overdraw; 1.05 allows 5%.
+    float overdrawThreshold = 1.05f;
+    // Stream of at least three components holding positions; overdraw ordering is skipped without it.
+    std::string positionStream = "position";
+};
+
+namespace internal
+{
+    // FIFO cache of vertex ids: a vertex is cached while fewer than size misses followed its own.
+    class fifo_vertex_cache
+    {
+    private:
+        std::vector<uint32_t> _timestamps;
+        uint32_t _time;
+        uint32_t _size;
+    public:
+        fifo_vertex_cache(size_t vertexCount, size_t size)
+            : _timestamps(vertexCount, 0)
+            , _time(static_cast<uint32_t>(size) + 1)
+            , _size(static_cast<uint32_t>(size))
+        {}
+    public:
+        // Returns true on a miss.
+        inline bool access(uint32_t vertex) noexcept
+        {
+            if(_time - _timestamps[vertex] <= _size)
+                return false;
+
+            _timestamps[vertex] = _time++;
+            return true;
+        }
+        inline void clear() noexcept
+        {
+            _time += _size + 1;
+        }
+    };
+
+    // Triangles around each vertex, as offsets into one array.
+    struct vertex_triangles
+    {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> triangles;
+
+        vertex_triangles(std::span<const uint32_t> indices, size_t vertexCount)
+            : offsets(vertexCount + 1, 0)
+            , triangles(indices.size())
+        {
+            for(const auto index : indices)
+                ++offsets[index + 1];
+            for(size_t vertex = 0; vertex < vertexCount; ++vertex)
+                offsets[vertex + 1] += offsets[vertex];
+
+            auto cursors = offsets;
+            for(size_t position = 0; position < indices.size(); ++position)
+                triangles[cursors[indices[position]]++] = static_cast<uint32_t>(position / 3);
+        }
+
+        [[nodiscard]] inline std::span<const uint32_t> of(uint32_t vertex) const noexcept
+        {
+            return std::span(triangles).subspan(offsets[vertex], offsets[vertex + 1] - offsets[vertex]);
+        }
+    };
+
+    inline uint64_t hash_vertex(const mesh& geometry, size_t vertex) noexcept
+    {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for(const auto& stream : geometry.streams())
+        {
+            const auto stride = stream.stride();
+            const auto* bytes = stream.view().data() + vertex * stride;
+            for(size_t offset = 0; offset < stride; ++offset)
+            {
+                hash ^= static_cast<uint8_t>(bytes[offset]);
+                hash *= 0x100000001b3ull;
+            }
+        }
+        return hash;
+    }
+
+    inline bool equal_vertices(const mesh& geometry, size_t first, size_t second) noexcept
+    {
+        return std::ranges::all_of(geometry.streams(), [&](const vertex_stream& stream){
+            const auto stride = stream.stride();
+            const auto* bytes = stream.view().data();
+            return std::memcmp(bytes + first * stride, bytes + second * stride, stride) == 0;
+        });
+    }
+
+    // Tipsify: fans around a vertex still in the cache, preferring the oldest one that survives
+    // its own fan, and falls back to recently used vertices and then to input order.
+    inline std::vector<uint32_t> tipsify(std::span<const uint32_t> indices, size_t vertexCount, size_t cacheSize)
+    {
+        const vertex_triangles adjacency(indices, vertexCount);
+        std::vector<uint32_t> liveTriangles(vertexCount);
+        for(size_t vertex = 0; vertex < vertexCount; ++vertex)
+            liveTriangles[vertex] = adjacency.offsets[vertex + 1] - adjacency.offsets[vertex];
+
+        std::vector<uint32_t> timestamps(vertexCount, 0);
+        std::vector<bool> emitted(indices.size() / 3, false);
+        std::vector<uint32_t> deadEnds;
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> result;
+        deadEnds.reserve(indices.size());
+        result.reserve(indices.size());
+
+        auto time = static_cast<uint32_t>(cacheSize) + 1;
+        size_t cursor = 1;
+        int64_t fanning = vertexCount != 0 ? 0 : -1;
+        while(fanning >= 0)
+        {
+            candidates.clear();
+            for(const auto triangle : adjacency.of(static_cast<uint32_t>(fanning)))
+            {
+                if(emitted[triangle])
+                    continue;
+
+                for(size_t corner = 0; corner < 3; ++corner)
+                {
+                    const auto vertex = indices[triangle * 3 + corner];
+                    result.push_back(vertex);
+                    deadEnds.push_back(vertex);
+                    candidates.push_back(vertex);
+                    --liveTriangles[vertex];
+                    if(time - timestamps[vertex] > cacheSize)
+                        timestamps[vertex] = time++;
+                }
+                emitted[triangle] = true;
+            }
+
+            fanning = -1;
+            int64_t bestPriority = -1;
+            for(const auto vertex : candidates)
+            {
+                if(liveTriangles[vertex] == 0)
+                    continue;
+
+                int64_t priority = 0;
+                if(time - timestamps[vertex] + 2 * liveTriangles[vertex] <= cacheSize)
+                    priority = time - timestamps[vertex];
+                if(priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    fanning = vertex;
+                }
+            }
+
+            while(fanning < 0 && !deadEnds.empty())
+            {
+                const auto vertex = deadEnds.back();
+                deadEnds.pop_back();
+                if(liveTriangles[vertex] != 0)
+                    fanning = vertex;
+            }
+            for(; fanning < 0 && cursor < vertexCount; ++cursor)
+            {
+                if(liveTriangles[cursor] != 0)
+                    fanning = static_cast<int64_t>(cursor);
+            }
+        }
+
+        return result;
+    }
+
+    using vector3 = std::array<float, 3>;
+
+    inline vector3 subtract(const vector3& left, const vector3& right) noexcept
+    {
+        return {left[0] - right[0], left[1] - right[1], left[2] - right[2]};
+    }
+
+    inline vector3 cross(const vector3& left, const vector3& right) noexcept
+    {
+        return {
+            left[1] * right[2] - left[2] * right[1],
+            left[2] * right[0] - left[0] * right[2],
+            left[0] * right[1] - left[1] * right[0]
+        };
+    }
+
+    inline float dot(const vector3& left, const vector3& right) noexcept
+    {
+        return left[0] * right[0] + left[1] * right[1] + left[2] * right[2];
+    }
+
+    // Splits the triangle order into clusters that can be drawn in any order while each keeps
+    // its cache efficiency within threshold of the unsplit run: first where the cache restarts
+    // anyway, then inside those runs wherever a cold-started cluster has already caught up.
+    inline std::vector<size_t> overdraw_clusters(std::span<const uint32_t> indices, size_t vertexCount, size_t cacheSize, float threshold)
+    {
+        const auto triangleCount = indices.size() / 3;
+        fifo_vertex_cache cache(vertexCount, cacheSize);
+
+        std::vector<size_t> hardBoundaries;
+        for(size_t triangle = 0; triangle < triangleCount; ++triangle)
+        {
+            size_t misses = 0;
+            for(size_t corner = 0; corner < 3; ++corner)
+                misses += cache.access(indices[triangle * 3 + corner]);
+            if(triangle == 0 || misses == 3)
+                hardBoundaries.push_back(triangle);
+        }
+        hardBoundaries.push_back(triangleCount);
+
+        std::vector<size_t> boundaries;
+        for(size_t hard = 0; hard + 1 < hardBoundaries.size(); ++hard)
+        {
+            const auto first = hardBoundaries[hard];
+            const auto last = hardBoundaries[hard + 1];
+
+            cache.clear();
+            size_t misses = 0;
+            for(size_t triangle = first; triangle < last; ++triangle)
+                for(size_t corner = 0; corner < 3; ++corner)
+                    misses += cache.access(indices[triangle * 3 + corner]);
+            const auto limit = threshold * static_cast<float>(misses) / static_cast<float>(last - first);
+
+            cache.clear();
+            boundaries.push_back(first);
+            size_t clusterMisses = 0;
+            size_t clusterTriangles = 0;
+            for(size_t triangle = first; triangle < last; ++triangle)
+            {
+                for(size_t corner = 0; corner < 3; ++corner)
+                    clusterMisses += cache.access(indices[triangle * 3 + corner]);
+                ++clusterTriangles;
+
+                if(triangle + 1 < last && static_cast<float>(clusterMisses) <= limit * static_cast<float>(clusterTriangles))
+                {
+                    boundaries.push_back(triangle + 1);
+                    cache.clear();
+                    clusterMisses = 0;
+                    clusterTriangles = 0;
+                }
+            }
+        }
+        boundaries.push_back(triangleCount);
+        return boundaries;
+    }
+}
+
+// Merges vertices whose bytes are equal in every stream and returns the new vertex count.
+// Vertices keep the order of their first occurrence.
+inline size_t deduplicate_vertices(mesh& geometry)
+{
+    const auto vertexCount = geometry.vertexCount();
+    std::vector<uint64_t> hashes(vertexCount);
+    for(size_t vertex = 0; vertex < vertexCount; ++vertex)
+        hashes[vertex] = internal::hash_vertex(geometry, vertex);
+
+    // Open addressing over vertex ids, at most half full.
+    const auto mask = std::bit_ceil(std::max<size_t>(vertexCount * 2, 1)) - 1;
+    std::vector<uint32_t> table(mask + 1, mesh::removedVertex);
+    std::vector<uint32_t> remap(vertexCount);
+    uint32_t uniqueCount = 0;
+    for(size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        auto slot = hashes[vertex] & mask;
+        while(table[slot] != mesh::removedVertex)
+        {
+            const auto other = table[slot];
+            if(hashes[other] == hashes[vertex] && internal::equal_vertices(geometry, other, vertex))
+                break;
+            slot = (slot + 1) & mask;
+        }
+
+        if(table[slot] != mesh::removedVertex)
+        {
+            remap[vertex] = remap[table[slot]];
+            continue;
+        }
+
+        table[slot] = static_cast<uint32_t>(vertex);
+        remap[vertex] = uniqueCount++;
+    }
+
+    if(uniqueCount != vertexCount)
+        geometry.remapVertices(remap, uniqueCount);
+    return uniqueCount;
+}
+
+// Reorders the triangles so consecutive ones share vertices still in a FIFO cache of cacheSize.
+inline void optimize_vertex_cache(mesh& geometry, size_t cacheSize = 16)
+{
+    const auto indices = geometry.indices();
+    geometry.setIndices(internal::tipsify(indices, geometry.vertexCount(), cacheSize));
+}
+
+// Keeps the cache-ordered triangles in clusters and draws the clusters facing away from the
+// mesh's centre first, so that from most viewpoints the outer surface is drawn before what it
+// hides. Run after optimize_vertex_cache. Throws std::invalid_argument for an unknown stream or
+// one with fewer than three components.
+inline void optimize_overdraw(mesh& geometry, std::string_view positionStream = "position", size_t cacheSize = 16, float threshold = 1.05f)
+{
+    const auto* stream = geometry.findStream(positionStream);
+    if(stream == nullptr || stream->components() < 3)
+        throw std::invalid_argument("mesh has no position stream with three components named " + std::string(positionStream));
+
+    buffer positions(float32, stream->view().size());
+    convert(stream->view(), positions);
+    const auto coordinates = positions.elements<float>();
+    const auto components = stream->components();
+    const auto position = [&](uint32_t vertex){
+        return internal::vector3{coordinates[vertex * components], coordinates[vertex * components + 1], coordinates[vertex * components + 2]};
+    };
+
+    const auto indices = geometry.indices();
+    const auto boundaries = internal::overdraw_clusters(indices, geometry.vertexCount(), cacheSize, threshold);
+    const auto clusterCount = boundaries.size() - 1;
+
+    // Area-weighted centroids and normals of every cluster and of the whole mesh.
+    std::vector<internal::vector3> centroids(clusterCount);
+    std::vector<internal::vector3> normals(clusterCount);
+    std::vector<float> areas(clusterCount);
+    internal::vector3 meshCentroid{};
+    float meshArea = 0.0f;
+    for(size_t cluster = 0; cluster < clusterCount; ++cluster)
+    {
+        internal::vector3 weighted{};
+        internal::vector3 normal{};
+        float area = 0.0f;
+        for(size_t triangle = boundaries[cluster]; triangle < boundaries[cluster + 1]; ++triangle)
+        {
+            const auto a = position(indices[triangle * 3]);
+            const auto b = position(indices[triangle * 3 + 1]);
+            const auto c = position(indices[triangle * 3 + 2]);
+            const auto triangleNormal = internal::cross(internal::subtract(b, a), internal::subtract(c, a));
+            const auto triangleArea = std::sqrt(internal::dot(triangleNormal, triangleNormal)) * 0.5f;
+            for(size_t axis = 0; axis < 3; ++axis)
+            {
+                weighted[axis] += (a[axis] + b[axis] + c[axis]) / 3.0f * triangleArea;
+                normal[axis] += triangleNormal[axis];
+            }
+            area += triangleArea;
+        }
+
+        for(size_t axis = 0; axis < 3; ++axis)
+        {
+            meshCentroid[axis] += weighted[axis];
+            centroids[cluster][axis] = area > 0.0f ? weighted[axis] / area : 0.0f;
+        }
+        normals[cluster] = normal;
+        areas[cluster] = area;
+        meshArea += area;
+    }
+    for(auto& axis : meshCentroid)
+        axis = meshArea > 0.0f ? axis / meshArea : 0.0f;
+
+    std::vector<float> sortKeys(clusterCount, 0.0f);
+    for(size_t cluster = 0; cluster < clusterCount; ++cluster)
+    {
+        const auto length = std::sqrt(internal::dot(normals[cluster], normals[cluster]));
+        if(length > 0.0f && areas[cluster] > 0.0f)
+            sortKeys[cluster] = internal::dot(internal::subtract(centroids[cluster], meshCentroid), normals[cluster]) / length;
+    }
+
+    std::vector<size_t> order(clusterCount);
+    for(size_t cluster = 0; cluster < clusterCount; ++cluster)
+        order[cluster] = cluster;
+    std::ranges::stable_sort(order, [&](size_t left, size_t right){ return sortKeys[left] > sortKeys[right]; });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for(const auto cluster : order)
+        result.insert(result.end(), indices.begin() + boundaries[cluster] * 3, indices.begin() + boundaries[cluster + 1] * 3);
+    geometry.setIndices(result);
+}
+
+// Renumbers the vertices in the order the triangles first use them, so vertex fetches walk each
+// stream forward, and drops vertices no triangle uses. Returns the new vertex count.
+inline size_t optimize_vertex_fetch(mesh& geometry)
+{
+    std::vector<uint32_t> remap(geometry.vertexCount(), mesh::removedVertex);
+    uint32_t vertexCount = 0;
+    for(size_t position = 0; position < geometry.indexCount(); ++position)
+    {
+        auto& target = remap[geometry.index(position)];
+        if(target == mesh::removedVertex)
+            target = vertexCount++;
+    }
+
+    geometry.remapVertices(remap, vertexCount);
+    return vertexCount;
+}
+
+inline vertex_cache_statistics analyze_vertex_cache(const mesh& geometry, size_t cacheSize = 16)
+{
+    internal::fifo_vertex_cache cache(geometry.vertexCount(), cacheSize);
+    vertex_cache_statistics statistics;
+    for(size_t position = 0; position < geometry.indexCount(); ++position)
+        statistics.transformedVertices += cache.access(geometry.index(position));
+
+    if(geometry.triangleCount() != 0)
+        statistics.acmr = static_cast<float>(statistics.transformedVertices) / static_cast<float>(geometry.triangleCount());
+    if(geometry.vertexCount() != 0)
+        statistics.atvr = static_cast<float>(statistics.transformedVertices) / static_cast<float>(geometry.vertexCount());
+    return statistics;
+}
+
+// Runs every pass; overdraw ordering only when the position stream exists.
+inline void optimize_mesh(mesh& geometry, const mesh_optimization_options& options = {})
+{
+    deduplicate_vertices(geometry);
+    optimize_vertex_cache(geometry, options.cacheSize);
+
+    const auto* positions = geometry.findStream(options.positionStream);
+    if(positions != nullptr && positions->components() >= 3)
+        optimize_overdraw(geometry, options.positionStream, options.cacheSize, options.overdrawThreshold);
+
+    optimize_vertex_fetch(geometry);
+}
+}
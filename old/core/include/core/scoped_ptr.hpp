@@ -2,25 +2,37 @@
 
 #include <type_traits>
 #include <concepts>
+#include <algorithm>
 #include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
 #include <variant>
 #include <tuple>
 
+#include <core/epoch_reclamation.hpp>
+#include <core/slab_pool.hpp>
+
 template<typename ControlBlockType>
 concept scoped_lock_control_block = requires(ControlBlockType controlBlock)
 {
     { controlBlock.acquire() } -> std::same_as<bool>;
-    { controlBlock.release() } -> std::same_as<std::tuple<bool, bool>>;
+    { controlBlock.release() } -> std::same_as<bool>;
     { controlBlock.acquireWeak() } -> std::same_as<void>;
     { controlBlock.releaseWeak() } -> std::same_as<bool>;
     { controlBlock.useCount() } -> std::same_as<size_t>;
 } && std::is_default_constructible_v<ControlBlockType>;
 
+// The strong references together hold one weak reference, which the last of them releases
+// after destroying the element. The block therefore outlives the element's destructor even
+// when it drops the last weak reference to itself.
 class synchronized_scoped_ptr_control_block
 {
 private:
     std::atomic<size_t> _countStrong{1};
-    std::atomic<size_t> _countWeak{0};
+    std::atomic<size_t> _countWeak{1};
 public:
     inline bool acquire() noexcept
     {
@@ -29,32 +41,26 @@ public:
         while (countStrong != 0 && !_countStrong.compare_exchange_weak(
             countStrong,
             countStrong + 1,
-            std::memory_order_relaxed,
+            std::memory_order_acquire,
             std::memory_order_relaxed
             )
         );
 
         return countStrong != 0;
     }
-    inline std::tuple<bool, bool> release() noexcept
+    // Returns true when the last strong reference was released.
+    inline bool release() noexcept
     {
-        size_t countStrongBeforeRelease = _countStrong.fetch_sub(1, std::memory_order_relaxed);
-        size_t countWeak = _countWeak.load(std::memory_order_relaxed);
-        return std::make_tuple(countStrongBeforeRelease == 1, countWeak == 0);
+        return _countStrong.fetch_sub(1, std::memory_order_acq_rel) == 1;
     }
     inline void acquireWeak() noexcept
     {
-        size_t countStrong = _countStrong.load(std::memory_order_relaxed);
-        if(countStrong == 0)
-            return;
-
         _countWeak.fetch_add(1, std::memory_order_relaxed);
     }
+    // Returns true when the last weak reference was released.
     inline bool releaseWeak() noexcept
     {
-        size_t countWeakBeforeRelease = _countWeak.fetch_sub(1, std::memory_order_relaxed);
-        size_t countStrong = _countStrong.load(std::memory_order_relaxed);
-        return countStrong == 0 && countWeakBeforeRelease == 1;
+        return _countWeak.fetch_sub(1, std::memory_order_acq_rel) == 1;
     }
 public:
     inline size_t useCount() noexcept
@@ -63,28 +69,384 @@ public:
     }
 };
 
+// Plain counters for object graphs confined to one thread, or guarded by the caller.
+class unsynchronized_scoped_ptr_control_block
+{
+private:
+    size_t _countStrong{1};
+    size_t _countWeak{1};
+public:
+    inline bool acquire() noexcept
+    {
+        if(_countStrong == 0)
+            return false;
+
+        ++_countStrong;
+        return true;
+    }
+    inline bool release() noexcept
+    {
+        return --_countStrong == 0;
+    }
+    inline void acquireWeak() noexcept
+    {
+        ++_countWeak;
+    }
+    inline bool releaseWeak() noexcept
+    {
+        return --_countWeak == 0;
+    }
+public:
+    inline size_t useCount() noexcept
+    {
+        return _countStrong;
+    }
+};
+
+// Synchronized counts whose element outlives the last strong reference until every epoch_guard
+// active at that moment has been left. Readers inside a guard may then use scoped_weak_ptr::peek
+// to reach the element without writing to the block, lock() is still needed to keep it longer.
+class epoch_scoped_ptr_control_block
+    : public synchronized_scoped_ptr_control_block
+{};
+
+template<typename ControlBlockType>
+concept epoch_reclaimed_control_block = std::derived_from<ControlBlockType, epoch_scoped_ptr_control_block>;
+
+class biased_scoped_ptr_control_block;
+
 namespace internal
 {
-    template<typename ElementType, typename ControlBlockType>
-    requires scoped_lock_control_block<ControlBlockType>
-    inline void release_strong_and_destroy(ControlBlockType* controlBlock, ElementType* element)
+    // Blocks owned by one thread whose shared count went negative on another thread. The
+    // owner merges them on its next release or collect_biased_scoped_ptrs(); once it has
+    // exited the releasing thread merges them itself.
+    struct biased_owner
     {
-        if(controlBlock == nullptr)
-            return;
+        std::mutex mutex;
+        std::vector<biased_scoped_ptr_control_block*> queued;
+        std::atomic<bool> pending{false};
+        bool exited{false};
+    };
+
+    class biased_owner_handle
+    {
+    private:
+        std::shared_ptr<biased_owner> _owner{std::make_shared<biased_owner>()};
+    public:
+        ~biased_owner_handle();
+    public:
+        [[nodiscard]] inline const std::shared_ptr<biased_owner>& owner() const noexcept
+        {
+            return _owner;
+        }
+    };
+
+    inline thread_local biased_owner_handle current_biased_owner;
+
+    inline void merge_biased_and_destroy(std::vector<biased_scoped_ptr_control_block*>& controlBlocks) noexcept;
+    inline void collect_biased_and_destroy(biased_owner& owner) noexcept;
+}
+
+// Biased reference counting: the thread that created the block counts its references with
+// plain loads and stores, every other thread uses an atomic shared count that may go negative
+// while the owner still holds biased references. When the owner's count drops to zero the two
+// are merged and all threads use the shared count from then on. A block whose shared count goes
+// negative before that is queued to the owner, who merges it, because only then can it tell
+// whether the element is gone. Suits elements mostly referenced by the thread that created them.
+class biased_scoped_ptr_control_block
+{
+    friend void internal::merge_biased_and_destroy(std::vector<biased_scoped_ptr_control_block*>& controlBlocks) noexcept;
+    friend class internal::biased_owner_handle;
+private:
+    // Low bits of the shared count, the count itself is stored in units of countUnit.
+    constexpr static int64_t merged = 1;
+    constexpr static int64_t queued = 2;
+    constexpr static int64_t countUnit = 4;
+private:
+    std::shared_ptr<internal::biased_owner> _owner{internal::current_biased_owner.owner()};
+    // Only written by the owner, or by the thread merging after the owner exited; lock() on
+    // other threads reads it while the block is queued.
+    std::atomic<size_t> _countBiased{1};
+    std::atomic<int64_t> _countShared{0};
+    std::atomic<size_t> _countWeak{1};
+    // Only accessed by the owner, or by the thread merging after the owner exited.
+    bool _merged{false};
+public:
+    // A queued block may already have lost its last reference while the owner's biased count
+    // still includes it, so lock() adds both counts up. Other threads read the owner's count
+    // while the shared one holds still under the CAS; the merge that decides destruction sees
+    // every reference taken here.
+    inline bool acquire() noexcept
+    {
+        if(owned())
+        {
+            const auto countBiased = _countBiased.load(std::memory_order_relaxed);
+            const auto countShared = _countShared.load(std::memory_order_acquire);
+            if((countShared & queued) != 0 && static_cast<int64_t>(countBiased) + (countShared >> 2) <= 0)
+                return false;
+
+            _countBiased.store(countBiased + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        int64_t countShared = _countShared.load(std::memory_order_relaxed);
+        do
+        {
+            if((countShared & merged) != 0)
+            {
+                if(countShared < countUnit)
+                    return false;
+            }
+            else if((countShared & queued) != 0)
+            {
+                const auto countBiased = static_cast<int64_t>(_countBiased.load(std::memory_order_relaxed));
+                if(countBiased + (countShared >> 2) <= 0)
+                    return false;
+            }
+        }
+        while(!_countShared.compare_exchange_weak(
+            countShared,
+            countShared + countUnit,
+            std::memory_order_acquire,
+            std::memory_order_relaxed
+            )
+        );
+
+        return true;
+    }
+    inline bool release() noexcept
+    {
+        if(owned())
+        {
+            const auto countBiased = _countBiased.load(std::memory_order_relaxed) - 1;
+            _countBiased.store(countBiased, std::memory_order_relaxed);
+            if(countBiased != 0)
+            {
+                if(_owner->pending.load(std::memory_order_relaxed))
+                    internal::collect_biased_and_destroy(*_owner);
+                return false;
+            }
+
+            // A queued block is left to the merge, which decides whether the element is gone.
+            _merged = true;
+            const auto countShared = _countShared.fetch_or(merged, std::memory_order_acq_rel);
+            return (countShared & queued) == 0 && countShared < countUnit;
+        }
+
+        int64_t countShared = _countShared.load(std::memory_order_relaxed);
+        int64_t next;
+        do
+        {
+            next = countShared - countUnit;
+            if((countShared & (merged | queued)) == 0 && next < 0)
+                next |= queued;
+        }
+        while(!_countShared.compare_exchange_weak(
+            countShared,
+            next,
+            std::memory_order_acq_rel,
+            std::memory_order_relaxed
+            )
+        );
+
+        if((next & queued) != 0 && (countShared & queued) == 0)
+            return enqueue();
+
+        return (next & (merged | queued)) == merged && next < countUnit;
+    }
+    inline void acquireWeak() noexcept
+    {
+        _countWeak.fetch_add(1, std::memory_order_relaxed);
+    }
+    inline bool releaseWeak() noexcept
+    {
+        return _countWeak.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+public:
+    // Exact on the owner thread, a snapshot elsewhere.
+    inline size_t useCount() noexcept
+    {
+        const auto countShared = _countShared.load(std::memory_order_relaxed) >> 2;
+        const auto countBiased = static_cast<int64_t>(_countBiased.load(std::memory_order_relaxed));
+        return static_cast<size_t>(std::max<int64_t>(countBiased + countShared, 0));
+    }
+private:
+    [[nodiscard]] inline bool owned() const noexcept
+    {
+        return _owner == internal::current_biased_owner.owner() && !_merged;
+    }
+    // Hands the block to its owner, or merges it right away when the owner has exited.
+    inline bool enqueue() noexcept
+    {
+        {
+            std::lock_guard lock(_owner->mutex);
+            if(!_owner->exited)
+            {
+                _owner->queued.push_back(this);
+                _owner->pending.store(true, std::memory_order_release);
+                return false;
+            }
+        }
 
-        const auto [deleteElement, deleteAll] = controlBlock->release();
+        return merge();
+    }
+    // Folds the biased count into the shared one; returns true when no reference is left.
+    inline bool merge() noexcept
+    {
+        const auto countBiased = static_cast<int64_t>(_countBiased.exchange(0, std::memory_order_relaxed));
+        _merged = true;
 
-        if(deleteElement)
+        int64_t countShared = _countShared.load(std::memory_order_relaxed);
+        int64_t next;
+        do
         {
-            delete element;
-            if(deleteAll)
-                delete controlBlock;
+            next = ((countShared >> 2) + countBiased) * countUnit | merged;
         }
+        while(!_countShared.compare_exchange_weak(
+            countShared,
+            next,
+            std::memory_order_acq_rel,
+            std::memory_order_relaxed
+            )
+        );
+
+        return next < countUnit;
     }
+};
 
+namespace internal
+{
+    struct scoped_block_pooling
+    {};
+}
+
+// Counts of ControlBlockType, but the control blocks scoped_source_ptr allocates for adopted
+// pointers come from a per-thread slab_pool instead of the heap. Blocks may be released on any
+// thread. Not available for biased blocks, whose merge relies on their exact block type.
+template<typename ControlBlockType = synchronized_scoped_ptr_control_block>
+requires scoped_lock_control_block<ControlBlockType> && (!std::derived_from<ControlBlockType, biased_scoped_ptr_control_block>)
+class pooled_scoped_ptr_control_block
+    : public ControlBlockType
+    , private internal::scoped_block_pooling
+{};
+
+template<typename ControlBlockType>
+concept pooled_control_block = std::is_base_of_v<internal::scoped_block_pooling, ControlBlockType>;
+
+// Merges the blocks other threads queued to the calling thread. Owners that rarely release
+// references should call this now and then, queued elements are only destroyed once merged.
+inline void collect_biased_scoped_ptrs() noexcept;
+
+namespace internal
+{
+    // Counts of one owned element together with how to destroy it and free the block.
+    template<typename ControlBlockType>
+    requires scoped_lock_control_block<ControlBlockType>
+    class scoped_block
+        : public ControlBlockType
+    {
+    public:
+        virtual ~scoped_block() = default;
+    public:
+        // Destroys the element, called once the last strong reference is gone.
+        virtual void dispose() noexcept = 0;
+        // Frees the block, called once the element is gone and the last weak reference too.
+        virtual void destroy() noexcept = 0;
+    };
+
+    // Block of an element allocated on its own, as handed to scoped_source_ptr.
     template<typename ElementType, typename ControlBlockType>
     requires scoped_lock_control_block<ControlBlockType>
-    inline void release_weak_and_destroy(ControlBlockType* controlBlock, ElementType* element)
+    class scoped_separate_block final
+        : public scoped_block<ControlBlockType>
+    {
+    private:
+        ElementType* _element;
+    public:
+        explicit scoped_separate_block(ElementType* element) noexcept
+            : _element(element)
+        {}
+    public:
+        static void* operator new(std::size_t size)
+        {
+            if constexpr(pooled_control_block<ControlBlockType>)
+                return slab_pool<poolSlotSize()>::allocate();
+            else
+                return ::operator new(size);
+        }
+        static void operator delete(void* block) noexcept
+        {
+            if constexpr(pooled_control_block<ControlBlockType>)
+                slab_pool<poolSlotSize()>::deallocate(block);
+            else
+                ::operator delete(block);
+        }
+    private:
+        // Blocks of every element type with the same layout share a pool.
+        constexpr static size_t poolSlotSize() noexcept
+        {
+            constexpr size_t alignment = alignof(std::max_align_t);
+            return (sizeof(scoped_separate_block) + alignment - 1) / alignment * alignment;
+        }
+    public:
+        void dispose() noexcept override
+        {
+            delete _element;
+        }
+        void destroy() noexcept override
+        {
+            delete this;
+        }
+    };
+
+    // Block with the element stored inline, one allocation for both as with std::make_shared.
+    template<typename ElementType, typename ControlBlockType, typename Allocator>
+    requires scoped_lock_control_block<ControlBlockType>
+    class scoped_inplace_block final
+        : public scoped_block<ControlBlockType>
+    {
+    public:
+        using value_type = std::remove_cv_t<ElementType>;
+        using block_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<scoped_inplace_block>;
+        using element_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<value_type>;
+    private:
+        [[no_unique_address]] block_allocator _allocator;
+        union
+        {
+            value_type _element;
+        };
+    public:
+        template<typename... Args>
+        explicit scoped_inplace_block(const block_allocator& allocator, Args&&... args)
+            : _allocator(allocator)
+        {
+            element_allocator elementAllocator(_allocator);
+            std::allocator_traits<element_allocator>::construct(elementAllocator, &_element, std::forward<Args>(args)...);
+        }
+        // The element is destroyed by dispose.
+        ~scoped_inplace_block() override
+        {}
+    public:
+        inline value_type* element() noexcept
+        {
+            return &_element;
+        }
+        void dispose() noexcept override
+        {
+            element_allocator elementAllocator(_allocator);
+            std::allocator_traits<element_allocator>::destroy(elementAllocator, &_element);
+        }
+        void destroy() noexcept override
+        {
+            block_allocator allocator(std::move(_allocator));
+            std::allocator_traits<block_allocator>::destroy(allocator, this);
+            std::allocator_traits<block_allocator>::deallocate(allocator, this, 1);
+        }
+    };
+
+    template<typename ControlBlockType>
+    requires scoped_lock_control_block<ControlBlockType>
+    inline void release_weak_and_destroy(scoped_block<ControlBlockType>* controlBlock) noexcept
     {
         if(controlBlock == nullptr)
             return;
@@ -92,10 +454,89 @@ namespace internal
         if(!controlBlock->releaseWeak())
             return;
 
-        delete controlBlock;
+        controlBlock->destroy();
+    }
+
+    template<typename ControlBlockType>
+    requires scoped_lock_control_block<ControlBlockType>
+    inline void release_strong_and_destroy(scoped_block<ControlBlockType>* controlBlock) noexcept
+    {
+        if(controlBlock == nullptr)
+            return;
+
+        if(!controlBlock->release())
+            return;
+
+        if constexpr(epoch_reclaimed_control_block<ControlBlockType>)
+        {
+            // Out of memory the block is leaked, a guard may still be reading the element.
+            try
+            {
+                epoch_reclamation::retire(controlBlock, [](void* object) noexcept {
+                    auto* block = static_cast<scoped_block<ControlBlockType>*>(object);
+                    block->dispose();
+                    release_weak_and_destroy(block);
+                });
+            }
+            catch (const std::bad_alloc&)
+            {
+            }
+            return;
+        }
+
+        controlBlock->dispose();
+        release_weak_and_destroy(controlBlock);
     }
 }
 
+namespace internal
+{
+    // Every biased block is the base of a scoped_block, which knows how to destroy it.
+    inline void merge_biased_and_destroy(std::vector<biased_scoped_ptr_control_block*>& controlBlocks) noexcept
+    {
+        for(auto* controlBlock : controlBlocks)
+        {
+            if(!controlBlock->merge())
+                continue;
+
+            auto* block = static_cast<scoped_block<biased_scoped_ptr_control_block>*>(controlBlock);
+            block->dispose();
+            release_weak_and_destroy(block);
+        }
+    }
+
+    inline void collect_biased_and_destroy(biased_owner& owner) noexcept
+    {
+        std::vector<biased_scoped_ptr_control_block*> controlBlocks;
+        {
+            std::lock_guard lock(owner.mutex);
+            controlBlocks.swap(owner.queued);
+            owner.pending.store(false, std::memory_order_relaxed);
+        }
+
+        merge_biased_and_destroy(controlBlocks);
+    }
+
+    inline biased_owner_handle::~biased_owner_handle()
+    {
+        std::vector<biased_scoped_ptr_control_block*> controlBlocks;
+        {
+            std::lock_guard lock(_owner->mutex);
+            _owner->exited = true;
+            controlBlocks.swap(_owner->queued);
+        }
+
+        merge_biased_and_destroy(controlBlocks);
+    }
+}
+
+inline void collect_biased_scoped_ptrs() noexcept
+{
+    const auto& owner = internal::current_biased_owner.owner();
+    if(owner->pending.load(std::memory_order_acquire))
+        internal::collect_biased_and_destroy(*owner);
+}
+
 template<typename ElementType, typename ControlBlockType = synchronized_scoped_ptr_control_block>
 requires scoped_lock_control_block<ControlBlockType>
 class scoped_source_ptr;
@@ -106,36 +547,65 @@ template<typename ElementType, typename ControlBlockType = synchronized_scoped_p
 requires scoped_lock_control_block<ControlBlockType>
 class scoped_ptr;
 
+template<typename ElementType, typename ControlBlockType = synchronized_scoped_ptr_control_block, typename Allocator, typename... Args>
+requires scoped_lock_control_block<ControlBlockType>
+scoped_source_ptr<ElementType, ControlBlockType> allocate_scoped(const Allocator& allocator, Args&&... args);
+
 template<typename ElementType, typename ControlBlockType>
 requires scoped_lock_control_block<ControlBlockType>
 class scoped_source_ptr
 {
+    template<typename OtherElementType, typename OtherControlBlockType, typename Allocator, typename... Args>
+    requires scoped_lock_control_block<OtherControlBlockType>
+    friend scoped_source_ptr<OtherElementType, OtherControlBlockType> allocate_scoped(const Allocator& allocator, Args&&... args);
 public:
     using control_block_type = ControlBlockType;
     using element_type = ElementType;
     using weak_type = scoped_weak_ptr<element_type, control_block_type>;
     using strong_type = scoped_ptr<element_type, control_block_type>;
+private:
+    using block_type = internal::scoped_block<control_block_type>;
 private:
     element_type* _element{};
-    control_block_type* _controlBlock{};
+    block_type* _controlBlock{};
 public:
     constexpr scoped_source_ptr() noexcept = default;
     constexpr scoped_source_ptr(std::nullptr_t) noexcept
         : scoped_source_ptr()
     {}
+    // Allocates the control block separately, make_scoped allocates both at once. The element
+    // is deleted if that allocation throws, as with std::shared_ptr.
     explicit scoped_source_ptr(element_type* element)
         : _element(element)
-        , _controlBlock(element != nullptr ? new control_block_type{} : nullptr)
+        , _controlBlock(adopt(element))
     {}
     scoped_source_ptr(const scoped_source_ptr& other) = delete;
-    constexpr scoped_source_ptr(scoped_source_ptr&& other) noexcept = default;
+    constexpr scoped_source_ptr(scoped_source_ptr&& other) noexcept
+        : _element(std::exchange(other._element, nullptr))
+        , _controlBlock(std::exchange(other._controlBlock, nullptr))
+    {}
+private:
+    scoped_source_ptr(element_type* element, block_type* controlBlock) noexcept
+        : _element(element)
+        , _controlBlock(controlBlock)
+    {}
 public:
     scoped_source_ptr& operator=(const scoped_source_ptr& other) = delete;
-    scoped_source_ptr& operator=(scoped_source_ptr&& other) noexcept = default;
+    scoped_source_ptr& operator=(scoped_source_ptr&& other) noexcept
+    {
+        if(&other == this)
+            return *this;
+
+        internal::release_strong_and_destroy(_controlBlock);
+        _element = std::exchange(other._element, nullptr);
+        _controlBlock = std::exchange(other._controlBlock, nullptr);
+
+        return *this;
+    }
 public:
     ~scoped_source_ptr()
     {
-        internal::release_strong_and_destroy(_controlBlock, _element);
+        internal::release_strong_and_destroy(_controlBlock);
     }
 public:
     inline size_t useCount() noexcept
@@ -144,13 +614,31 @@ public:
             return _controlBlock->useCount();
         return 0;
     }
-    inline void reset(element_type* element = nullptr) noexcept
+    inline void reset() noexcept
     {
-        internal::release_strong_and_destroy(_controlBlock, _element);
+        internal::release_strong_and_destroy(_controlBlock);
+        _element = nullptr;
         _controlBlock = nullptr;
-
+    }
+    // Leaves the current element untouched, and deletes the new one, if allocating its
+    // control block throws.
+    inline void reset(element_type* element)
+    {
+        auto* controlBlock = adopt(element);
+        internal::release_strong_and_destroy(_controlBlock);
         _element = element;
-        _controlBlock = element != nullptr ? new control_block_type{} : nullptr;
+        _controlBlock = controlBlock;
+    }
+private:
+    static block_type* adopt(element_type* element)
+    {
+        if(element == nullptr)
+            return nullptr;
+
+        std::unique_ptr<element_type> owned(element);
+        auto* controlBlock = new internal::scoped_separate_block<element_type, control_block_type>(element);
+        owned.release();
+        return controlBlock;
     }
 public:
     inline element_type* get() const noexcept
@@ -187,22 +675,28 @@ public:
     using element_type = ElementType;
     using weak_type = scoped_weak_ptr<element_type, control_block_type>;
     using strong_type = scoped_ptr<element_type, control_block_type>;
+private:
+    using block_type = internal::scoped_block<control_block_type>;
 private:
     element_type* _element{};
-    control_block_type* _controlBlock{};
+    block_type* _controlBlock{};
 public:
     constexpr scoped_weak_ptr() noexcept = default;
     constexpr scoped_weak_ptr(const scoped_weak_ptr& other) noexcept
     {
-        if(other._controlBlock != nullptr && other._controlBlock.acquire_weak())
+        if(other._controlBlock != nullptr)
         {
+            other._controlBlock->acquireWeak();
             _controlBlock = other._controlBlock;
             _element = other._element;
         }
     }
-    constexpr scoped_weak_ptr(scoped_weak_ptr&& other) noexcept = default;
+    constexpr scoped_weak_ptr(scoped_weak_ptr&& other) noexcept
+        : _element(std::exchange(other._element, nullptr))
+        , _controlBlock(std::exchange(other._controlBlock, nullptr))
+    {}
 private:
-    scoped_weak_ptr(element_type* element, control_block_type* control_block)
+    scoped_weak_ptr(element_type* element, block_type* control_block)
         : _element(element)
           , _controlBlock(control_block)
     {}
@@ -213,19 +707,30 @@ public:
             return *this;
 
         reset();
-        if(other._controlBlock != nullptr && other._controlBlock.acquire_weak())
+        if(other._controlBlock != nullptr)
         {
+            other._controlBlock->acquireWeak();
             _controlBlock = other._controlBlock;
             _element = other._element;
         }
 
         return *this;
     }
-    scoped_weak_ptr& operator=(scoped_weak_ptr&& other) noexcept = default;
+    scoped_weak_ptr& operator=(scoped_weak_ptr&& other) noexcept
+    {
+        if(&other == this)
+            return *this;
+
+        reset();
+        _element = std::exchange(other._element, nullptr);
+        _controlBlock = std::exchange(other._controlBlock, nullptr);
+
+        return *this;
+    }
 public:
     ~scoped_weak_ptr()
     {
-        internal::release_weak_and_destroy(_controlBlock, _element);
+        internal::release_weak_and_destroy(_controlBlock);
     }
 public:
     inline size_t useCount() noexcept
@@ -236,10 +741,19 @@ public:
     }
     inline void reset() noexcept
     {
-        internal::release_weak_and_destroy(_controlBlock, _element);
+        internal::release_weak_and_destroy(_controlBlock);
         _controlBlock = nullptr;
     }
     inline strong_type lock() noexcept;
+    // The element if it is still alive, without touching the counts. The pointer stays valid
+    // until the calling thread leaves its current epoch_guard.
+    inline element_type* peek() const noexcept
+    requires epoch_reclaimed_control_block<control_block_type>
+    {
+        if(_controlBlock == nullptr || _controlBlock->useCount() == 0)
+            return nullptr;
+        return _element;
+    }
 };
 
 template<typename ElementType, typename ControlBlockType>
@@ -253,25 +767,40 @@ public:
     using element_type = ElementType;
     using weak_type = scoped_weak_ptr<element_type, control_block_type>;
     using strong_type = scoped_ptr<element_type, control_block_type>;
+private:
+    using block_type = internal::scoped_block<control_block_type>;
 private:
     element_type* _element{};
-    control_block_type* _controlBlock{};
+    block_type* _controlBlock{};
 public:
     constexpr scoped_ptr() noexcept = default;
     constexpr scoped_ptr(const scoped_ptr& other) = delete;
-    constexpr scoped_ptr(scoped_ptr&& other) noexcept = default;
+    constexpr scoped_ptr(scoped_ptr&& other) noexcept
+        : _element(std::exchange(other._element, nullptr))
+        , _controlBlock(std::exchange(other._controlBlock, nullptr))
+    {}
 private:
-    scoped_ptr(element_type* element, control_block_type* control_block)
+    scoped_ptr(element_type* element, block_type* control_block)
         : _element(element)
           , _controlBlock(control_block)
     {}
 public:
     scoped_ptr& operator=(const scoped_ptr& other) = delete;
-    scoped_ptr& operator=(scoped_ptr&& other) noexcept = default;
+    scoped_ptr& operator=(scoped_ptr&& other) noexcept
+    {
+        if(&other == this)
+            return *this;
+
+        reset();
+        _element = std::exchange(other._element, nullptr);
+        _controlBlock = std::exchange(other._controlBlock, nullptr);
+
+        return *this;
+    }
 public:
     ~scoped_ptr()
     {
-        internal::release_strong_and_destroy(_controlBlock, _element);
+        internal::release_strong_and_destroy(_controlBlock);
     }
 public:
     inline size_t useCount() noexcept
@@ -282,7 +811,7 @@ public:
     }
     inline void reset() noexcept
     {
-        internal::release_strong_and_destroy(_controlBlock, _element);
+        internal::release_strong_and_destroy(_controlBlock);
         _controlBlock = nullptr;
     }
     constexpr element_type* get() const noexcept
@@ -344,3 +873,35 @@ scoped_weak_ptr<ElementType, ControlBlockType>::lock() noexcept
 
     return {_element, _controlBlock};
 }
+
+// Constructs the element inside its control block with a single allocation from `allocator`.
+// The memory stays allocated until the last weak reference is gone.
+template<typename ElementType, typename ControlBlockType, typename Allocator, typename... Args>
+requires scoped_lock_control_block<ControlBlockType>
+scoped_source_ptr<ElementType, ControlBlockType> allocate_scoped(const Allocator& allocator, Args&&... args)
+{
+    using block_type = internal::scoped_inplace_block<ElementType, ControlBlockType, Allocator>;
+    using block_allocator = typename block_type::block_allocator;
+    using block_traits = std::allocator_traits<block_allocator>;
+
+    block_allocator blockAllocator(allocator);
+    auto* controlBlock = block_traits::allocate(blockAllocator, 1);
+    try
+    {
+        block_traits::construct(blockAllocator, controlBlock, blockAllocator, std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+        block_traits::deallocate(blockAllocator, controlBlock, 1);
+        throw;
+    }
+
+    return {controlBlock->element(), controlBlock};
+}
+
+template<typename ElementType, typename ControlBlockType = synchronized_scoped_ptr_control_block, typename... Args>
+requires scoped_lock_control_block<ControlBlockType>
+scoped_source_ptr<ElementType, ControlBlockType> make_scoped(Args&&... args)
+{
+    return allocate_scoped<ElementType, ControlBlockType>(std::allocator<std::remove_cv_t<ElementType>>{}, std::forward<Args>(args)...);
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <core/common.hpp>
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CORE_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// Kernels for one instruction set are compiled with these attributes and only called after
+// active_simd_level() confirmed support, so the rest of the build keeps its baseline target.
+// MSVC accepts the intrinsics without them.
+#if defined(__GNUC__) || defined(__clang__)
+#define CORE_TARGET_AVX2 __attribute__((target("avx2,f16c,fma")))
+#define CORE_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512vl,avx2,f16c,fma")))
+#else
+#define CORE_TARGET_AVX2
+#define CORE_TARGET_AVX512
+#endif
+
+namespace CORE_NAMESPACE
+{
+// Instruction sets in increasing order. avx2 includes F16C and FMA, avx512 the F, BW and VL subsets.
+enum class simd_level
+{
+    scalar,
+    avx2,
+    avx512
+};
+
+namespace internal
+{
+#if defined(CORE_SIMD_X86)
+    struct cpuid_registers
+    {
+        uint32_t eax, ebx, ecx, edx;
+    };
+
+    inline cpuid_registers cpuid(uint32_t leaf, uint32_t subleaf) noexcept
+    {
+        cpuid_registers registers{};
+#if defined(_MSC_VER) && !defined(__clang__)
+        int values[4];
+        __cpuidex(values, static_cast<int>(leaf), static_cast<int>(subleaf));
+        registers = {static_cast<uint32_t>(values[0]), static_cast<uint32_t>(values[1]), static_cast<uint32_t>(values[2]), static_cast<uint32_t>(values[3])};
+#else
+        __cpuid_count(leaf, subleaf, registers.eax, registers.ebx, registers.ecx, registers.edx);
+#endif
+        return registers;
+    }
+
+#if defined(__GNUC__) || defined(__clang__)
+    __attribute__((target("xsave")))
+#endif
+    inline uint64_t extended_control_register() noexcept
+    {
+        return _xgetbv(0);
+    }
+#endif
+
+    inline simd_level detect_simd_level() noexcept
+    {
+#if defined(CORE_SIMD_X86)
+        constexpr auto bit = [](uint32_t value, int index){ return ((value >> index) & 1u) != 0; };
+
+        if(cpuid(0, 0).eax < 7)
+            return simd_level::scalar;
+
+        const auto features = cpuid(1, 0);
+        // The OS must save the vector registers, which it announces through OSXSAVE and XCR0.
+        if(!bit(features.ecx, 27) || !bit(features.ecx, 28) || !bit(features.ecx, 29) || !bit(features.ecx, 12))
+            return simd_level::scalar;
+
+        const auto enabledState = extended_control_register();
+        const auto extendedFeatures = cpuid(7, 0);
+        if((enabledState & 0x6) != 0x6 || !bit(extendedFeatures.ebx, 5))
+            return simd_level::scalar;
+
+        if((enabledState & 0xe0) == 0xe0 && bit(extendedFeatures.ebx, 16) && bit(extendedFeatures.ebx, 30) && bit(extendedFeatures.ebx, 31))
+            return simd_level::avx512;
+
+        return simd_level::avx2;
+#else
+        return simd_level::scalar;
+#endif
+    }
+
+    inline std::atomic<simd_level> simd_level_limit{simd_level::avx512};
+}
+
+// What the processor and operating system support, detected once.
+inline simd_level supported_simd_level() noexcept
+{
+    static const auto level = internal::detect_simd_level();
+    return level;
+}
+
+// The level kernels dispatch to: the supported one unless limited further.
+inline simd_level active_simd_level() noexcept
+{
+    return std::min(supported_simd_level(), internal::simd_level_limit.load(std::memory_order_relaxed));
+}
+
+// Caps dispatch at `level`, to compare kernels or to avoid AVX-512 clock penalties.
+inline void limit_simd_level(simd_level level) noexcept
+{
+    internal::simd_level_limit.store(level, std::memory_order_relaxed);
+}
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Fixed-size slots carved out of 64 KiB slabs, each owned by the thread that created it.
+// Allocation and frees by the owner are plain list operations. Other threads push the slots
+// they free onto the slab's lock-free remote list, which the owner takes over as a whole once
+// its local list runs dry. Slabs are aligned to their size, so a slot finds its slab by masking
+// its address. When the owner exits, its slabs are freed as soon as their last slot comes back.
+template<size_t SlotSize>
+class slab_pool
+{
+    static_assert(SlotSize >= sizeof(void*) && SlotSize % alignof(std::max_align_t) == 0);
+public:
+    constexpr static size_t slabSize = 64 * 1024;
+    constexpr static size_t slotSize = SlotSize;
+private:
+    struct free_slot
+    {
+        free_slot* next;
+    };
+
+    class thread_cache;
+
+    struct slab
+    {
+        // Null once the owner exited.
+        std::atomic<thread_cache*> owner;
+        std::atomic<free_slot*> remoteFree{nullptr};
+        // Slots still held elsewhere after the owner exited, the thread returning the last one frees the slab.
+        std::atomic<int64_t> outstanding{0};
+        // Only accessed by the owner.
+        free_slot* localFree{nullptr};
+        size_t untouched{0};
+        size_t allocated{0};
+
+        explicit slab(thread_cache* cache) noexcept
+            : owner(cache)
+        {}
+
+        static slab* create(thread_cache* cache);
+        static void destroy(slab* instance) noexcept;
+        [[nodiscard]] static inline slab* of(void* slot) noexcept
+        {
+            return reinterpret_cast<slab*>(reinterpret_cast<uintptr_t>(slot) & ~uintptr_t{slabSize - 1});
+        }
+
+        void* tryAllocate() noexcept;
+        void freeLocal(void* slot) noexcept;
+        void freeRemote(void* slot) noexcept;
+        void abandon() noexcept;
+    };
+
+    class thread_cache
+    {
+    private:
+        std::vector<slab*> _slabs;
+        slab* _current{};
+    public:
+        thread_cache() noexcept;
+        thread_cache(const thread_cache& other) = delete;
+        thread_cache& operator=(const thread_cache& other) = delete;
+        ~thread_cache();
+    public:
+        void* allocate();
+    };
+private:
+    constexpr static size_t firstSlotOffset = (sizeof(slab) + SlotSize - 1) / SlotSize * SlotSize;
+    constexpr static size_t slotCount = (slabSize - firstSlotOffset) / SlotSize;
+
+    // Plain pointers, so they remain readable while the thread's cache is being destroyed.
+    inline static thread_local thread_cache* _local = nullptr;
+    inline static thread_local bool _exited = false;
+public:
+    [[nodiscard]] static void* allocate();
+    static void deallocate(void* slot) noexcept;
+private:
+    [[nodiscard]] static inline free_slot* abandonedMark() noexcept
+    {
+        return reinterpret_cast<free_slot*>(uintptr_t{1});
+    }
+};
+
+template<size_t SlotSize>
+typename slab_pool<SlotSize>::slab* slab_pool<SlotSize>::slab::create(thread_cache* cache)
+{
+    void* memory = ::operator new(slabSize, std::align_val_t{slabSize});
+    return new(memory) slab(cache);
+}
+
+template<size_t SlotSize>
+void slab_pool<SlotSize>::slab::destroy(slab* instance) noexcept
+{
+    instance->~slab();
+    ::operator delete(static_cast<void*>(instance), std::align_val_t{slabSize});
+}
+
+template<size_t SlotSize>
+void* slab_pool<SlotSize>::slab::tryAllocate() noexcept
+{
+    if(localFree == nullptr)
+    {
+        localFree = remoteFree.exchange(nullptr, std::memory_order_acquire);
+        for(auto* slot = localFree; slot != nullptr; slot = slot->next)
+            --allocated;
+    }
+
+    if(localFree != nullptr)
+    {
+        ++allocated;
+        return std::exchange(localFree, localFree->next);
+    }
+
+    if(untouched == slotCount)
+        return nullptr;
+
+    ++allocated;
+    return reinterpret_cast<std::byte*>(this) + firstSlotOffset + untouched++ * SlotSize;
+}
+
+template<size_t SlotSize>
+void slab_pool<SlotSize>::slab::freeLocal(void* slot) noexcept
+{
+    localFree = new(slot) free_slot{localFree};
+    --allocated;
+}
+
+template<size_t SlotSize>
+void slab_pool<SlotSize>::slab::freeRemote(void* slot) noexcept
+{
+    auto* node = new(slot) free_slot{};
+    auto* head = remoteFree.load(std::memory_order_relaxed);
+    do
+    {
+        if(head == abandonedMark())
+        {
+            if(outstanding.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                destroy(this);
+            return;
+        }
+        node->next = head;
+    }
+    while(!remoteFree.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+}
+
+template<size_t SlotSize>
+void slab_pool<SlotSize>::slab::abandon() noexcept
+{
+    owner.store(nullptr, std::memory_order_release);
+
+    // Slots freed remotely from here on only decrement outstanding, which may briefly go negative.
+    auto* returned = remoteFree.exchange(abandonedMark(), std::memory_order_acquire);
+    for(; returned != nullptr; returned = returned->next)
+        --allocated;
+
+    const auto remaining = static_cast<int64_t>(allocated);
+    if(outstanding.fetch_add(remaining, std::memory_order_acq_rel) + remaining == 0)
+        destroy(this);
+}
+
+template<size_t SlotSize>
+slab_pool<SlotSize>::thread_cache::thread_cache() noexcept
+{
+    _local = this;
+}
+
+template<size_t SlotSize>
+slab_pool<SlotSize>::thread_cache::~thread_cache()
+{
+    _local = nullptr;
+    _exited = true;
+    for(auto* instance : _slabs)
+        instance->abandon();
+}
+
+template<size_t SlotSize>
+void* slab_pool<SlotSize>::thread_cache::allocate()
+{
+    if(_current != nullptr)
+    {
+        if(auto* slot = _current->tryAllocate())
+            return slot;
+    }
+
+    // Once per filled slab: reuse the first one that got slots back before growing.
+    for(auto* instance : _slabs)
+    {
+        if(instance == _current)
+            continue;
+
+        if(auto* slot = instance->tryAllocate())
+        {
+            _current = instance;
+            return slot;
+        }
+    }
+
+    _slabs.reserve(_slabs.size() + 1);
+    _current = slab::create(this);
+    _slabs.push_back(_current);
+    return _current->tryAllocate();
+}
+
+template<size_t SlotSize>
+void* slab_pool<SlotSize>::allocate()
+{
+    // During thread teardown the cache may already be gone; such a slot gets a slab of its own.
+    if(_exited)
+    {
+        auto* instance = slab::create(nullptr);
+        auto* slot = instance->tryAllocate();
+        instance->abandon();
+        return slot;
+    }
+
+    thread_local thread_cache cache;
+    return cache.allocate();
+}
+
+template<size_t SlotSize>
+void slab_pool<SlotSize>::deallocate(void* slot) noexcept
+{
+    auto* instance = slab::of(slot);
+    if(_local != nullptr && instance->owner.load(std::memory_order_acquire) == _local)
+        instance->freeLocal(slot);
+    else
+        instance->freeRemote(slot);
+}
@@ -1,98 +1,271 @@
 #pragma once
 
 #include <cstdint>
+#include <cstddef>
+#include <atomic>
 #include <bit>
 #include <string_view>
 #include <array>
-#include <tuple>
+#include <type_traits>
+#include <limits>
 
 class type_index
 {
     friend class type_manager;
 
-    std::uintptr_t _index;
+    std::uint32_t _index;
 
-    constexpr explicit type_index(std::uintptr_t index)
+    constexpr explicit type_index(std::uint32_t index)
         : _index(index)
     {}
+public:
+    // Dense position of the type, suitable as an array index.
+    [[nodiscard]] constexpr size_t value() const noexcept
+    {
+        return _index;
+    }
+    constexpr auto operator<=>(const type_index& other) const noexcept = default;
 };
 
+// Hands out indices 0, 1, 2, ... in order of first use, shared by every type_manager of the
+// process, so component and type-erased storage can be looked up by indexing a table.
+// cv-qualifiers and references are ignored.
 class type_manager
 {
+private:
+    inline static std::atomic<std::uint32_t> _typeCount{0};
 public:
     template<typename T>
-    [[nodiscard]] constexpr type_index type_id() const
+    [[nodiscard]] type_index type_id() const noexcept
+    {
+        return index_of<std::remove_cvref_t<T>>();
+    }
+    // Indices handed out so far, every type_id seen yet is below this.
+    [[nodiscard]] size_t type_count() const noexcept
+    {
+        return _typeCount.load(std::memory_order_acquire);
+    }
+private:
+    template<typename T>
+    [[nodiscard]] static type_index index_of() noexcept
     {
-        constexpr static struct {} _marker;
-        return type_index{std::bit_cast<std::uintptr_t>(&_marker)};
+        static const type_index index{_typeCount.fetch_add(1, std::memory_order_acq_rel)};
+        return index;
     }
 };
 
-class type_name_resolver
+namespace internal
 {
-private:
-public:
+    // The type's name as spelled in the compiler's signature of this function.
     template<typename T>
-    constexpr auto resolve_name() const
+    constexpr std::string_view signature_type_name() noexcept
     {
-        using namespace std;
+#if defined(_MSC_VER)
+        constexpr std::string_view signature = __FUNCSIG__;
+        constexpr std::string_view prefix = "signature_type_name<";
+        constexpr auto first = signature.find(prefix) + prefix.size();
+        constexpr auto last = signature.rfind('>');
+#else
+        // GCC: "... [with T = int; std::string_view = ...]", Clang: "... [T = int]".
+        constexpr std::string_view signature = __PRETTY_FUNCTION__;
+        constexpr std::string_view prefix = "T = ";
+        constexpr auto first = signature.find(prefix) + prefix.size();
+        constexpr auto last = signature.find(';', first) != std::string_view::npos ? signature.find(';', first) : signature.rfind(']');
+#endif
+        return signature.substr(first, last - first);
+    }
 
-        constexpr string_view functionName = __FUNCSIG__;
+    constexpr bool is_identifier_character(char c) noexcept
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
 
-        constexpr auto first = functionName.find_first_of('<') + 1;
-        constexpr auto last = functionName.find_last_of('>') - 1;
-        constexpr auto typeName = functionName.substr(first, last - first + 1);
+    template<size_t Capacity>
+    struct type_name_buffer
+    {
+        std::array<char, Capacity> characters{};
+        size_t length{};
+    };
 
-        constexpr auto clearedTypeNameAndLength = [&](){
-            using namespace std;
-            constexpr auto typeNameLength = size(typeName);
+    // Drops MSVC's class/struct/enum keywords, keeps a space only between two identifiers,
+    // as in "unsigned int", and puts one after every comma, so that the compilers agree on
+    // the spelling of most types.
+    template<typename T>
+    constexpr auto format_type_name() noexcept
+    {
+        constexpr auto typeName = signature_type_name<T>();
 
-            array<char, typeNameLength + 1> clearedTypeName{};
+        type_name_buffer<typeName.size() * 2 + 1> formattedTypeName{};
+        auto& characters = formattedTypeName.characters;
+        auto& length = formattedTypeName.length;
 
-            size_t srcI = 0;
-            size_t dstI = 0;
-            while(srcI < typeNameLength)
+        size_t index = 0;
+        while(index < typeName.size())
+        {
+            const auto rest = typeName.substr(index);
+            const bool tokenStart = index == 0 || !is_identifier_character(typeName[index - 1]);
+            if(tokenStart)
             {
-                const auto offsetTypeName = typeName.substr(srcI);
-                if (offsetTypeName.starts_with("class ") || offsetTypeName.starts_with("struct "))
+                bool keyword = false;
+                for(const std::string_view prefix : {"class ", "struct ", "enum "})
                 {
-                    srcI += 6;
-                    continue;
+                    if(rest.starts_with(prefix))
+                    {
+                        index += prefix.size();
+                        keyword = true;
+                        break;
+                    }
                 }
-
-                if(typeName[srcI] == ' ')
-                {
-                    ++srcI;
+                if(keyword)
                     continue;
-                }
+            }
 
-                clearedTypeName[dstI++] = typeName[srcI++];
+            const auto c = typeName[index++];
+            if(c == ' ')
+            {
+                if(length != 0 && is_identifier_character(characters[length - 1])
+                    && index < typeName.size() && is_identifier_character(typeName[index]))
+                    characters[length++] = ' ';
+                continue;
             }
-            clearedTypeName[dstI] = '\0';
 
-            return std::make_tuple(clearedTypeName, dstI);
-        }();
-        constexpr static auto formattedTypeName = [&](){
-            using namespace std;
-            constexpr auto typeNameLength = size(typeName);
+            characters[length++] = c;
+            if(c == ',')
+                characters[length++] = ' ';
+        }
+        characters[length] = '\0';
 
-            array<char, typeNameLength * 2 + 1> formattedTypeName{};
+        return formattedTypeName;
+    }
 
-            size_t srcI = 0;
-            size_t dstI = 0;
-            while(srcI < get<1>(clearedTypeNameAndLength))
-            {
-                const auto c = get<0>(clearedTypeNameAndLength)[srcI++];
+    template<typename T>
+    inline constexpr auto formatted_type_name = format_type_name<T>();
 
-                formattedTypeName[dstI++] = c;
-                if(c == ',')
-                    formattedTypeName[dstI++] = ' ';
-            }
-            formattedTypeName[dstI] = '\0';
+    constexpr std::uint64_t fnv1a_64(std::string_view text) noexcept
+    {
+        std::uint64_t hash = 0xcbf29ce484222325ull;
+        for(const auto c : text)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
 
-            return formattedTypeName;
-        }();
+    // splitmix64 finalizer, spreads FNV's weak low bits before they pick a slot.
+    constexpr std::uint64_t mix_64(std::uint64_t value) noexcept
+    {
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+        return value ^ (value >> 31);
+    }
+
+    constexpr size_t perfect_hash_slot(std::uint64_t hash, std::uint64_t seed, size_t slotCount) noexcept
+    {
+        return static_cast<size_t>(mix_64(hash ^ seed)) & (slotCount - 1);
+    }
+}
+
+class type_name_resolver
+{
+public:
+    template<typename T>
+    constexpr std::string_view resolve_name() const noexcept
+    {
+        const auto& formattedTypeName = internal::formatted_type_name<T>;
+        return {formattedTypeName.characters.data(), formattedTypeName.length};
+    }
+    // FNV-1a of resolve_name, the same in every process and build made with the same compiler
+    // and standard library, so it can tag types in snapshots and network messages.
+    template<typename T>
+    constexpr std::uint64_t resolve_hash() const noexcept
+    {
+        return internal::fnv1a_64(resolve_name<T>());
+    }
+};
 
-        return string_view {formattedTypeName.data()};
+// Compile-time table of the types a snapshot or message format may contain. Hashes from
+// type_name_resolver::resolve_hash are found through a perfect hash built at compile time: one
+// mixed lookup and a single integer compare, no string compares.
+template<typename... Types>
+class type_name_table
+{
+public:
+    struct entry
+    {
+        std::uint64_t hash;
+        std::string_view name;
+        // Position of the type in Types.
+        size_t index;
+    };
+    constexpr static size_t size = sizeof...(Types);
+private:
+    struct layout
+    {
+        std::uint64_t seed;
+        size_t slotCount;
+    };
+    constexpr static size_t notFound = std::numeric_limits<size_t>::max();
+    constexpr static std::array<entry, size> _entries = []{
+        constexpr type_name_resolver resolver;
+        size_t index = 0;
+        return std::array<entry, size>{entry{resolver.resolve_hash<Types>(), resolver.resolve_name<Types>(), index++}...};
+    }();
+    static_assert([]{
+        for(size_t first = 0; first < size; ++first)
+            for(size_t second = first + 1; second < size; ++second)
+                if(_entries[first].hash == _entries[second].hash)
+                    return false;
+        return true;
+    }(), "type_name_table: two types share a name hash");
+    constexpr static size_t minSlotCount = std::bit_ceil(size * 2 + 1);
+    constexpr static size_t maxSlotCount = minSlotCount * 8;
+    // The smallest table, and the first seed for it, that places every hash in a slot of its own.
+    constexpr static layout _layout = []{
+        for(size_t slotCount = minSlotCount; slotCount <= maxSlotCount; slotCount *= 2)
+        {
+            for(std::uint64_t seed = 0; seed < 256; ++seed)
+            {
+                std::array<bool, maxSlotCount> used{};
+                bool collision = false;
+                for(const auto& typeEntry : _entries)
+                {
+                    auto& slotUsed = used[internal::perfect_hash_slot(typeEntry.hash, seed, slotCount)];
+                    collision = collision || slotUsed;
+                    slotUsed = true;
+                }
+                if(!collision)
+                    return layout{seed, slotCount};
+            }
+        }
+        return layout{0, 0};
+    }();
+    static_assert(_layout.slotCount != 0, "type_name_table: no collision-free layout found");
+    constexpr static auto _slots = []{
+        std::array<size_t, _layout.slotCount> slots{};
+        slots.fill(notFound);
+        for(const auto& typeEntry : _entries)
+            slots[internal::perfect_hash_slot(typeEntry.hash, _layout.seed, _layout.slotCount)] = typeEntry.index;
+        return slots;
+    }();
+public:
+    // The entry of the type with this hash, nullptr for types outside the table.
+    [[nodiscard]] constexpr static const entry* find(std::uint64_t hash) noexcept
+    {
+        const auto index = _slots[internal::perfect_hash_slot(hash, _layout.seed, _layout.slotCount)];
+        if(index == notFound || _entries[index].hash != hash)
+            return nullptr;
+        return &_entries[index];
+    }
+    [[nodiscard]] constexpr static const std::array<entry, size>& entries() noexcept
+    {
+        return _entries;
+    }
+    template<typename T>
+    [[nodiscard]] constexpr static const entry& entry_of() noexcept
+    {
+        constexpr auto hash = type_name_resolver{}.resolve_hash<T>();
+        static_assert(find(hash) != nullptr, "type_name_table: type is not part of the table");
+        return *find(hash);
     }
 };
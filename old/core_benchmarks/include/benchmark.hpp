@@ -0,0 +1,75 @@
+#pragma once
+
+#include <algorithm>
+#include <barrier>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <print>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Best of `runCount` runs, reported per operation. Each run performs `operationCount` operations.
+template<typename FunctionType>
+double measure(std::string_view name, size_t operationCount, FunctionType&& function, size_t runCount = 5)
+{
+    using nanoseconds = std::chrono::duration<double, std::nano>;
+
+    auto best = nanoseconds::max();
+    for(size_t run = 0; run < runCount; ++run)
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        function();
+        const auto end = std::chrono::high_resolution_clock::now();
+        best = std::min(best, std::chrono::duration_cast<nanoseconds>(end - start));
+    }
+
+    const auto perOperation = best.count() / static_cast<double>(operationCount);
+    std::print("  {:<48} {:>10.2f} ns/op\n", name, perOperation);
+    return perOperation;
+}
+
+// Keeps the optimizer from discarding a computed value: a volatile read forces it into memory.
+template<typename T>
+inline void do_not_optimize(const T& value)
+{
+    static_cast<void>(*reinterpret_cast<const volatile char*>(std::addressof(value)));
+}
+
+// Runs `body` on `threadCount` threads released together, the timing includes starting them.
+template<typename BodyType>
+void run_threads(size_t threadCount, BodyType&& body)
+{
+    std::barrier start(static_cast<std::ptrdiff_t>(threadCount));
+    std::vector<std::jthread> threads;
+    threads.reserve(threadCount);
+    for(size_t threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+    {
+        threads.emplace_back([&, threadIndex]{
+            start.arrive_and_wait();
+            body(threadIndex);
+        });
+    }
+}
+
+// Powers of two up to the hardware thread count.
+inline std::vector<size_t> benchmark_thread_counts()
+{
+    const auto maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<size_t> threadCounts;
+    for(size_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+        threadCounts.push_back(threadCount);
+    return threadCounts;
+}
+
+void run_scoped_ptr_benchmarks();
+void run_refcount_benchmarks();
+void run_epoch_benchmarks();
+void run_buffer_benchmarks();
+void run_mesh_benchmarks();
+
+// Checks of behaviour the benchmarks rely on; each reports what differs and returns true if nothing does.
+bool verify_scoped_ptrs();
+// Compares every vector kernel with the scalar one.
+bool verify_buffer_kernels();
@@ -0,0 +1,238 @@
+#include <benchmark.hpp>
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <random>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <core/buffer_kernels.hpp>
+
+namespace
+{
+    // Larger than the last-level cache, so the kernels stream from memory.
+    constexpr size_t elementCount = 1 << 24;
+
+    core::buffer random_buffer(core::data_type type)
+    {
+        core::buffer values(core::float32, elementCount);
+        std::mt19937 random(3);
+        std::uniform_real_distribution<float> distribution(-1000.0f, 1000.0f);
+        for(auto& value : values.elements<float>())
+            value = distribution(random);
+
+        if(type == core::float32)
+            return values;
+
+        core::buffer converted(type, elementCount);
+        core::convert(values, converted);
+        return converted;
+    }
+
+    std::string_view level_name(core::simd_level level)
+    {
+        switch(level)
+        {
+        case core::simd_level::scalar:
+            return "scalar";
+        case core::simd_level::avx2:
+            return "avx2";
+        case core::simd_level::avx512:
+            return "avx512";
+        }
+        return "unknown";
+    }
+
+    // Not a multiple of any vector width, so every kernel also runs its tail.
+    constexpr size_t verifyElementCount = 4099;
+
+    // Values on every edge of the conversion rule: specials, the limits of each type and their
+    // neighbours, ties for float16 rounding, then random values over many magnitudes.
+    core::buffer edge_values()
+    {
+        core::buffer values(core::float64, verifyElementCount);
+        auto elements = values.elements<double>();
+
+        std::vector<double> edges{
+            0.0, -0.0, 0.5, -0.5, 1.5, -1.5, 2.5, -2.5, 0.999, -0.999,
+            std::numeric_limits<double>::quiet_NaN(), -std::numeric_limits<double>::quiet_NaN(),
+            std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(),
+            65504.0, 65519.0, 65520.0, -65520.0, 5.960464477539063e-8, 2.9802322387695312e-8, 1e-40, 1e40,
+            2049.0, 2051.0, 16777217.0, 1.0000001
+        };
+        for(auto type = core::uint8; type <= core::int64; type = static_cast<core::data_type>(type + 1))
+        {
+            core::visit_data_type(type, [&]<typename T>(std::type_identity<T>){
+                if constexpr(std::is_integral_v<T>)
+                {
+                    for(const auto limit : {static_cast<double>(std::numeric_limits<T>::min()), static_cast<double>(std::numeric_limits<T>::max())})
+                    {
+                        for(const auto offset : {-1.0, -0.5, 0.0, 0.5, 1.0})
+                            edges.push_back(limit + offset);
+                    }
+                }
+            });
+        }
+
+        std::mt19937 random(5);
+        std::uniform_real_distribution<double> mantissa(-2.0, 2.0);
+        std::uniform_int_distribution<int> exponent(-30, 70);
+        for(size_t index = 0; index < elements.size(); ++index)
+            elements[index] = index < edges.size() ? edges[index] : std::ldexp(mantissa(random), exponent(random));
+        return values;
+    }
+
+    bool same_elements(std::string_view name, core::simd_level level, const core::buffer& expected, const core::buffer& actual)
+    {
+        const auto elementSize = core::data_type_size(expected.type());
+        size_t mismatches = 0;
+        size_t first = 0;
+        for(size_t index = 0; index < expected.size(); ++index)
+        {
+            if(std::memcmp(expected.data() + index * elementSize, actual.data() + index * elementSize, elementSize) == 0)
+                continue;
+            if(mismatches++ == 0)
+                first = index;
+        }
+
+        if(mismatches != 0)
+            std::print("  {} {}: {} elements differ from scalar, first at {}\n", name, level_name(level), mismatches, first);
+        return mismatches == 0;
+    }
+
+    // Vector sums add in another order, so they only agree within rounding.
+    bool same_sum(double expected, double actual, double magnitude)
+    {
+        if(std::isnan(expected) || std::isnan(actual))
+            return std::isnan(expected) && std::isnan(actual);
+        if(std::isinf(expected) || std::isinf(actual))
+            return expected == actual;
+        return std::abs(expected - actual) <= 1e-5 * magnitude;
+    }
+}
+
+void run_buffer_benchmarks()
+{
+    constexpr std::array<std::pair<core::data_type, core::data_type>, 6> conversions{{
+        {core::float16, core::float32},
+        {core::float32, core::float16},
+        {core::uint8, core::float32},
+        {core::float32, core::uint16},
+        {core::float32, core::float64},
+        {core::int16, core::float16},
+    }};
+
+    std::print("buffer kernels ({} elements, supported: {})\n", elementCount, level_name(core::supported_simd_level()));
+    for(auto level = core::simd_level::scalar; level <= core::supported_simd_level(); level = static_cast<core::simd_level>(static_cast<int>(level) + 1))
+    {
+        core::limit_simd_level(level);
+        std::print(" {}\n", level_name(level));
+
+        for(const auto& [sourceType, destinationType] : conversions)
+        {
+            const auto source = random_buffer(sourceType);
+            core::buffer destination(destinationType, elementCount);
+            measure(std::format("convert {} -> {}", core::data_type_name(sourceType), core::data_type_name(destinationType)), elementCount, [&]{
+                core::convert(source, destination);
+            });
+        }
+
+        auto values = random_buffer(core::float32);
+        measure("scale float32", elementCount, [&]{ core::scale(values, 1.0001); });
+        measure("bounds float32", elementCount, [&]{ do_not_optimize(core::bounds(values)); });
+        measure("sum float32", elementCount, [&]{ do_not_optimize(core::sum(values)); });
+
+        auto halves = random_buffer(core::float16);
+        measure("sum float16", elementCount, [&]{ do_not_optimize(core::sum(halves)); });
+    }
+    core::limit_simd_level(core::simd_level::avx512);
+}
+
+bool verify_buffer_kernels()
+{
+    constexpr auto typeCount = static_cast<size_t>(core::float64) + 1;
+    const auto edges = edge_values();
+
+    std::array<core::buffer, typeCount> sources;
+    core::limit_simd_level(core::simd_level::scalar);
+    for(size_t type = 0; type < typeCount; ++type)
+    {
+        sources[type] = core::buffer(static_cast<core::data_type>(type), verifyElementCount);
+        core::convert(edges, sources[type]);
+    }
+
+    bool passed = true;
+    size_t checks = 0;
+    for(size_t sourceType = 0; sourceType < typeCount; ++sourceType)
+    {
+        const auto& source = sources[sourceType];
+        const auto sourceName = core::data_type_name(source.type());
+
+        for(size_t destinationType = 0; destinationType < typeCount; ++destinationType)
+        {
+            const auto type = static_cast<core::data_type>(destinationType);
+            const auto name = std::format("convert {} -> {}", sourceName, core::data_type_name(type));
+
+            // The second pass starts one element in, off the buffers' alignment.
+            core::limit_simd_level(core::simd_level::scalar);
+            core::buffer expected(type, verifyElementCount);
+            core::convert(source, expected);
+            core::convert(source.view(1, verifyElementCount - 1), expected.view(1, verifyElementCount - 1));
+
+            for(auto level = core::simd_level::avx2; level <= core::supported_simd_level(); level = static_cast<core::simd_level>(static_cast<int>(level) + 1))
+            {
+                core::limit_simd_level(level);
+                core::buffer actual(type, verifyElementCount);
+                core::convert(source, actual);
+                core::convert(source.view(1, verifyElementCount - 1), actual.view(1, verifyElementCount - 1));
+                passed &= same_elements(name, level, expected, actual);
+                ++checks;
+            }
+        }
+
+        core::limit_simd_level(core::simd_level::scalar);
+        auto expectedScaled = source;
+        core::scale(expectedScaled, 1.0001);
+        const auto expectedBounds = core::bounds(source);
+        const auto expectedSum = core::sum(source);
+
+        // Sums of the finite elements bound the rounding the vector order may add.
+        core::buffer wide(core::float64, verifyElementCount);
+        core::convert(source, wide);
+        double magnitude = 0.0;
+        for(const auto value : wide.elements<double>())
+            magnitude += std::isfinite(value) ? std::abs(value) : 0.0;
+
+        for(auto level = core::simd_level::avx2; level <= core::supported_simd_level(); level = static_cast<core::simd_level>(static_cast<int>(level) + 1))
+        {
+            core::limit_simd_level(level);
+            auto scaled = source;
+            core::scale(scaled, 1.0001);
+            passed &= same_elements(std::format("scale {}", sourceName), level, expectedScaled, scaled);
+
+            const auto bounds = core::bounds(source);
+            if(bounds != expectedBounds)
+            {
+                std::print("  bounds {} {}: differs from scalar\n", sourceName, level_name(level));
+                passed = false;
+            }
+
+            const auto sum = core::sum(source);
+            if(!same_sum(expectedSum, sum, magnitude))
+            {
+                std::print("  sum {} {}: {} differs from scalar {}\n", sourceName, level_name(level), sum, expectedSum);
+                passed = false;
+            }
+            checks += 3;
+        }
+    }
+    core::limit_simd_level(core::simd_level::avx512);
+
+    std::print("buffer kernels: {} checks against scalar up to {}, {}\n", checks, level_name(core::supported_simd_level()), passed ? "all equal" : "MISMATCHES");
+    return passed;
+}
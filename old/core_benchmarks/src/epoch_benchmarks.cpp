@@ -0,0 +1,81 @@
+#include <benchmark.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include <core/scoped_ptr.hpp>
+
+namespace
+{
+    constexpr size_t readsPerThread = 1 << 22;
+    constexpr size_t elementCount = 1 << 18;
+
+    struct payload
+    {
+        uint64_t value{1};
+    };
+
+    using epoch_source = scoped_source_ptr<payload, epoch_scoped_ptr_control_block>;
+    using epoch_weak = scoped_weak_ptr<payload, epoch_scoped_ptr_control_block>;
+
+    // Every reader keeps its own weak reference, as a cache of lookups would.
+    void read_locked(const epoch_source& source, size_t threadCount)
+    {
+        run_threads(threadCount, [&](size_t){
+            epoch_weak weak = source;
+            uint64_t sum = 0;
+            for(size_t read = 0; read < readsPerThread; ++read)
+            {
+                if(auto strong = weak.lock())
+                    sum += strong->value;
+            }
+            do_not_optimize(sum);
+        });
+    }
+
+    void read_guarded(const epoch_source& source, size_t threadCount)
+    {
+        run_threads(threadCount, [&](size_t){
+            epoch_weak weak = source;
+            uint64_t sum = 0;
+            for(size_t read = 0; read < readsPerThread; ++read)
+            {
+                epoch_guard guard;
+                if(auto* element = weak.peek())
+                    sum += element->value;
+            }
+            do_not_optimize(sum);
+        });
+    }
+
+    template<typename ControlBlockType>
+    void create_and_release()
+    {
+        for(size_t element = 0; element < elementCount; ++element)
+        {
+            auto source = make_scoped<payload, ControlBlockType>();
+            do_not_optimize(source->value);
+        }
+        epoch_reclamation::collect();
+    }
+}
+
+void run_epoch_benchmarks()
+{
+    // lock() increments and decrements the strong count every thread shares, a guarded peek only
+    // writes the reader's own epoch record.
+    std::print("epoch reclamation, one shared element ({} reads per thread)\n", readsPerThread);
+    for(const auto threadCount : benchmark_thread_counts())
+    {
+        std::print(" {} threads\n", threadCount);
+        auto source = make_scoped<payload, epoch_scoped_ptr_control_block>();
+        measure("weak lock()", readsPerThread, [&]{ read_locked(source, threadCount); });
+        measure("epoch_guard + peek()", readsPerThread, [&]{ read_guarded(source, threadCount); });
+    }
+
+    // The price of deferring destruction: retired blocks wait in the thread's list until the
+    // epoch has advanced twice.
+    std::print("epoch reclamation, create and release ({} elements)\n", elementCount);
+    measure("synchronized", elementCount, []{ create_and_release<synchronized_scoped_ptr_control_block>(); });
+    measure("epoch", elementCount, []{ create_and_release<epoch_scoped_ptr_control_block>(); });
+}
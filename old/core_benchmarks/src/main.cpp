@@ -0,0 +1,22 @@
+#include <benchmark.hpp>
+
+#include <string_view>
+
+// With --verify, runs the correctness checks instead of timing anything.
+int main(int argc, char** argv)
+{
+    if(argc > 1 && std::string_view(argv[1]) == "--verify")
+    {
+        const auto scopedPtrs = verify_scoped_ptrs();
+        const auto bufferKernels = verify_buffer_kernels();
+        return scopedPtrs && bufferKernels ? 0 : 1;
+    }
+
+    run_scoped_ptr_benchmarks();
+    run_refcount_benchmarks();
+    run_epoch_benchmarks();
+    run_buffer_benchmarks();
+    run_mesh_benchmarks();
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include <benchmark.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <random>
+#include <vector>
+
+#include <core/mesh_optimizer.hpp>
+
+namespace
+{
+    constexpr size_t rings = 256;
+    constexpr size_t segments = 512;
+
+    // Unindexed UV sphere with its triangles shuffled: every triangle has its own three vertices,
+    // as a mesh straight out of an exporter would, and no order helps the vertex cache.
+    core::mesh shuffled_sphere()
+    {
+        struct vertex
+        {
+            float position[3];
+            float uv[2];
+        };
+        const auto sphereVertex = [](size_t ring, size_t segment){
+            const auto theta = std::numbers::pi_v<float> * static_cast<float>(ring) / rings;
+            const auto phi = 2.0f * std::numbers::pi_v<float> * static_cast<float>(segment % segments) / segments;
+            return vertex{{std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)}, {static_cast<float>(segment) / segments, static_cast<float>(ring) / rings}};
+        };
+
+        std::vector<std::array<vertex, 3>> triangles;
+        for(size_t ring = 0; ring < rings; ++ring)
+        {
+            for(size_t segment = 0; segment < segments; ++segment)
+            {
+                const auto a = sphereVertex(ring, segment);
+                const auto b = sphereVertex(ring, segment + 1);
+                const auto c = sphereVertex(ring + 1, segment);
+                const auto d = sphereVertex(ring + 1, segment + 1);
+                triangles.push_back({a, c, b});
+                triangles.push_back({b, c, d});
+            }
+        }
+        std::ranges::shuffle(triangles, std::mt19937(5));
+
+        core::mesh result(triangles.size() * 3);
+        auto positions = result.addStream("position", core::float32, 3).elements<float>();
+        auto uvs = result.addStream("uv", core::float16, 2).elements<core::half>();
+        std::vector<uint32_t> indices(triangles.size() * 3);
+        for(size_t corner = 0; corner < indices.size(); ++corner)
+        {
+            const auto& source = triangles[corner / 3][corner % 3];
+            std::copy_n(source.position, 3, positions.begin() + corner * 3);
+            uvs[corner * 2] = core::to_half(source.uv[0]);
+            uvs[corner * 2 + 1] = core::to_half(source.uv[1]);
+            indices[corner] = static_cast<uint32_t>(corner);
+        }
+        result.setIndices(indices);
+        return result;
+    }
+
+    void print_statistics(std::string_view name, const core::mesh& geometry)
+    {
+        const auto statistics = core::analyze_vertex_cache(geometry);
+        std::print("  {:<48} {:>10} vertices, acmr {:.3f}, atvr {:.3f}\n", name, geometry.vertexCount(), statistics.acmr, statistics.atvr);
+    }
+}
+
+void run_mesh_benchmarks()
+{
+    const auto input = shuffled_sphere();
+    auto deduplicated = input;
+    core::deduplicate_vertices(deduplicated);
+    auto cacheOrdered = deduplicated;
+    core::optimize_vertex_cache(cacheOrdered);
+    auto overdrawOrdered = cacheOrdered;
+    core::optimize_overdraw(overdrawOrdered);
+    auto optimized = overdrawOrdered;
+    core::optimize_vertex_fetch(optimized);
+
+    std::print("mesh optimizer ({} triangles, 16 entry FIFO cache)\n", input.triangleCount());
+    print_statistics("input", input);
+    print_statistics("deduplicated", deduplicated);
+    print_statistics("vertex cache", cacheOrdered);
+    print_statistics("overdraw", overdrawOrdered);
+    print_statistics("vertex fetch", optimized);
+
+    // Each run copies its input first, which the per-triangle times include.
+    const auto triangleCount = input.triangleCount();
+    measure("deduplicate_vertices", triangleCount, [&]{ auto geometry = input; core::deduplicate_vertices(geometry); });
+    measure("optimize_vertex_cache", triangleCount, [&]{ auto geometry = deduplicated; core::optimize_vertex_cache(geometry); });
+    measure("optimize_overdraw", triangleCount, [&]{ auto geometry = cacheOrdered; core::optimize_overdraw(geometry); });
+    measure("optimize_vertex_fetch", triangleCount, [&]{ auto geometry = overdrawOrdered; core::optimize_vertex_fetch(geometry); });
+    measure("optimize_mesh", triangleCount, [&]{ auto geometry = input; core::optimize_mesh(geometry); });
+}
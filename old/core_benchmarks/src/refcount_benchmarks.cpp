@@ -0,0 +1,95 @@
+#include <benchmark.hpp>
+
+#include <algorithm>
+#include <format>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <core/scoped_ptr.hpp>
+
+namespace
+{
+    constexpr size_t operationsPerThread = 1 << 22;
+
+    struct payload
+    {
+        uint64_t value{1};
+    };
+
+    template<typename ControlBlockType>
+    void copy_scoped(const scoped_source_ptr<payload, ControlBlockType>& source)
+    {
+        uint64_t sum = 0;
+        for(size_t operation = 0; operation < operationsPerThread; ++operation)
+        {
+            scoped_ptr<payload, ControlBlockType> strong = source;
+            sum += strong->value;
+        }
+        do_not_optimize(sum);
+    }
+
+    void copy_shared(const std::shared_ptr<payload>& source)
+    {
+        uint64_t sum = 0;
+        for(size_t operation = 0; operation < operationsPerThread; ++operation)
+        {
+            auto strong = source;
+            sum += strong->value;
+        }
+        do_not_optimize(sum);
+    }
+
+    // Every thread references an element it created itself, as systems iterating their own components do.
+    template<typename ControlBlockType>
+    void confined_scoped(size_t threadCount)
+    {
+        run_threads(threadCount, [](size_t){
+            auto source = make_scoped<payload, ControlBlockType>();
+            copy_scoped(source);
+        });
+    }
+
+    void confined_shared(size_t threadCount)
+    {
+        run_threads(threadCount, [](size_t){
+            auto source = std::make_shared<payload>();
+            copy_shared(source);
+        });
+    }
+}
+
+void run_refcount_benchmarks()
+{
+    const auto threadCounts = benchmark_thread_counts();
+
+    std::print("reference counting, thread-confined elements ({} copies per thread)\n", operationsPerThread);
+    for(const auto threadCount : threadCounts)
+    {
+        std::print(" {} threads\n", threadCount);
+        measure("unsynchronized", operationsPerThread, [&]{ confined_scoped<unsynchronized_scoped_ptr_control_block>(threadCount); });
+        measure("biased", operationsPerThread, [&]{ confined_scoped<biased_scoped_ptr_control_block>(threadCount); });
+        measure("synchronized", operationsPerThread, [&]{ confined_scoped<synchronized_scoped_ptr_control_block>(threadCount); });
+        measure("std::shared_ptr", operationsPerThread, [&]{ confined_shared(threadCount); });
+    }
+
+    // One element created by the main thread and referenced by all; the biased block pays for
+    // atomics on every thread but its owner. Not meaningful for the unsynchronized block.
+    std::print("reference counting, one shared element ({} copies per thread)\n", operationsPerThread);
+    for(const auto threadCount : threadCounts)
+    {
+        std::print(" {} threads\n", threadCount);
+        {
+            auto source = make_scoped<payload, biased_scoped_ptr_control_block>();
+            measure("biased", operationsPerThread, [&]{ run_threads(threadCount, [&](size_t){ copy_scoped(source); }); });
+        }
+        {
+            auto source = make_scoped<payload, synchronized_scoped_ptr_control_block>();
+            measure("synchronized", operationsPerThread, [&]{ run_threads(threadCount, [&](size_t){ copy_scoped(source); }); });
+        }
+        {
+            auto source = std::make_shared<payload>();
+            measure("std::shared_ptr", operationsPerThread, [&]{ run_threads(threadCount, [&](size_t){ copy_shared(source); }); });
+        }
+    }
+}
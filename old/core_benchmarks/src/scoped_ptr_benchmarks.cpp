@@ -0,0 +1,195 @@
+#include <benchmark.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
+#include <numeric>
+#include <random>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <core/scoped_ptr.hpp>
+
+namespace
+{
+    constexpr size_t elementCount = 1 << 20;
+
+    struct payload
+    {
+        uint64_t value;
+        uint64_t padding[3];
+
+        explicit payload(uint64_t initial) noexcept
+            : value(initial)
+        {}
+    };
+
+    // Interleaves unrelated allocations so that consecutive elements are not neighbours in memory.
+    template<typename FactoryType>
+    std::vector<scoped_source_ptr<payload>> scatter(FactoryType&& factory)
+    {
+        std::vector<scoped_source_ptr<payload>> pointers;
+        std::vector<std::unique_ptr<char[]>> noise;
+        pointers.reserve(elementCount);
+        noise.reserve(elementCount);
+
+        std::mt19937_64 random(42);
+        for(size_t index = 0; index < elementCount; ++index)
+        {
+            pointers.push_back(factory(index));
+            noise.push_back(std::make_unique<char[]>(16 + random() % 96));
+        }
+
+        return pointers;
+    }
+
+    // Adopts freshly allocated elements and releases them again, the control block is the only
+    // allocation that differs between the variants.
+    template<typename ControlBlockType>
+    void adopt_and_release(size_t threadCount)
+    {
+        run_threads(threadCount, [](size_t){
+            for(size_t index = 0; index < elementCount; ++index)
+            {
+                scoped_source_ptr<payload, ControlBlockType> pointer(new payload(index));
+                do_not_optimize(pointer);
+            }
+        });
+    }
+
+    // Locks every element through its control block in random order and reads it.
+    void access(std::vector<scoped_source_ptr<payload>>& pointers, const std::vector<uint32_t>& order)
+    {
+        uint64_t sum = 0;
+        for(const auto index : order)
+        {
+            scoped_ptr<payload> strong = pointers[index];
+            sum += strong->value;
+        }
+        do_not_optimize(sum);
+    }
+}
+
+void run_scoped_ptr_benchmarks()
+{
+    std::print("scoped_ptr ({} elements)\n", elementCount);
+
+    measure("create and destroy, separate control block", elementCount, []{
+        for(size_t index = 0; index < elementCount; ++index)
+        {
+            scoped_source_ptr<payload> pointer(new payload(index));
+            do_not_optimize(pointer);
+        }
+    });
+    measure("create and destroy, pooled separate control block", elementCount, []{
+        for(size_t index = 0; index < elementCount; ++index)
+        {
+            scoped_source_ptr<payload, pooled_scoped_ptr_control_block<>> pointer(new payload(index));
+            do_not_optimize(pointer);
+        }
+    });
+    measure("create and destroy, make_scoped", elementCount, []{
+        for(size_t index = 0; index < elementCount; ++index)
+        {
+            auto pointer = make_scoped<payload>(index);
+            do_not_optimize(pointer);
+        }
+    });
+    measure("create and destroy, allocate_scoped pool", elementCount, []{
+        std::pmr::unsynchronized_pool_resource pool;
+        for(size_t index = 0; index < elementCount; ++index)
+        {
+            auto pointer = allocate_scoped<payload>(std::pmr::polymorphic_allocator<payload>(&pool), index);
+            do_not_optimize(pointer);
+        }
+    });
+
+    for(const auto threadCount : benchmark_thread_counts())
+    {
+        std::print(" adopt and release, {} threads\n", threadCount);
+        measure("heap control blocks", elementCount, [&]{ adopt_and_release<synchronized_scoped_ptr_control_block>(threadCount); });
+        measure("pooled control blocks", elementCount, [&]{ adopt_and_release<pooled_scoped_ptr_control_block<>>(threadCount); });
+    }
+
+    std::vector<uint32_t> order(elementCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), std::mt19937_64(7));
+
+    {
+        auto pointers = scatter([](size_t index){ return scoped_source_ptr<payload>(new payload(index)); });
+        measure("lock and read, separate control block", elementCount, [&]{ access(pointers, order); });
+    }
+    {
+        auto pointers = scatter([](size_t index){ return make_scoped<payload>(index); });
+        measure("lock and read, make_scoped", elementCount, [&]{ access(pointers, order); });
+    }
+}
+
+namespace
+{
+    std::atomic<size_t> liveCounted{0};
+
+    struct counted
+    {
+        counted() noexcept { liveCounted.fetch_add(1, std::memory_order_relaxed); }
+        ~counted() { liveCounted.fetch_sub(1, std::memory_order_relaxed); }
+    };
+
+    using biased_source = scoped_source_ptr<counted, biased_scoped_ptr_control_block>;
+    using biased_weak = scoped_weak_ptr<counted, biased_scoped_ptr_control_block>;
+
+    bool check(std::string_view name, bool passed)
+    {
+        if(!passed)
+            std::print("  {}: failed\n", name);
+        return passed;
+    }
+
+    // Releasing a reference the owner handed to another thread there queues the block.
+    void release_elsewhere(auto&& pointer)
+    {
+        std::thread([moved = std::move(pointer)]() mutable { moved.reset(); }).join();
+    }
+
+    bool lock_elsewhere(biased_weak& weak)
+    {
+        bool locked = false;
+        std::thread([&]{ locked = static_cast<bool>(weak.lock()); }).join();
+        return locked;
+    }
+}
+
+bool verify_scoped_ptrs()
+{
+    bool passed = true;
+
+    // Queued while the source is still held: lock() must succeed on every thread.
+    {
+        biased_source source(new counted);
+        biased_weak weak = source;
+        release_elsewhere(weak.lock());
+        passed &= check("queued live block, use count", source.useCount() == 1);
+        passed &= check("queued live block, lock on another thread", lock_elsewhere(weak));
+        passed &= check("queued live block, lock on the owner", static_cast<bool>(weak.lock()));
+        collect_biased_scoped_ptrs();
+        passed &= check("queued live block, lock after the merge", lock_elsewhere(weak));
+    }
+    collect_biased_scoped_ptrs();
+    passed &= check("queued live block, destroyed with its source", liveCounted.load() == 0);
+
+    // Queued after its last reference went away on another thread: lock() must fail everywhere.
+    {
+        biased_source source(new counted);
+        biased_weak weak = source;
+        release_elsewhere(std::move(source));
+        passed &= check("queued dead block, lock on another thread", !lock_elsewhere(weak));
+        passed &= check("queued dead block, lock on the owner", !weak.lock());
+        collect_biased_scoped_ptrs();
+        passed &= check("queued dead block, destroyed by the merge", liveCounted.load() == 0);
+    }
+
+    std::print("scoped_ptr: biased weak locks {}\n", passed ? "behave" : "MISBEHAVE");
+    return passed;
+}